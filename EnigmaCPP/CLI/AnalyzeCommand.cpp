@@ -0,0 +1,186 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "AnalyzeCommand.h"
+#include "Encrypter.h"
+#include "include/MappedFile.h"
+#include "include/ThreadPool.h"
+#include "include/TextStatistics.h"
+
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+
+#include <sys/mman.h>
+
+using namespace EnigmaCLI;
+
+namespace
+{
+    /* Bytes of a file given to both statistics in turn, so the second pass reads them from cache. */
+    const size_t chunkSize = 1 << 20;
+
+    /* Most frequent spacings of repeated trigrams listed for a file. */
+    const size_t listedSpacings = 10;
+
+    /* Statistics of one file. */
+    struct FileResult
+    {
+        Enigma::TextStatistics Stats;
+        std::string Error;
+        double Seconds = 0;
+        uint64_t Repeats = 0;
+        std::vector<std::pair<uint32_t, uint64_t>> Spacings;
+        std::vector<uint64_t> Periods;
+    };
+
+    /* Writes bytes, letters, IoC and letter counts as JSON members. */
+    void WriteStats(std::ostringstream& json, const Enigma::TextStatistics& stats)
+    {
+        char ioc[32];
+        std::snprintf(ioc, sizeof(ioc), "%.6f", stats.IndexOfCoincidence());
+        json << "\"bytes\": " << stats.getBytes() << ", \"letters\": " << stats.getLetters() << ", \"ioc\": " << ioc << ", \"counts\": [";
+        for (int letter = 0; letter < Enigma::TextStatistics::alphabetLength; letter++)
+            json << (letter ? ", " : "") << stats.getCount(letter);
+        json << ']';
+    }
+
+    /* Writes repeated trigrams, their most frequent spacings and counts of periods 2 - 26 as JSON members. */
+    void WriteRepeats(std::ostringstream& json, const FileResult& res)
+    {
+        json << "\"repeats\": " << res.Repeats << ", \"spacings\": [";
+        for (size_t i = 0; i < res.Spacings.size(); i++)
+            json << (i ? ", " : "") << '[' << res.Spacings[i].first << ", " << res.Spacings[i].second << ']';
+        json << "], \"periods\": [";
+        for (size_t i = 0; i < res.Periods.size(); i++)
+            json << (i ? ", " : "") << res.Periods[i];
+        json << ']';
+    }
+}
+
+std::vector<std::string> AnalyzeCommand::ListFiles(const std::vector<std::string>& paths)
+{
+    std::vector<std::string> files;
+    for (const std::string& path : paths)
+    {
+        if (!std::filesystem::exists(path))
+            throw std::runtime_error("File does not exist: " + path);
+        if (!std::filesystem::is_directory(path))
+        {
+            files.push_back(path);
+            continue;
+        }
+        std::vector<std::string> found;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(path, std::filesystem::directory_options::skip_permission_denied))
+            if (entry.is_regular_file())
+                found.push_back(entry.path().string());
+        std::sort(found.begin(), found.end());
+        files.insert(files.end(), found.begin(), found.end());
+    }
+    return files;
+}
+
+void AnalyzeCommand::Run(int argc, char *argv[])
+{
+    if (argc < 4)
+        throw std::runtime_error("Pass valid arguments.");
+    const std::string outputPath = argv[2];
+    const std::vector<std::string> files = ListFiles(std::vector<std::string>(argv + 3, argv + argc));
+    typedef std::chrono::steady_clock Clock;
+
+    // Biggest files first, so a big file does not start last while the other threads are idle.
+    std::vector<uintmax_t> sizes(files.size());
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        std::error_code error;
+        sizes[i] = std::filesystem::file_size(files[i], error);
+        if (error)
+            sizes[i] = 0;
+    }
+    std::vector<size_t> order(files.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    std::vector<FileResult> results(files.size());
+    Enigma::ThreadPool pool;
+    auto start = Clock::now();
+    pool.ParallelFor(order.size(), [&](size_t i) {
+        FileResult& res = results[order[i]];
+        auto fileStart = Clock::now();
+        try
+        {
+            Enigma::MappedFile file(files[order[i]]);
+            // The file is read once from start to end: more read-ahead, pages dropped behind.
+            if (file.getSize() != 0)
+                madvise(const_cast<char *>(file.getData()), file.getSize(), MADV_SEQUENTIAL);
+            Enigma::RepeatStatistics repeats;
+            for (size_t offset = 0; offset < file.getSize(); offset += chunkSize)
+            {
+                size_t size = std::min(chunkSize, file.getSize() - offset);
+                res.Stats.Add(file.getData() + offset, size);
+                repeats.Add(file.getData() + offset, size);
+            }
+            res.Repeats = repeats.getRepeats();
+            res.Spacings = repeats.TopSpacings(listedSpacings);
+            for (int period = 2; period <= Enigma::RepeatStatistics::maxPeriod; period++)
+                res.Periods.push_back(repeats.getPeriodCount(period));
+        }
+        catch (const std::exception &e)
+        {
+            res.Error = e.what();
+        }
+        res.Seconds = std::chrono::duration<double>(Clock::now() - fileStart).count();
+    });
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    Enigma::TextStatistics total;
+    size_t failed = 0;
+    for (const FileResult& res : results)
+    {
+        total.Merge(res.Stats);
+        failed += !res.Error.empty();
+    }
+    const double megabytes = (double)total.getBytes() / (1024 * 1024);
+
+    std::ostringstream json;
+    json << "{\n  \"threads\": " << pool.getSize() << ",\n  \"vectorWidth\": " << Enigma::TextStatistics::getVectorWidth()
+         << ",\n  \"seconds\": " << seconds << ",\n  \"megabytesPerSecond\": " << (seconds > 0 ? megabytes / seconds : 0)
+         << ",\n  \"total\": {\"files\": " << files.size() << ", \"failed\": " << failed << ", ";
+    WriteStats(json, total);
+    json << "},\n  \"files\": [";
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        json << (i ? ",\n" : "\n") << "    {\"path\": " << Encrypter::JsonString(files[i]) << ", ";
+        if (!results[i].Error.empty())
+            json << "\"error\": " << Encrypter::JsonString(results[i].Error) << '}';
+        else
+        {
+            json << "\"seconds\": " << results[i].Seconds << ", ";
+            WriteStats(json, results[i].Stats);
+            json << ", ";
+            WriteRepeats(json, results[i]);
+            json << '}';
+        }
+    }
+    json << "\n  ]\n}\n";
+
+    if (outputPath == "-")
+    {
+        std::cout << json.str();
+        return;
+    }
+    std::ofstream out(outputPath);
+    out << json.str();
+    if (!out.good())
+        throw std::runtime_error("Error while writing to a file.");
+    std::printf("Analyzed %zu files (%zu failed), %.1f MB in %.2f s (%.1f MB/s) on %d threads. Saved under name: %s\n", files.size(), failed,
+                megabytes, seconds, seconds > 0 ? megabytes / seconds : 0, pool.getSize(), outputPath.c_str());
+}
@@ -0,0 +1,44 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace EnigmaCLI
+{
+    /* Handles --analyze flag. Letter frequencies, index of coincidence and repeated trigrams of ciphertext files, as JSON. */
+    class AnalyzeCommand
+    {
+        /**
+         * Lists files to analyze: files as given, directories recursively, in name order.
+         *
+         * Params:
+         * const std::vector<std::string>& paths - files and directories.
+         *
+         * Exceptions:
+         * If a path does not exist, an exception will be thrown.
+         *
+         * Returns:
+         * std::vector<std::string> - paths of regular files.
+        */
+        static std::vector<std::string> ListFiles(const std::vector<std::string>& paths) noexcept(false);
+
+    public:
+        /**
+         * Analyzes files in parallel (--analyze [JSON output path or -] [file or directory path] (more paths)).
+         * Every file is mapped and read in one pass; a file which cannot be read is reported in the JSON with its error.
+         *
+         * Params:
+         * int argc - number of arguments.
+         * char *argv[] - arguments.
+         *
+         * Exceptions:
+         * If arguments are invalid, a path does not exist or the output cannot be written, an exception will be thrown.
+        */
+        static void Run(int argc, char *argv[]) noexcept(false);
+    };
+}
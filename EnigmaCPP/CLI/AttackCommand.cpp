@@ -0,0 +1,370 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "AttackCommand.h"
+#include "include/IocSearch.h"
+#include "include/PlugboardSolver.h"
+#include "include/Bombe.h"
+#include "include/CribDrag.h"
+#include "include/Zygalski.h"
+#include "include/DepthSearch.h"
+#include "include/KeyspaceSearch.h"
+#include "Encrypter.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <csignal>
+#include <iostream>
+#include <stdexcept>
+
+using namespace EnigmaCLI;
+
+namespace
+{
+    /* Set by SIGINT during --attack scan. */
+    std::atomic<bool> scanStop(false);
+
+    void StopScan(int) { scanStop = true; }
+}
+
+std::string AttackCommand::ReadCipherText(const char *filePath)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.good())
+        throw std::runtime_error("Error while reading file.");
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+void AttackCommand::PrintCandidate(int rank, const Enigma::KeyCandidate &candidate, const std::string &cipherText) noexcept
+{
+    static const char *rotorNames[] = {"I", "II", "III", "IV", "V"};
+    static const char *reflectorNames[] = {"ETW", "B", "C"};
+
+    Enigma::CompiledKey key(candidate.ToUserSettings());
+    Enigma::RotorPositions positions = candidate.Positions;
+    std::string preview = key.EncryptString(cipherText, positions).substr(0, previewLength);
+
+    std::printf("%3d. score %.5f  %s %s %s %s  %c%c%c  %c%c%c  %s\n", rank, candidate.Score,
+                reflectorNames[candidate.Reflector], rotorNames[candidate.Rotors[0]], rotorNames[candidate.Rotors[1]], rotorNames[candidate.Rotors[2]],
+                'A' + candidate.Positions[0], 'A' + candidate.Positions[1], 'A' + candidate.Positions[2],
+                'A' + candidate.Rings[0], 'A' + candidate.Rings[1], 'A' + candidate.Rings[2], preview.c_str());
+}
+
+Enigma::UserSettings AttackCommand::ParseSettings(int argc, char *argv[], int first)
+{
+    // Encrypter reads settings from the 4th argument on.
+    std::vector<char *> args = {argv[0], argv[1], argv[2]};
+    args.insert(args.end(), argv + first, argv + argc);
+    Encrypter parser((int)args.size(), args.data());
+    if (!parser.getSettings().CanBeConverted())
+        throw std::runtime_error("Invalid settings.");
+    return parser.getSettings();
+}
+
+void AttackCommand::RunPlugs(int argc, char *argv[], const std::string &cipherText, Enigma::ThreadPool &pool)
+{
+    if (argc < 5)
+        throw std::runtime_error("Pass valid arguments.");
+    auto begin = std::chrono::steady_clock::now();
+
+    // Either comma separated model files (EnigmaNgramTrain) or a corpus to train bigrams to quadgrams from.
+    std::vector<Enigma::NgramModel> models;
+    std::string paths = argv[4];
+    if (paths.size() > 5 && paths.compare(paths.size() - 5, 5, ".engm") == 0)
+    {
+        std::stringstream list(paths);
+        std::string path;
+        while (std::getline(list, path, ','))
+            models.push_back(Enigma::NgramModel::Load(path));
+    }
+    else
+    {
+        std::string corpus = ReadCipherText(argv[4]);
+        for (int order = 2; order <= 4; order++)
+            models.push_back(Enigma::NgramModel::Train(corpus, order));
+    }
+    std::vector<const Enigma::NgramModel *> stages;
+    for (const Enigma::NgramModel &model : models)
+        stages.push_back(&model);
+
+    // Rotors are either given or taken from the best candidates of the IoC search.
+    std::vector<Enigma::UserSettings> rotorSettings;
+    if (argc > 5)
+        rotorSettings.push_back(ParseSettings(argc, argv, 5));
+    else
+    {
+        Enigma::IocSearchResult res = Enigma::IocSearch::Run(cipherText, Enigma::IocSearchOptions(), pool);
+        std::printf("IoC search: %llu keys in %.2f s.\n", (unsigned long long)res.KeysTested, res.Seconds);
+        for (const Enigma::KeyCandidate &candidate : res.Candidates)
+            rotorSettings.push_back(candidate.ToUserSettings());
+    }
+
+    Enigma::PlugboardSolverOptions options;
+    std::unique_ptr<Enigma::PlugboardSolution> best;
+    size_t bestIndex = 0;
+    for (size_t i = 0; i < rotorSettings.size(); i++)
+    {
+        Enigma::PlugboardSolver solver(rotorSettings[i], cipherText);
+        Enigma::PlugboardSolution solution = solver.Solve(stages, options, pool);
+        if (!best || solution.Score > best->Score)
+        {
+            best.reset(new Enigma::PlugboardSolution(solution));
+            bestIndex = i;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    Enigma::UserSettings key = rotorSettings[bestIndex];
+    key.setPlugboard(best->getConnections());
+    Enigma::CompiledKey compiled(key);
+    Enigma::RotorPositions positions = Enigma::CompiledKey::PositionsOf(key);
+    std::string plainText = compiled.EncryptString(cipherText, positions);
+
+    static const char *rotorNames[] = {"I", "II", "III", "IV", "V"};
+    static const char *reflectorNames[] = {"ETW", "B", "C"};
+    std::printf("Solved in %.2f s, score %.1f.\nKey: %s", seconds, best->Score, reflectorNames[key.getReflectorID()]);
+    for (const Enigma::UserRotor &rotor : key.getRotors())
+        std::printf(" %s", rotorNames[rotor.getID()]);
+    for (const Enigma::UserRotor &rotor : key.getRotors())
+        std::printf(" %c", rotor.getPosition());
+    for (const Enigma::UserRotor &rotor : key.getRotors())
+        std::printf(" %c", rotor.getRing());
+    for (const std::string &connection : key.getPlugboardConnections())
+        std::printf(" %s", connection.c_str());
+    std::printf("\n%s\n", plainText.substr(0, previewLength * 2).c_str());
+}
+
+void AttackCommand::RunBombe(int argc, char *argv[], const std::string &cipherText, Enigma::ThreadPool &pool)
+{
+    if (argc < 5)
+        throw std::runtime_error("Pass valid arguments.");
+    std::vector<uint8_t> letters = Enigma::CompiledKey::ToIndices(cipherText);
+    std::string crib = argv[4];
+    Enigma::BombeOptions options;
+    options.CribOffset = argc > 5 ? std::stoi(argv[5]) : 0;
+    if (argc > 6)
+    {
+        if (std::string(argv[6]) != "rings")
+            throw std::runtime_error("Pass valid arguments.");
+        options.SearchRings = true;
+    }
+    size_t cribLength = Enigma::CompiledKey::ToIndices(crib).size();
+    if (options.CribOffset < 0 || options.CribOffset + cribLength > letters.size())
+        throw std::runtime_error("Crib does not fit in the ciphertext.");
+
+    std::string cribCipher;
+    for (size_t i = 0; i < cribLength; i++)
+        cribCipher += (char)('A' + letters[options.CribOffset + i]);
+    Enigma::BombeMenu menu(crib, cribCipher);
+    std::printf("Menu: %s\nCentral letter %c, %zu connections, %d loops.\n", menu.ToString().c_str(), 'A' + menu.getCentralLetter(),
+                menu.getEdges().size(), menu.getLoops());
+
+    Enigma::BombeResult res = Enigma::Bombe::Run(menu, options, pool);
+    std::printf("Tested %llu positions in %.2f s on %d threads, %.0f positions/s, %.1f stops/s.\n", (unsigned long long)res.PositionsTested,
+                res.Seconds, pool.getSize(), res.PositionsTested / res.Seconds, res.NumberOfStops / res.Seconds);
+    std::printf("Stops: %llu, pruning ratio %.9f.\n", (unsigned long long)res.NumberOfStops, 1.0 - (double)res.NumberOfStops / res.PositionsTested);
+
+    static const char *rotorNames[] = {"I", "II", "III", "IV", "V"};
+    static const char *reflectorNames[] = {"ETW", "B", "C"};
+    for (size_t i = 0; i < res.Stops.size(); i++)
+    {
+        const Enigma::BombeStop &stop = res.Stops[i];
+        Enigma::CompiledKey key(stop.Key.Reflector, stop.Key.Rotors, stop.Key.Rings, stop.Steckers.data());
+        Enigma::RotorPositions positions = stop.Key.Positions;
+        std::string preview = key.EncryptString(cipherText, positions).substr(0, previewLength);
+
+        std::string steckers;
+        for (int l = 0; l < Enigma::CompiledKey::alphabetLength; l++)
+            if (stop.Steckers[l] > l)
+                steckers += std::string(steckers.empty() ? "" : " ") + (char)('A' + l) + (char)('A' + stop.Steckers[l]);
+        std::printf("%3zu. %-8s crib %.2f  %s %s %s %s  %c%c%c %c%c%c  %s\n     steckers: %s\n", i + 1, stop.Verified ? "verified" : "rejected",
+                    stop.Key.Score, reflectorNames[stop.Key.Reflector], rotorNames[stop.Key.Rotors[0]], rotorNames[stop.Key.Rotors[1]],
+                    rotorNames[stop.Key.Rotors[2]], 'A' + stop.Key.Positions[0], 'A' + stop.Key.Positions[1], 'A' + stop.Key.Positions[2],
+                    'A' + stop.Key.Rings[0], 'A' + stop.Key.Rings[1], 'A' + stop.Key.Rings[2], preview.c_str(), steckers.c_str());
+    }
+}
+
+void AttackCommand::RunDrag(int argc, char *argv[], const std::string &cipherText, Enigma::ThreadPool &pool)
+{
+    if (argc < 5)
+        throw std::runtime_error("Pass valid arguments.");
+    std::vector<std::string> cribs(argv + 4, argv + argc);
+    Enigma::CribDragResult res = Enigma::CribDrag::Run(cipherText, cribs, pool);
+
+    std::printf("Dragged %zu cribs over %zu letters in %.3f s on %d threads (%d offsets per compare), %.0f offsets/s, %.1f MB/s per crib.\n",
+                cribs.size(), res.Length, res.Seconds, pool.getSize(), Enigma::CribDrag::getVectorWidth(), res.OffsetsTested / res.Seconds,
+                res.Length * cribs.size() / res.Seconds / 1e6);
+    const size_t listed = 20;
+    for (size_t c = 0; c < cribs.size(); c++)
+    {
+        size_t letters = Enigma::CompiledKey::ToIndices(cribs[c]).size();
+        size_t offsets = res.Length >= letters ? res.Length - letters + 1 : 0;
+        std::printf("%s: %llu of %zu offsets possible (%.4f, random text %.4f)", cribs[c].c_str(), (unsigned long long)res.Counts[c], offsets,
+                    offsets ? (double)res.Counts[c] / offsets : 0.0, std::pow(25.0 / 26.0, (double)letters));
+        std::vector<size_t> first = res.getOffsets(c, listed);
+        for (size_t i = 0; i < first.size(); i++)
+            std::printf("%s%zu", i ? " " : "\n    ", first[i]);
+        std::printf("%s\n", res.Counts[c] > listed ? " ..." : "");
+    }
+}
+
+void AttackCommand::RunZygalski(const std::string &headers, Enigma::ThreadPool &pool)
+{
+    std::vector<Enigma::ZygalskiIndicator> indicators;
+    std::istringstream lines(headers);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        std::istringstream words(line);
+        Enigma::ZygalskiIndicator indicator;
+        if (words >> indicator.Grundstellung >> indicator.Indicator)
+            indicators.push_back(indicator);
+    }
+
+    Enigma::ZygalskiOptions options;
+    Enigma::ZygalskiResult res = Enigma::ZygalskiSheets::Run(indicators, options, pool);
+    std::printf("%zu messages, %zu females, %llu sheets laid in %.2f s on %d threads. %llu surviving settings.\n", indicators.size(),
+                res.Females, (unsigned long long)res.SheetsApplied, res.Seconds, pool.getSize(), (unsigned long long)res.NumberOfSurvivors);
+
+    static const char *rotorNames[] = {"I", "II", "III", "IV", "V"};
+    static const char *reflectorNames[] = {"ETW", "B", "C"};
+    const size_t listed = 20;
+    for (size_t i = 0; i < res.Survivors.size() && i < listed; i++)
+    {
+        const Enigma::ZygalskiSurvivor &survivor = res.Survivors[i];
+        std::printf("%3zu. %-8s %s %s %s %s  rings %c%c%c\n", i + 1, survivor.Verified ? "verified" : "rejected", reflectorNames[survivor.Reflector],
+                    rotorNames[survivor.Rotors[0]], rotorNames[survivor.Rotors[1]], rotorNames[survivor.Rotors[2]], 'A' + survivor.Rings[0],
+                    'A' + survivor.Rings[1], 'A' + survivor.Rings[2]);
+    }
+    if (res.Survivors.size() > listed)
+        std::printf("... and %zu more.\n", res.Survivors.size() - listed);
+}
+
+void AttackCommand::RunDepth(int argc, char *argv[], const std::string &messages, Enigma::ThreadPool &pool)
+{
+    std::vector<std::string> texts;
+    std::istringstream lines(messages);
+    std::string line;
+    while (std::getline(lines, line))
+        if (line.find_first_not_of(" \t\r") != std::string::npos)
+            texts.push_back(line);
+
+    Enigma::DepthSearchOptions options;
+    if (argc > 4)
+        options.MaxOffset = std::stoi(argv[4]);
+    if (argc > 5)
+        options.TopK = std::stoul(argv[5]);
+    Enigma::DepthSearchResult res = Enigma::DepthSearch::Run(texts, options, pool);
+
+    std::printf("%zu messages, %llu pairs at %d offsets in %.2f s on %d threads, %.1f M pairs/s, %.2f G letters/s.\n", texts.size(),
+                (unsigned long long)res.PairsCompared, 2 * options.MaxOffset + 1, res.Seconds, pool.getSize(),
+                res.PairsCompared / res.Seconds / 1e6, res.LettersCompared / res.Seconds / 1e9);
+    // Score is -log10 of the chance of a single test, the expected number of such pairs among all tests tells if it is significant.
+    std::printf("   score  expected  first second offset overlap coincidences\n");
+    for (const Enigma::DepthCandidate &candidate : res.Candidates)
+        std::printf("%8.2f %9.2g %6zu %6zu %6d %7zu %7zu (%.3f)\n", candidate.Score, res.OffsetsCompared * std::pow(10.0, -candidate.Score),
+                    candidate.First + 1, candidate.Second + 1, candidate.Offset, candidate.Overlap, candidate.Coincidences,
+                    (double)candidate.Coincidences / candidate.Overlap);
+}
+
+void AttackCommand::RunScan(int argc, char *argv[], const std::string &cipherText, Enigma::ThreadPool &pool)
+{
+    if (argc < 5)
+        throw std::runtime_error("Pass valid arguments.");
+    Enigma::KeyspaceOptions dims;
+    if (argc > 6 && std::string(argv[6]) == "rings")
+        dims.Rings[1] = dims.Rings[2] = Enigma::KeyspaceOptions::AllLetters();
+    Enigma::Keyspace space(dims);
+
+    Enigma::KeyspaceSearchOptions options;
+    options.CheckpointPath = argv[4];
+    if (argc > 5)
+        options.TopK = std::stoul(argv[5]);
+    options.Stop = &scanStop;
+    std::signal(SIGINT, StopScan);
+
+    std::cout << "Searching " << space.size() << " keys on " << pool.getSize() << " threads, checkpoint " << options.CheckpointPath
+              << ". Send SIGINT to stop, run again to resume..." << std::endl;
+    Enigma::KeyspaceSearchResult res = Enigma::KeyspaceSearch::Run(space, cipherText, options, pool);
+    std::signal(SIGINT, SIG_DFL);
+
+    std::printf("%s %llu keys in %.2f s, %.0f keys/s. Done %llu / %llu keys (%.2f%%).\n", res.Resumed ? "Resumed, tested" : "Tested",
+                (unsigned long long)res.KeysTested, res.Seconds, res.KeysTested / res.Seconds, (unsigned long long)res.KeysDone,
+                (unsigned long long)res.KeysTotal, 100.0 * res.KeysDone / res.KeysTotal);
+    std::printf("Wrote %llu checkpoints in %.3f s.\n", (unsigned long long)res.Checkpoints, res.CheckpointSeconds);
+    std::printf(res.Complete ? "Search complete.\n" : "Search stopped, best candidates so far:\n");
+    std::printf("     score    reflector rotors  start rings decryption\n");
+    for (size_t i = 0; i < res.Candidates.size(); i++)
+    {
+        Enigma::KeyspaceKey key = space.Unrank(res.Candidates[i].Index);
+        Enigma::KeyCandidate candidate;
+        candidate.Score = res.Candidates[i].Score;
+        candidate.Reflector = key.Reflector;
+        candidate.Rotors = key.Rotors;
+        candidate.Rings = key.Rings;
+        candidate.Positions = key.Positions;
+        PrintCandidate((int)i + 1, candidate, cipherText);
+    }
+}
+
+void AttackCommand::Run(int argc, char *argv[])
+{
+    if (argc < 4)
+        throw std::runtime_error("Pass valid arguments.");
+    std::string method = argv[2];
+    std::string cipherText = ReadCipherText(argv[3]);
+    Enigma::ThreadPool pool;
+
+    if (method == "ioc")
+    {
+        Enigma::IocSearchOptions options;
+        if (argc > 4)
+            options.TopK = std::stoul(argv[4]);
+        for (int i = 5; i < argc; i++)
+        {
+            std::string flag = argv[i];
+            if (flag == "rings")
+                options.SearchRings = true;
+            else if (flag == "noabort")
+                options.AbortDeviations = 0;
+            else
+                throw std::runtime_error("Pass valid arguments.");
+        }
+
+        std::cout << "Searching 2 reflectors x 60 wheel orders x 17576 start positions" << (options.SearchRings ? " x ring classes" : "")
+                  << " on " << pool.getSize() << " threads..." << std::endl;
+        Enigma::IocSearchResult res = Enigma::IocSearch::Run(cipherText, options, pool);
+
+        std::printf("Tested %llu keys (%llu aborted early) in %.2f s, %.0f keys/s.\n", (unsigned long long)res.KeysTested,
+                    (unsigned long long)res.KeysAborted, res.Seconds, res.KeysTested / res.Seconds);
+        if (options.SearchRings)
+            std::printf("Covered %llu keys with all ring settings, %.1fx fewer tested.\n", (unsigned long long)res.KeysCovered,
+                        (double)res.KeysCovered / res.KeysTested);
+        std::printf("     score    reflector rotors  start rings decryption\n");
+        for (size_t i = 0; i < res.Candidates.size(); i++)
+            PrintCandidate((int)i + 1, res.Candidates[i], cipherText);
+    }
+    else if (method == "plugs")
+        RunPlugs(argc, argv, cipherText, pool);
+    else if (method == "bombe")
+        RunBombe(argc, argv, cipherText, pool);
+    else if (method == "drag")
+        RunDrag(argc, argv, cipherText, pool);
+    else if (method == "zygalski")
+        RunZygalski(cipherText, pool);
+    else if (method == "depth")
+        RunDepth(argc, argv, cipherText, pool);
+    else if (method == "scan")
+        RunScan(argc, argv, cipherText, pool);
+    else
+        throw std::runtime_error("Unknown attack method.");
+}
@@ -0,0 +1,140 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include <string>
+
+#include "include/CandidateHeap.h"
+#include "include/ThreadPool.h"
+
+namespace EnigmaCLI
+{
+    /* Handles --attack flag. Key recovery from ciphertext. */
+    class AttackCommand
+    {
+        /* Number of letters of a decryption shown for every candidate. */
+        static const size_t previewLength = 40;
+
+    public:
+        /**
+         * Reads the whole ciphertext file.
+         *
+         * Params:
+         * const char* filePath - file path.
+         *
+         * Exceptions:
+         * If the file cannot be read, an exception will be thrown.
+         *
+         * Returns:
+         * std::string - content of the file.
+        */
+        static std::string ReadCipherText(const char* filePath) noexcept(false);
+
+        /**
+         * Prints a candidate with the beginning of its decryption.
+         *
+         * Params:
+         * int rank - rank of the candidate, from 1.
+         * const Enigma::KeyCandidate& candidate - candidate.
+         * const std::string& cipherText - ciphertext.
+        */
+        static void PrintCandidate(int rank, const Enigma::KeyCandidate& candidate, const std::string& cipherText) noexcept;
+
+    private:
+        /**
+         * Parses key settings given after other arguments, same form as for -e.
+         *
+         * Params:
+         * int argc - number of arguments.
+         * char *argv[] - arguments.
+         * int first - index of the reflector argument.
+         *
+         * Exceptions:
+         * If settings are invalid, an exception will be thrown.
+         *
+         * Returns:
+         * Enigma::UserSettings - parsed settings.
+        */
+        static Enigma::UserSettings ParseSettings(int argc, char *argv[], int first) noexcept(false);
+
+        /**
+         * Recovers the plugboard, for given rotors or for the best candidates of the IoC search.
+         *
+         * Params:
+         * int argc - number of arguments.
+         * char *argv[] - arguments: --attack plugs [ciphertext path] [corpus path or model files] (settings).
+         * const std::string& cipherText - ciphertext.
+         * Enigma::ThreadPool& pool - threads.
+        */
+        static void RunPlugs(int argc, char *argv[], const std::string& cipherText, Enigma::ThreadPool& pool) noexcept(false);
+
+        /**
+         * Runs the bombe on a crib placed in the ciphertext.
+         *
+         * Params:
+         * int argc - number of arguments.
+         * char *argv[] - arguments: --attack bombe [ciphertext path] [crib] (crib offset).
+         * const std::string& cipherText - ciphertext.
+         * Enigma::ThreadPool& pool - threads.
+        */
+        static void RunBombe(int argc, char *argv[], const std::string& cipherText, Enigma::ThreadPool& pool) noexcept(false);
+
+        /**
+         * Drags cribs over the ciphertext and prints offsets where they can be placed.
+         *
+         * Params:
+         * int argc - number of arguments.
+         * char *argv[] - arguments: --attack drag [ciphertext path] [crib] (more cribs).
+         * const std::string& cipherText - ciphertext.
+         * Enigma::ThreadPool& pool - threads.
+        */
+        static void RunDrag(int argc, char *argv[], const std::string& cipherText, Enigma::ThreadPool& pool) noexcept(false);
+
+        /**
+         * Runs Zygalski sheets over message headers, one "Grundstellung indicator" pair per line.
+         *
+         * Params:
+         * const std::string& headers - content of the file.
+         * Enigma::ThreadPool& pool - threads.
+        */
+        static void RunZygalski(const std::string& headers, Enigma::ThreadPool& pool) noexcept(false);
+
+        /**
+         * Finds pairs of messages in depth, one ciphertext per line.
+         *
+         * Params:
+         * int argc - number of arguments.
+         * char *argv[] - arguments: --attack depth [messages path] (max offset) (number of listed pairs).
+         * const std::string& messages - content of the file.
+         * Enigma::ThreadPool& pool - threads.
+        */
+        static void RunDepth(int argc, char *argv[], const std::string& messages, Enigma::ThreadPool& pool) noexcept(false);
+
+        /**
+         * Runs a resumable index of coincidence search with a checkpoint file, stopped by SIGINT.
+         *
+         * Params:
+         * int argc - number of arguments.
+         * char *argv[] - arguments: --attack scan [ciphertext path] [checkpoint path] (number of candidates) (rings).
+         * const std::string& cipherText - ciphertext.
+         * Enigma::ThreadPool& pool - threads.
+        */
+        static void RunScan(int argc, char *argv[], const std::string& cipherText, Enigma::ThreadPool& pool) noexcept(false);
+
+    public:
+        /**
+         * Runs an attack.
+         *
+         * Params:
+         * int argc - number of arguments.
+         * char *argv[] - arguments: --attack [method] [ciphertext path] (method options).
+         *
+         * Exceptions:
+         * If arguments are invalid or the ciphertext cannot be read, an exception will be thrown.
+        */
+        static void Run(int argc, char *argv[]) noexcept(false);
+    };
+}
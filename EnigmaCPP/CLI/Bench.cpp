@@ -0,0 +1,486 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+/**
+ * Benchmarks of the attack engines.
+ *
+ * bitslice  - checks that BitslicedEvaluator agrees with Encoder on random keys, then compares
+ *             keys/s of the bitsliced and the scalar (CompiledKey) known-plaintext test, single thread.
+ * placement - compares unpinned and pinned (compact, spread) thread pools, with the quadgram table shared
+ *             or replicated on every NUMA node, on n-gram scoring and on a keyspace scan.
+ * kernels   - candidate keys/s of every search kernel across ciphertext lengths and thread counts,
+ *             optionally written as JSON to track regressions between releases.
+*/
+
+#include "include/EnigmaCPP.h"
+#include "include/CompiledKey.h"
+#include "include/BitslicedEvaluator.h"
+#include "include/NgramModel.h"
+#include "include/ThreadPool.h"
+#include "include/NumaTopology.h"
+#include "include/KeyspaceSearch.h"
+#include "include/KeystreamTable.h"
+
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <fstream>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+
+typedef std::chrono::steady_clock Clock;
+
+/* Random key with 3 different rotors, reflector B or C and 10 plug board cables. */
+Enigma::UserSettings RandomKey(std::mt19937_64 &random)
+{
+    std::vector<int> rotors = {Enigma::I, Enigma::II, Enigma::III, Enigma::IV, Enigma::V};
+    std::shuffle(rotors.begin(), rotors.end(), random);
+    std::vector<Enigma::UserRotor> userRotors;
+    for (int i = 0; i < 3; i++)
+        userRotors.push_back(Enigma::UserRotor((Enigma::RotorID)rotors[i], (char)('A' + random() % 26), (char)('A' + random() % 26)));
+
+    std::string letters = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    std::shuffle(letters.begin(), letters.end(), random);
+    std::vector<std::string> plugs;
+    for (int i = 0; i < 10; i++)
+        plugs.push_back(letters.substr(2 * i, 2));
+    return Enigma::UserSettings(random() % 2 ? Enigma::B : Enigma::C, userRotors, plugs);
+}
+
+/* Scalar test of a key, stops at the first mismatch. */
+bool ScalarMatch(const Enigma::CompiledKey &key, Enigma::RotorPositions positions, const std::vector<uint8_t> &crib, const std::vector<uint8_t> &cipher)
+{
+    for (size_t i = 0; i < crib.size(); i++)
+        if (key.EncryptIndex(crib[i], positions) != cipher[i])
+            return false;
+    return true;
+}
+
+/* Returns keys/s of both tests over given keys, and number of matches. */
+void Measure(const char *name, const Enigma::BitslicedEvaluator &evaluator, const std::vector<Enigma::CompiledKey> &keys,
+             const std::vector<Enigma::RotorPositions> &positions, const std::vector<uint8_t> &crib, const std::vector<uint8_t> &cipher)
+{
+    const int lanes = Enigma::BitslicedEvaluator::getNumberOfLanes();
+    std::vector<uint64_t> mismatch(lanes / 64);
+    size_t bitslicedMatches = 0, scalarMatches = 0;
+
+    auto begin = Clock::now();
+    for (size_t k = 0; k < keys.size(); k += lanes)
+    {
+        size_t count = std::min(keys.size() - k, (size_t)lanes);
+        evaluator.Test(&keys[k], &positions[k], count, mismatch.data());
+        for (size_t l = 0; l < count; l++)
+            bitslicedMatches += !((mismatch[l / 64] >> (l % 64)) & 1);
+    }
+    double bitsliced = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    begin = Clock::now();
+    for (size_t k = 0; k < keys.size(); k++)
+        scalarMatches += ScalarMatch(keys[k], positions[k], crib, cipher);
+    double scalar = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    std::printf("%-22s %10zu %14.0f %14.0f %8.2f %9zu\n", name, keys.size(), keys.size() / bitsliced, keys.size() / scalar,
+                scalar / bitsliced, bitslicedMatches);
+    if (bitslicedMatches != scalarMatches)
+        throw std::runtime_error("Bitsliced and scalar tests disagree.");
+}
+
+void BenchBitslice(size_t numberOfKeys, size_t cribLength)
+{
+    std::mt19937_64 random(2023);
+    const int lanes = Enigma::BitslicedEvaluator::getNumberOfLanes();
+
+    std::string crib;
+    for (size_t i = 0; i < cribLength; i++)
+        crib += (char)('A' + random() % 26);
+    Enigma::UserSettings target = RandomKey(random);
+    std::string cipher = Enigma::Encoder(target).EncryptString(crib);
+    Enigma::BitslicedEvaluator evaluator(crib, cipher);
+    std::vector<uint8_t> cribIndices = Enigma::CompiledKey::ToIndices(crib), cipherIndices = Enigma::CompiledKey::ToIndices(cipher);
+
+    // Agreement with Encoder: random keys mixed with the target and its neighbours, some of which still match.
+    std::vector<Enigma::UserSettings> settings;
+    for (size_t i = 0; i < 20000; i++)
+    {
+        if (i % 4 != 0)
+        {
+            settings.push_back(RandomKey(random));
+            continue;
+        }
+        Enigma::UserSettings near = target;
+        std::vector<Enigma::UserRotor> rotors = near.getRotors();
+        int slot = random() % 3;
+        if (random() % 2)
+        {
+            // Shift of ring and position together keeps the wiring, only turnover timing may change.
+            int shift = 1 + random() % 25;
+            rotors[slot].setPosition((char)('A' + (rotors[slot].getPosition() - 'A' + shift) % 26));
+            rotors[slot].setRingSetting((char)('A' + (rotors[slot].getRing() - 'A' + shift) % 26));
+        }
+        else if (random() % 2)
+            rotors[slot].setPosition((char)('A' + (rotors[slot].getPosition() - 'A' + 1) % 26));
+        near.setRotors(rotors);
+        settings.push_back(near);
+    }
+
+    std::vector<Enigma::CompiledKey> keys;
+    std::vector<Enigma::RotorPositions> positions;
+    for (const Enigma::UserSettings &key : settings)
+    {
+        keys.push_back(Enigma::CompiledKey(key));
+        positions.push_back(Enigma::CompiledKey::PositionsOf(key));
+    }
+    std::vector<uint64_t> mismatch(lanes / 64);
+    size_t disagreements = 0, matches = 0;
+    for (size_t k = 0; k < keys.size(); k += lanes)
+    {
+        size_t count = std::min(keys.size() - k, (size_t)lanes);
+        evaluator.Test(&keys[k], &positions[k], count, mismatch.data());
+        for (size_t l = 0; l < count; l++)
+        {
+            bool match = !((mismatch[l / 64] >> (l % 64)) & 1);
+            bool expected = Enigma::Encoder(settings[k + l]).EncryptString(crib) == cipher;
+            matches += expected;
+            disagreements += match != expected;
+        }
+    }
+    std::printf("Lanes: %d. Agreement with Encoder: %zu keys, %zu matching the crib, %zu disagreements.\n",
+                lanes, keys.size(), matches, disagreements);
+    if (disagreements)
+        throw std::runtime_error("Bitsliced evaluator disagrees with Encoder.");
+
+    std::printf("%-22s %10s %14s %14s %8s %9s\n", "keys", "count", "bitsliced/s", "scalar/s", "speedup", "matches");
+
+    // Random keys: almost every key fails in the first letters, so early exit dominates.
+    keys.clear();
+    positions.clear();
+    for (size_t i = 0; i < numberOfKeys; i++)
+    {
+        Enigma::UserSettings key = RandomKey(random);
+        keys.push_back(Enigma::CompiledKey(key));
+        positions.push_back(Enigma::CompiledKey::PositionsOf(key));
+    }
+    Measure("random", evaluator, keys, positions, cribIndices, cipherIndices);
+
+    // Keys equivalent to the target: the whole crib is processed for every key.
+    keys.assign(numberOfKeys / 16, Enigma::CompiledKey(target));
+    positions.assign(numberOfKeys / 16, Enigma::CompiledKey::PositionsOf(target));
+    Measure("matching (full crib)", evaluator, keys, positions, cribIndices, cipherIndices);
+}
+
+/* Returns the best of 3 wall times of a run in seconds. */
+template <typename F>
+double BestOf3(F run)
+{
+    double best = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        auto begin = Clock::now();
+        run();
+        double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+        if (i == 0 || seconds < best)
+            best = seconds;
+    }
+    return best;
+}
+
+void BenchPlacement(int threads)
+{
+    const Enigma::NumaTopology &topology = Enigma::NumaTopology::System();
+    std::printf("NUMA nodes: %d.", topology.getNumberOfNodes());
+    for (int node = 0; node < topology.getNumberOfNodes(); node++)
+        std::printf(" Node %d: %zu CPUs.", node, topology.getCpus(node).size());
+    std::printf("\n");
+
+    // Random text is enough, lookups hit the whole table either way.
+    std::mt19937_64 random(2023);
+    std::string corpus(4 * 1024 * 1024, 'A');
+    for (char &c : corpus)
+        c = (char)('A' + random() % 26);
+    Enigma::NgramModel model = Enigma::NgramModel::Train(corpus, 4);
+    std::vector<uint8_t> text = Enigma::CompiledKey::ToIndices(corpus);
+    const size_t sliceLength = 256;
+    const size_t slices = text.size() / sliceLength;
+
+    std::string cipherText = corpus.substr(0, 200);
+    Enigma::Keyspace space((Enigma::KeyspaceOptions()));
+    const Enigma::KeyspaceShard range = {0, 24 * space.getTableSize()};
+
+    std::printf("%-10s %-11s %8s %16s %8s %14s %8s\n", "placement", "table", "threads", "letters/s", "speedup", "scan keys/s", "speedup");
+    const char *placementNames[] = {"none", "compact", "spread"};
+    double baseLetters = 0, baseKeys = 0;
+    for (int replicated = 0; replicated < 2; replicated++)
+    {
+        if (replicated)
+            model.Replicate();
+        for (Enigma::ThreadPlacement placement : {Enigma::PlacementNone, Enigma::PlacementCompact, Enigma::PlacementSpread})
+        {
+            Enigma::ThreadPoolOptions options;
+            options.NumberOfThreads = threads;
+            options.Placement = placement;
+            Enigma::ThreadPool pool(options);
+
+            std::vector<double> scores(slices);
+            double scoring = BestOf3([&] {
+                pool.ParallelFor(slices, [&](size_t t) { scores[t] = model.Score(&text[t * sliceLength], sliceLength); });
+            });
+            double scan = replicated ? 0 : BestOf3([&] { Enigma::KeyspaceSearch::RunRange(space, cipherText, range, 10, pool); });
+
+            double letters = slices * sliceLength / scoring, keys = scan > 0 ? range.size() / scan : 0;
+            if (!replicated && placement == Enigma::PlacementNone)
+            {
+                baseLetters = letters;
+                baseKeys = keys;
+            }
+            if (replicated)
+                std::printf("%-10s %-11s %8d %16.0f %8.2f %14s %8s\n", placementNames[placement], "replicated", pool.getSize(), letters,
+                            letters / baseLetters, "-", "-");
+            else
+                std::printf("%-10s %-11s %8d %16.0f %8.2f %14.0f %8.2f\n", placementNames[placement], "shared", pool.getSize(), letters,
+                            letters / baseLetters, keys, keys / baseKeys);
+        }
+    }
+}
+
+/* Index of coincidence of a text given as letter indices, the score of a ciphertext-only trial. */
+double IndexOfCoincidence(const uint8_t *text, size_t length)
+{
+    uint32_t counts[26] = {0};
+    for (size_t i = 0; i < length; i++)
+        counts[text[i]]++;
+    uint64_t sum = 0;
+    for (int i = 0; i < 26; i++)
+        sum += (uint64_t)counts[i] * (counts[i] - (counts[i] > 0));
+    return length < 2 ? 0 : (double)sum / ((double)length * (length - 1));
+}
+
+/* Search kernel: tests @count candidate keys chosen by @task, returns a checksum so nothing is optimized away. */
+typedef std::function<double(size_t task, size_t count)> Kernel;
+
+/* Result of one kernel, length and thread count. */
+struct KernelResult
+{
+    std::string Name;
+    size_t Length;
+    int Threads;
+    uint64_t Keys;
+    double Seconds;
+};
+
+/* Runs a kernel on all threads of the pool, doubling the work until it takes at least @minSeconds. */
+KernelResult MeasureKernel(const std::string &name, size_t length, const Kernel &kernel, Enigma::ThreadPool &pool, double minSeconds)
+{
+    const size_t tasks = pool.getSize() * 8;
+    std::vector<double> sums(tasks);
+    for (size_t perTask = 64;; perTask *= 2)
+    {
+        auto begin = Clock::now();
+        pool.ParallelFor(tasks, [&](size_t t) { sums[t] = kernel(t, perTask); });
+        double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+        if (seconds >= minSeconds || perTask >= ((size_t)1 << 40))
+            return {name, length, pool.getSize(), (uint64_t)(tasks * perTask), seconds};
+    }
+}
+
+void BenchKernels(const char *jsonPath, int maxThreads, const std::vector<size_t> &lengths)
+{
+    if (maxThreads < 1)
+        maxThreads = (int)std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    std::mt19937_64 random(2023);
+    std::string corpus(1024 * 1024, 'A');
+    for (char &c : corpus)
+        c = (char)('A' + random() % 26);
+    const Enigma::NgramModel quadgrams = Enigma::NgramModel::Train(corpus, 4);
+
+    // Keys of every task: random settings for Encoder, one compiled key per lane for the others.
+    const int lanes = Enigma::BitslicedEvaluator::getNumberOfLanes();
+    std::vector<Enigma::UserSettings> settings;
+    std::vector<Enigma::CompiledKey> keys;
+    for (int i = 0; i < lanes; i++)
+    {
+        settings.push_back(RandomKey(random));
+        keys.push_back(Enigma::CompiledKey(settings.back()));
+    }
+
+    std::vector<std::unique_ptr<Enigma::KeystreamTable>> tables;
+    std::vector<std::vector<uint16_t>> nextStates;
+    for (int i = 0; i < 8; i++)
+    {
+        tables.emplace_back(new Enigma::KeystreamTable(keys[i]));
+        nextStates.push_back(tables.back()->NextStates());
+    }
+
+    std::vector<KernelResult> results;
+    std::printf("%-12s %8s %8s %14s %16s\n", "kernel", "length", "threads", "keys", "keys/s");
+    for (size_t length : lengths)
+    {
+        std::string plain = corpus.substr(0, length);
+        std::string cipherText = Enigma::Encoder(settings[0]).EncryptString(plain);
+        const std::vector<uint8_t> cipher = Enigma::CompiledKey::ToIndices(cipherText);
+        const Enigma::BitslicedEvaluator evaluator(plain, cipherText);
+
+        std::vector<std::pair<std::string, Kernel>> kernels;
+        // Trial decryption as a plain user of the library does it: Encoder per key, scored by IoC.
+        kernels.push_back({"encoder", [&](size_t task, size_t count) {
+            double sum = 0;
+            for (size_t k = 0; k < count; k++)
+            {
+                Enigma::Encoder encoder(settings[(task + k) % settings.size()]);
+                std::vector<uint8_t> text = Enigma::CompiledKey::ToIndices(encoder.EncryptString(cipherText));
+                sum += IndexOfCoincidence(text.data(), text.size());
+            }
+            return sum;
+        }});
+        // Precompiled key, stepping and lookups per letter, start positions vary.
+        kernels.push_back({"compiled", [&](size_t task, size_t count) {
+            const Enigma::CompiledKey &key = keys[task % keys.size()];
+            std::vector<uint8_t> text(cipher.size());
+            double sum = 0;
+            for (size_t k = 0; k < count; k++)
+            {
+                Enigma::RotorPositions positions = {(int)(k % 26), (int)(k / 26 % 26), (int)(k / 676 % 26)};
+                for (size_t i = 0; i < cipher.size(); i++)
+                    text[i] = (uint8_t)key.EncryptIndex(cipher[i], positions);
+                sum += IndexOfCoincidence(text.data(), text.size());
+            }
+            return sum;
+        }});
+        // Keystream tables of KeyspaceSearch: two lookups per letter. A search builds a table once per
+        // 17576 start positions, so building is left out here.
+        kernels.push_back({"keystream", [&](size_t task, size_t count) {
+            const size_t t = task % tables.size();
+            const uint16_t *next = nextStates[t].data();
+            std::vector<uint8_t> text(cipher.size());
+            double sum = 0;
+            for (size_t k = 0; k < count; k++)
+            {
+                int current = (int)((task * 7919 + k) % Enigma::KeystreamTable::numberOfStates);
+                for (size_t i = 0; i < cipher.size(); i++)
+                {
+                    current = next[current];
+                    text[i] = tables[t]->getPermutation(current)[cipher[i]];
+                }
+                sum += IndexOfCoincidence(text.data(), text.size());
+            }
+            return sum;
+        }});
+        // Known plaintext, one key per bit lane, SIMD where compiled in.
+        kernels.push_back({"bitsliced", [&](size_t task, size_t count) {
+            std::vector<Enigma::RotorPositions> positions(lanes);
+            std::vector<uint64_t> mismatch(lanes / 64);
+            double sum = 0;
+            for (size_t k = 0; k < count; k += lanes)
+            {
+                for (int l = 0; l < lanes; l++)
+                    positions[l] = {(int)((task + k) % 26), (int)(l % 26), (int)(k / lanes % 26)};
+                evaluator.Test(keys.data(), positions.data(), lanes, mismatch.data());
+                sum += (double)mismatch[0];
+            }
+            return sum;
+        }});
+        // Scoring only, a decryption per candidate as input.
+        kernels.push_back({"score-ioc", [&](size_t task, size_t count) {
+            double sum = 0;
+            for (size_t k = 0; k < count; k++)
+                sum += IndexOfCoincidence(cipher.data(), cipher.size() - (k + task) % 2);
+            return sum;
+        }});
+        kernels.push_back({"score-ngram", [&](size_t task, size_t count) {
+            double sum = 0;
+            for (size_t k = 0; k < count; k++)
+                sum += quadgrams.Score(cipher.data(), cipher.size() - (k + task) % 2);
+            return sum;
+        }});
+
+        for (int threads : threadCounts)
+        {
+            Enigma::ThreadPool pool(threads);
+            for (const std::pair<std::string, Kernel> &kernel : kernels)
+            {
+                KernelResult res = MeasureKernel(kernel.first, length, kernel.second, pool, 0.25);
+                std::printf("%-12s %8zu %8d %14llu %16.0f\n", res.Name.c_str(), res.Length, res.Threads, (unsigned long long)res.Keys,
+                            res.Keys / res.Seconds);
+                results.push_back(res);
+            }
+        }
+    }
+
+    if (jsonPath == nullptr)
+        return;
+    std::ostringstream json;
+    json << "{\n  \"benchmark\": \"kernels\",\n  \"lanes\": " << lanes << ",\n  \"hardwareThreads\": " << std::thread::hardware_concurrency()
+         << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const KernelResult &res = results[i];
+        char line[256];
+        std::snprintf(line, sizeof(line),
+                      "    {\"kernel\": \"%s\", \"length\": %zu, \"threads\": %d, \"keys\": %llu, \"seconds\": %.6f, \"keysPerSecond\": %.1f}%s\n",
+                      res.Name.c_str(), res.Length, res.Threads, (unsigned long long)res.Keys, res.Seconds, res.Keys / res.Seconds,
+                      i + 1 < results.size() ? "," : "");
+        json << line;
+    }
+    json << "  ]\n}\n";
+    std::ofstream out(jsonPath);
+    out << json.str();
+    if (!out.good())
+        throw std::runtime_error("Error while writing to a file.");
+}
+
+/* Parses comma separated numbers. */
+std::vector<size_t> ParseList(const std::string &list)
+{
+    std::vector<size_t> values;
+    std::stringstream stream(list);
+    std::string value;
+    while (std::getline(stream, value, ','))
+        if (!value.empty())
+            values.push_back(std::strtoull(value.c_str(), nullptr, 10));
+    if (values.empty() || std::count(values.begin(), values.end(), (size_t)0) != 0)
+        throw std::runtime_error("Invalid list of lengths.");
+    return values;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::printf("EnigmaBench bitslice (number of keys = 1000000) (crib length = 16)\n");
+        std::printf("EnigmaBench placement (number of threads = all)\n");
+        std::printf("EnigmaBench kernels (JSON output path or -) (max number of threads = all) (ciphertext lengths = 50,100,250,500)\n");
+        return 0;
+    }
+
+    try
+    {
+        std::string mode = argv[1];
+        if (mode == "bitslice")
+            BenchBitslice(argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000, argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 16);
+        else if (mode == "placement")
+            BenchPlacement(argc > 2 ? std::atoi(argv[2]) : 0);
+        else if (mode == "kernels")
+            BenchKernels(argc > 2 && std::string(argv[2]) != "-" ? argv[2] : nullptr, argc > 3 ? std::atoi(argv[3]) : 0,
+                         ParseList(argc > 4 ? argv[4] : "50,100,250,500"));
+        else
+            throw std::runtime_error("Unknown benchmark.");
+    }
+    catch (const std::exception &e)
+    {
+        std::printf("%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
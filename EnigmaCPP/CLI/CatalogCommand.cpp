@@ -0,0 +1,91 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "CatalogCommand.h"
+#include "include/CycleCatalog.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace EnigmaCLI;
+
+void CatalogCommand::Run(int argc, char *argv[])
+{
+    if (argc < 4)
+        throw std::runtime_error("Pass valid arguments.");
+    std::string mode = argv[2];
+    typedef std::chrono::steady_clock Clock;
+
+    if (mode == "build")
+    {
+        Enigma::CycleCatalogOptions options;
+        if (argc > 4)
+        {
+            std::string rings = argv[4];
+            if (rings.size() != 3)
+                throw std::runtime_error("Rings must be 3 letters.");
+            for (int i = 0; i < 3; i++)
+            {
+                if (rings[i] < 'A' || rings[i] > 'Z')
+                    throw std::runtime_error("Rings must be 3 letters.");
+                options.Rings[i] = rings[i] - 'A';
+            }
+        }
+        Enigma::ThreadPool pool;
+        std::cout << "Building catalog of 2 reflectors x 60 wheel orders x 17576 Grundstellungen on " << pool.getSize() << " threads..." << std::endl;
+        auto start = Clock::now();
+        Enigma::CycleCatalog catalog = Enigma::CycleCatalog::Build(options, pool);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        catalog.Save(argv[3]);
+        std::printf("Built %zu entries, %zu different characteristics, in %.2f s. Saved under name: %s\n", catalog.size(),
+                    catalog.getNumberOfSignatures(), seconds, argv[3]);
+        return;
+    }
+    if (mode != "find" || argc < 5)
+        throw std::runtime_error("Pass valid arguments.");
+
+    auto start = Clock::now();
+    Enigma::CycleCatalog catalog = Enigma::CycleCatalog::Load(argv[3]);
+    double loadMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    // Indicator is the first word of a line, same file layout as -id.
+    std::ifstream file(argv[4]);
+    if (!file.good())
+        throw std::runtime_error("Error while reading file.");
+    std::vector<std::string> indicators;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        size_t begin = line.find_first_not_of(" \t\r");
+        if (begin != std::string::npos)
+            indicators.push_back(line.substr(begin, line.find_first_of(" \t\r", begin) - begin));
+    }
+    if (file.bad())
+        throw std::runtime_error("Error while reading file.");
+
+    uint32_t signature = Enigma::CycleCatalog::SignatureOf(indicators);
+    start = Clock::now();
+    const Enigma::CycleCatalogEntry *first;
+    size_t count = catalog.Lookup(signature, first);
+    double lookupUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    std::printf("Characteristic of %zu indicators: %s\n", indicators.size(), Enigma::CycleCatalog::ToString(signature).c_str());
+    std::printf("Catalog mapped in %.2f ms, lookup %.2f us. %zu matching settings (rings %c%c%c):\n", loadMs, lookupUs, count,
+                'A' + catalog.getRings()[0], 'A' + catalog.getRings()[1], 'A' + catalog.getRings()[2]);
+    static const char *rotorNames[] = {"I", "II", "III", "IV", "V"};
+    static const char *reflectorNames[] = {"ETW", "B", "C"};
+    for (size_t i = 0; i < count && i < (size_t)maxPrintedSettings; i++)
+    {
+        Enigma::KeyCandidate candidate = catalog.ToCandidate(first[i]);
+        std::printf("%s %s %s %s %c%c%c\n", reflectorNames[candidate.Reflector], rotorNames[candidate.Rotors[0]], rotorNames[candidate.Rotors[1]],
+                    rotorNames[candidate.Rotors[2]], 'A' + candidate.Positions[0], 'A' + candidate.Positions[1], 'A' + candidate.Positions[2]);
+    }
+    if (count > (size_t)maxPrintedSettings)
+        std::printf("... and %zu more.\n", count - maxPrintedSettings);
+}
@@ -0,0 +1,31 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+namespace EnigmaCLI
+{
+    /* Handles --catalog flag. Rejewski's catalog of the characteristic of doubled indicators. */
+    class CatalogCommand
+    {
+        /* Max number of printed settings. */
+        static const int maxPrintedSettings = 50;
+
+    public:
+        /**
+         * Builds a catalog and saves it (--catalog build [output path] (rings)),
+         * or looks up the characteristic of indicators of a day (--catalog find [catalog path] [indicators path]).
+         *
+         * Params:
+         * int argc - number of arguments.
+         * char *argv[] - arguments.
+         *
+         * Exceptions:
+         * If arguments are invalid, files cannot be read or written,
+         * or the indicators do not determine the characteristic, an exception will be thrown.
+        */
+        static void Run(int argc, char *argv[]) noexcept(false);
+    };
+}
@@ -0,0 +1,524 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "Cluster.h"
+#include "AttackCommand.h"
+
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+using namespace EnigmaCLI;
+using namespace EnigmaCLI::Protocol;
+using namespace EnigmaCLI::ClusterProtocol;
+
+namespace
+{
+    /* Parses "address:port" of IPv4. */
+    sockaddr_in ParseAddress(const std::string& address)
+    {
+        size_t colon = address.rfind(':');
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        if (colon == std::string::npos || inet_pton(AF_INET, address.substr(0, colon).c_str(), &addr.sin_addr) != 1)
+            throw std::runtime_error("Invalid address, pass address:port.");
+        int port = std::atoi(address.c_str() + colon + 1);
+        if (port <= 0 || port > 65535)
+            throw std::runtime_error("Invalid address, pass address:port.");
+        addr.sin_port = htons((uint16_t)port);
+        return addr;
+    }
+
+    /* Keyspace of a distributed search, the same on the coordinator and workers. */
+    Enigma::KeyspaceOptions SpaceOptions(bool searchRings)
+    {
+        Enigma::KeyspaceOptions dims;
+        if (searchRings)
+            dims.Rings[1] = dims.Rings[2] = Enigma::KeyspaceOptions::AllLetters();
+        return dims;
+    }
+
+    /* Fingerprint of a distributed search. */
+    uint64_t JobFingerprint(const Enigma::Keyspace& space, const std::string& cipherText, size_t topK)
+    {
+        Enigma::KeyspaceSearchOptions options;
+        options.TopK = topK;
+        return Enigma::KeyspaceSearch::Fingerprint(space, cipherText, options);
+    }
+
+    double SecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+Coordinator::Coordinator(const std::string& cipherText, const std::string& address, size_t topK, bool searchRings)
+    : CipherText(cipherText), TopK(topK), SearchRings(searchRings), Space(SpaceOptions(searchRings)),
+      NumberOfFinished(0), KeysDone(0), Reassigned(0), ListenFd(-1), EpollFd(-1)
+{
+    sockaddr_in addr = ParseAddress(address);
+
+    // Shards of whole table blocks, so that a worker builds every table once.
+    const uint64_t tableSize = Space.getTableSize();
+    const uint64_t blocks = Space.size() / tableSize;
+    Shards = Space.Split((size_t)std::min<uint64_t>(blocks, maxShards), tableSize);
+    Finished.assign(Shards.size(), false);
+    for (size_t i = Shards.size(); i > 0; i--)
+        Queue.push_back(i - 1);
+
+    signal(SIGPIPE, SIG_IGN);
+    ListenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (ListenFd < 0)
+        throw std::runtime_error("Unable to create socket.");
+    int one = 1;
+    setsockopt(ListenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(ListenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(ListenFd, SOMAXCONN) != 0)
+    {
+        close(ListenFd);
+        throw std::runtime_error("Unable to listen on " + address + '.');
+    }
+
+    EpollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = ListenFd;
+    if (EpollFd < 0 || epoll_ctl(EpollFd, EPOLL_CTL_ADD, ListenFd, &ev) != 0)
+    {
+        close(ListenFd);
+        if (EpollFd >= 0) close(EpollFd);
+        throw std::runtime_error("Unable to set up epoll.");
+    }
+}
+
+Coordinator::~Coordinator() noexcept
+{
+    for (auto& worker : Workers)
+        close(worker.first);
+    close(ListenFd);
+    close(EpollFd);
+}
+
+void Coordinator::Run()
+{
+    std::cout << "Searching " << Space.size() << " keys in " << Shards.size() << " shards. Waiting for workers..." << std::endl;
+
+    const auto start = std::chrono::steady_clock::now();
+    auto lastReport = start;
+    uint64_t lastKeys = 0;
+    std::vector<epoll_event> events(maxEvents);
+    while (NumberOfFinished < Shards.size())
+    {
+        int n = epoll_wait(EpollFd, events.data(), maxEvents, 200);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error("epoll_wait failed.");
+        }
+        for (int i = 0; i < n; i++)
+        {
+            int fd = events[i].data.fd;
+            if (fd == ListenFd)
+            {
+                AcceptConnections();
+                continue;
+            }
+            auto it = Workers.find(fd);
+            if (it == Workers.end())
+                continue;
+            bool keep = true;
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                keep = HandleReadable(fd);
+            if (keep && (events[i].events & EPOLLOUT))
+                keep = FlushOutput(fd, it->second);
+            if (!keep)
+                CloseConnection(fd);
+        }
+
+        // Silent workers holding a shard are considered dead.
+        auto now = std::chrono::steady_clock::now();
+        std::vector<int> expired;
+        for (auto& worker : Workers)
+            if (worker.second.Shard != noShard && now - worker.second.LastHeard > std::chrono::seconds(leaseSeconds))
+                expired.push_back(worker.first);
+        for (int fd : expired)
+            CloseConnection(fd);
+
+        AssignShards();
+
+        if (now - lastReport >= std::chrono::seconds(1))
+        {
+            uint64_t keys = KeysDone;
+            uint32_t threads = 0;
+            for (auto& worker : Workers)
+            {
+                keys += worker.second.ShardKeys;
+                threads += worker.second.Threads;
+            }
+            double seconds = std::chrono::duration<double>(now - lastReport).count();
+            std::printf("Done %llu / %llu keys (%.2f%%), %zu workers (%u threads), %.0f keys/s.\n", (unsigned long long)keys,
+                        (unsigned long long)Space.size(), 100.0 * keys / Space.size(), Workers.size(), threads,
+                        keys > lastKeys ? (keys - lastKeys) / seconds : 0.0);
+            std::fflush(stdout);
+            lastReport = now;
+            lastKeys = keys;
+        }
+    }
+
+    // Workers exit on OpFinish, a lost message only makes them see the closed connection instead.
+    for (auto& worker : Workers)
+    {
+        AppendFrame(worker.second.Out, OpFinish, StatusOk, 0, nullptr, 0);
+        FlushOutput(worker.first, worker.second);
+    }
+    PrintResult(SecondsSince(start));
+}
+
+void Coordinator::AcceptConnections() noexcept
+{
+    while (true)
+    {
+        int fd = accept4(ListenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        if (epoll_ctl(EpollFd, EPOLL_CTL_ADD, fd, &ev) != 0)
+        {
+            close(fd);
+            continue;
+        }
+        WorkerConnection& worker = Workers[fd];
+        worker.LastHeard = std::chrono::steady_clock::now();
+    }
+}
+
+bool Coordinator::HandleReadable(int fd) noexcept
+{
+    WorkerConnection& worker = Workers[fd];
+    char buffer[64 * 1024];
+    bool peerClosed = false;
+    while (true)
+    {
+        ssize_t got = read(fd, buffer, sizeof(buffer));
+        if (got > 0)
+            worker.In.append(buffer, got);
+        else if (got == 0)
+        {
+            peerClosed = true;
+            break;
+        }
+        else if (errno == EINTR)
+            continue;
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+        else
+            return false;
+    }
+
+    size_t offset = 0;
+    while (worker.In.size() - offset >= sizeof(FrameHeader))
+    {
+        FrameHeader header;
+        std::memcpy(&header, worker.In.data() + offset, sizeof(header));
+        if (header.Length > MaxBodyLength)
+            return false;
+        if (worker.In.size() - offset - sizeof(header) < header.Length)
+            break;
+        if (!ProcessMessage(worker, header, worker.In.data() + offset + sizeof(header)))
+            return false;
+        offset += sizeof(header) + header.Length;
+    }
+    worker.In.erase(0, offset);
+
+    if (!FlushOutput(fd, worker))
+        return false;
+    return !peerClosed;
+}
+
+bool Coordinator::ProcessMessage(WorkerConnection& worker, const FrameHeader& header, const char* body) noexcept
+{
+    worker.LastHeard = std::chrono::steady_clock::now();
+    switch (header.Opcode)
+    {
+    case OpHello:
+    {
+        HelloBody hello;
+        if (worker.Ready || header.Length != sizeof(hello))
+            return false;
+        std::memcpy(&hello, body, sizeof(hello));
+        if (hello.Version != ProtocolVersion)
+            return false;
+        worker.Ready = true;
+        worker.Threads = hello.Threads;
+
+        JobBody job = {JobFingerprint(Space, CipherText, TopK), (uint32_t)TopK, SearchRings ? 1u : 0u};
+        std::string jobBody(reinterpret_cast<const char*>(&job), sizeof(job));
+        jobBody += CipherText;
+        AppendFrame(worker.Out, OpJob, StatusOk, 0, jobBody.data(), (uint32_t)jobBody.size());
+        return true;
+    }
+    case OpProgress:
+    case OpDone:
+    {
+        ProgressBody progress;
+        if (header.Length < sizeof(progress) || (header.Length - sizeof(progress)) % sizeof(Enigma::KeyspaceCandidate) != 0)
+            return false;
+        std::memcpy(&progress, body, sizeof(progress));
+        if (progress.Shard != worker.Shard)
+            return false;
+        std::vector<Enigma::KeyspaceCandidate> candidates((header.Length - sizeof(progress)) / sizeof(Enigma::KeyspaceCandidate));
+        std::memcpy(candidates.data(), body + sizeof(progress), candidates.size() * sizeof(Enigma::KeyspaceCandidate));
+        for (const Enigma::KeyspaceCandidate& candidate : candidates)
+            if (candidate.Index < Shards[progress.Shard].First || candidate.Index >= Shards[progress.Shard].Last)
+                return false;
+        Enigma::KeyspaceSearch::MergeCandidates(Best, candidates, TopK);
+        worker.ShardKeys = std::min(progress.KeysDone, Shards[progress.Shard].size());
+
+        if (header.Opcode == OpDone)
+        {
+            if (!Finished[progress.Shard])
+            {
+                Finished[progress.Shard] = true;
+                NumberOfFinished++;
+                KeysDone += Shards[progress.Shard].size();
+            }
+            worker.Keys += Shards[progress.Shard].size();
+            worker.Shard = noShard;
+            worker.ShardKeys = 0;
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+void Coordinator::AssignShards() noexcept
+{
+    std::vector<int> broken;
+    for (auto& entry : Workers)
+    {
+        WorkerConnection& worker = entry.second;
+        if (!worker.Ready || worker.Shard != noShard)
+            continue;
+        if (Queue.empty())
+            break;
+        worker.Shard = Queue.back();
+        Queue.pop_back();
+        worker.ShardKeys = 0;
+        worker.LastHeard = std::chrono::steady_clock::now();
+
+        ShardBody shard = {worker.Shard, Shards[worker.Shard].First, Shards[worker.Shard].Last};
+        AppendFrame(worker.Out, OpShard, StatusOk, 0, reinterpret_cast<const char*>(&shard), sizeof(shard));
+        if (!FlushOutput(entry.first, worker))
+            broken.push_back(entry.first);
+    }
+    for (int fd : broken)
+        CloseConnection(fd);
+}
+
+bool Coordinator::FlushOutput(int fd, WorkerConnection& worker) noexcept
+{
+    while (worker.OutOffset < worker.Out.size())
+    {
+        ssize_t sent = write(fd, worker.Out.data() + worker.OutOffset, worker.Out.size() - worker.OutOffset);
+        if (sent > 0)
+            worker.OutOffset += sent;
+        else if (sent < 0 && errno == EINTR)
+            continue;
+        else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        else
+            return false;
+    }
+
+    bool pending = worker.OutOffset < worker.Out.size();
+    if (!pending)
+    {
+        worker.Out.clear();
+        worker.OutOffset = 0;
+    }
+    if (pending != worker.WantWrite)
+    {
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLRDHUP | (pending ? (uint32_t)EPOLLOUT : 0u);
+        ev.data.fd = fd;
+        epoll_ctl(EpollFd, EPOLL_CTL_MOD, fd, &ev);
+        worker.WantWrite = pending;
+    }
+    return true;
+}
+
+void Coordinator::CloseConnection(int fd) noexcept
+{
+    auto it = Workers.find(fd);
+    if (it == Workers.end())
+        return;
+    if (it->second.Shard != noShard && !Finished[it->second.Shard])
+    {
+        Queue.push_back(it->second.Shard);
+        Reassigned++;
+        std::printf("Worker lost, shard %llu goes back to the queue.\n", (unsigned long long)it->second.Shard);
+    }
+    epoll_ctl(EpollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    Workers.erase(it);
+}
+
+void Coordinator::PrintResult(double seconds) const noexcept
+{
+    std::printf("Search complete: %llu keys in %.2f s, %.0f keys/s, %llu shards reassigned.\n", (unsigned long long)Space.size(),
+                seconds, Space.size() / seconds, (unsigned long long)Reassigned);
+    std::printf("     score    reflector rotors  start rings decryption\n");
+    for (size_t i = 0; i < Best.size(); i++)
+    {
+        Enigma::KeyspaceKey key = Space.Unrank(Best[i].Index);
+        Enigma::KeyCandidate candidate;
+        candidate.Score = Best[i].Score;
+        candidate.Reflector = key.Reflector;
+        candidate.Rotors = key.Rotors;
+        candidate.Rings = key.Rings;
+        candidate.Positions = key.Positions;
+        AttackCommand::PrintCandidate((int)i + 1, candidate, CipherText);
+    }
+}
+
+Worker::Worker(const std::string& address, int threads) : Fd(-1), Threads(threads)
+{
+    sockaddr_in addr = ParseAddress(address);
+    Fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (Fd < 0)
+        throw std::runtime_error("Unable to create socket.");
+    if (connect(Fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        close(Fd);
+        throw std::runtime_error("Unable to connect to " + address + '.');
+    }
+    int one = 1;
+    setsockopt(Fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+Worker::~Worker() noexcept
+{
+    close(Fd);
+}
+
+void Worker::Receive(FrameHeader& header, std::string& body)
+{
+    char* dst = reinterpret_cast<char*>(&header);
+    size_t need = sizeof(header);
+    for (int part = 0; part < 2; part++)
+    {
+        size_t done = 0;
+        while (done < need)
+        {
+            ssize_t got = read(Fd, dst + done, need - done);
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got <= 0)
+                throw std::runtime_error("Connection to the coordinator lost.");
+            done += got;
+        }
+        if (part == 0)
+        {
+            if (header.Length > MaxBodyLength)
+                throw std::runtime_error("Invalid message of the coordinator.");
+            body.resize(header.Length);
+            dst = &body[0];
+            need = header.Length;
+        }
+    }
+}
+
+void Worker::Send(uint8_t op, const std::string& body)
+{
+    std::string frame;
+    AppendFrame(frame, op, StatusOk, 0, body.data(), (uint32_t)body.size());
+    size_t done = 0;
+    while (done < frame.size())
+    {
+        ssize_t sent = send(Fd, frame.data() + done, frame.size() - done, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            throw std::runtime_error("Connection to the coordinator lost.");
+        done += sent;
+    }
+}
+
+void Worker::Run()
+{
+    Enigma::ThreadPool pool(Threads);
+    HelloBody hello = {ProtocolVersion, (uint32_t)pool.getSize()};
+    Send(OpHello, std::string(reinterpret_cast<const char*>(&hello), sizeof(hello)));
+
+    FrameHeader header;
+    std::string body;
+    Receive(header, body);
+    JobBody job;
+    if (header.Opcode != OpJob || body.size() < sizeof(job))
+        throw std::runtime_error("Invalid message of the coordinator.");
+    std::memcpy(&job, body.data(), sizeof(job));
+    const std::string cipherText = body.substr(sizeof(job));
+    const Enigma::Keyspace space(SpaceOptions(job.SearchRings != 0));
+    if (JobFingerprint(space, cipherText, job.TopK) != job.Fingerprint)
+        throw std::runtime_error("Keyspace of the coordinator does not match this build.");
+    std::cout << "Connected, searching " << space.size() << " keys on " << pool.getSize() << " threads..." << std::endl;
+
+    const uint64_t tableSize = space.getTableSize();
+    uint64_t keys = 0;
+    const auto start = std::chrono::steady_clock::now();
+    while (true)
+    {
+        Receive(header, body);
+        if (header.Opcode == OpFinish)
+            break;
+        ShardBody shard;
+        if (header.Opcode != OpShard || body.size() != sizeof(shard))
+            throw std::runtime_error("Invalid message of the coordinator.");
+        std::memcpy(&shard, body.data(), sizeof(shard));
+
+        // A table block at a time, progress (which also renews the lease) at most once a second.
+        std::vector<Enigma::KeyspaceCandidate> best;
+        auto lastProgress = std::chrono::steady_clock::now();
+        uint64_t first = shard.First;
+        while (first < shard.Last)
+        {
+            uint64_t last = std::min(shard.Last, (first / tableSize + 1) * tableSize);
+            Enigma::KeyspaceSearch::MergeCandidates(best, Enigma::KeyspaceSearch::RunRange(space, cipherText, {first, last}, job.TopK, pool), job.TopK);
+            first = last;
+
+            bool done = first >= shard.Last;
+            if (done || SecondsSince(lastProgress) >= 1.0)
+            {
+                ProgressBody progress = {shard.Shard, first - shard.First};
+                std::string message(reinterpret_cast<const char*>(&progress), sizeof(progress));
+                message.append(reinterpret_cast<const char*>(best.data()), best.size() * sizeof(Enigma::KeyspaceCandidate));
+                Send(done ? OpDone : OpProgress, message);
+                lastProgress = std::chrono::steady_clock::now();
+            }
+        }
+        keys += shard.Last - shard.First;
+    }
+
+    double seconds = SecondsSince(start);
+    std::printf("Search finished, tested %llu keys in %.2f s, %.0f keys/s.\n", (unsigned long long)keys, seconds, keys / seconds);
+}
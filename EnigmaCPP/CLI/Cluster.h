@@ -0,0 +1,260 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+
+#include "include/KeyspaceSearch.h"
+#include "ClusterProtocol.h"
+
+namespace EnigmaCLI
+{
+    /**
+     * Handles --coordinator flag.
+     *
+     * Splits the keyspace (reflectors B and C x 60 wheel orders x start positions, optionally x middle and right
+     * ring settings) into shards of whole table blocks and hands them out to workers connected over TCP,
+     * one shard per worker at a time. Connections are multiplexed by a single epoll loop.
+     * The shard of a worker that disconnects or is silent for longer than leaseSeconds goes back to the queue.
+     * Candidates streamed by workers are merged into the global top-K, which does not depend on who searched what.
+     * Protocol is described in ClusterProtocol.h.
+    */
+    class Coordinator
+    {
+    public:
+        /**
+         * Constructor.
+         *
+         * Creates, binds and starts listening on the socket.
+         *
+         * Params:
+         * const std::string& cipherText - ciphertext.
+         * const std::string& address - IPv4 address and port to listen on, e.g. "127.0.0.1:7000".
+         * size_t topK - number of kept candidates.
+         * bool searchRings - true to search middle and right ring settings.
+         *
+         * Exceptions:
+         * If the address is invalid or socket or epoll cannot be set up, an exception will be thrown.
+        */
+        Coordinator(const std::string& cipherText, const std::string& address, size_t topK, bool searchRings) noexcept(false);
+
+        /* Destructor. Closes all connections. */
+        ~Coordinator() noexcept;
+
+        Coordinator(const Coordinator&) = delete;
+        Coordinator& operator=(const Coordinator&) = delete;
+
+        /**
+         * Serves workers until every shard is done, printing progress every second and the result at the end.
+         *
+         * Exceptions:
+         * If epoll fails, an exception will be thrown.
+        */
+        void Run() noexcept(false);
+
+    private:
+        /* Seconds without a message after which a worker holding a shard is considered dead. */
+        static const int leaseSeconds = 60;
+
+        /* Max number of shards. */
+        static const size_t maxShards = 4096;
+
+        /* Max number of events handled by one epoll_wait call. */
+        static const int maxEvents = 64;
+
+        /* Marks a worker without a shard. */
+        static const uint64_t noShard = UINT64_MAX;
+
+        /* State of a worker connection. */
+        struct WorkerConnection
+        {
+            /* Received, not yet processed bytes. */
+            std::string In;
+
+            /* Messages waiting to be sent. */
+            std::string Out;
+
+            /* Number of bytes of @Out already sent. */
+            size_t OutOffset = 0;
+
+            /* True if connection is registered for EPOLLOUT. */
+            bool WantWrite = false;
+
+            /* True after OpHello. */
+            bool Ready = false;
+
+            /* Number of search threads of the worker. */
+            uint32_t Threads = 0;
+
+            /* Shard held by the worker, noShard if none. */
+            uint64_t Shard = noShard;
+
+            /* Keys of the held shard reported done. */
+            uint64_t ShardKeys = 0;
+
+            /* Keys of all finished shards. */
+            uint64_t Keys = 0;
+
+            /* Time of the last message. */
+            std::chrono::steady_clock::time_point LastHeard;
+        };
+
+        /* Ciphertext. */
+        std::string CipherText;
+
+        /* Number of kept candidates. */
+        size_t TopK;
+
+        /* True to search middle and right ring settings. */
+        bool SearchRings;
+
+        /* Searched keys. */
+        Enigma::Keyspace Space;
+
+        /* Shards of the space. */
+        std::vector<Enigma::KeyspaceShard> Shards;
+
+        /* True for finished shards. */
+        std::vector<bool> Finished;
+
+        /* Shards waiting for a worker. */
+        std::vector<uint64_t> Queue;
+
+        /* Number of finished shards. */
+        size_t NumberOfFinished;
+
+        /* Keys of finished shards. */
+        uint64_t KeysDone;
+
+        /* Number of shards given back after a worker died. */
+        uint64_t Reassigned;
+
+        /* Best candidates so far. */
+        std::vector<Enigma::KeyspaceCandidate> Best;
+
+        /* Listening socket. */
+        int ListenFd;
+
+        /* Epoll instance. */
+        int EpollFd;
+
+        /* Worker connections by file descriptor. */
+        std::unordered_map<int, WorkerConnection> Workers;
+
+        /* Accepts all pending connections. */
+        void AcceptConnections() noexcept;
+
+        /**
+         * Reads available data and processes complete messages.
+         *
+         * Params:
+         * int fd - connection descriptor.
+         *
+         * Returns:
+         * bool - false if the connection should be closed.
+        */
+        bool HandleReadable(int fd) noexcept;
+
+        /**
+         * Processes a message of a worker.
+         *
+         * Params:
+         * WorkerConnection& worker - worker.
+         * const Protocol::FrameHeader& header - header of the message.
+         * const char* body - body of the message.
+         *
+         * Returns:
+         * bool - false if the message is invalid and the connection should be closed.
+        */
+        bool ProcessMessage(WorkerConnection& worker, const Protocol::FrameHeader& header, const char* body) noexcept;
+
+        /* Gives a waiting shard to every idle worker. */
+        void AssignShards() noexcept;
+
+        /**
+         * Sends as much of the pending messages as possible.
+         *
+         * Params:
+         * int fd - connection descriptor.
+         * WorkerConnection& worker - worker.
+         *
+         * Returns:
+         * bool - false if the connection should be closed.
+        */
+        bool FlushOutput(int fd, WorkerConnection& worker) noexcept;
+
+        /* Closes a connection, its shard goes back to the queue. */
+        void CloseConnection(int fd) noexcept;
+
+        /* Prints the best candidates. */
+        void PrintResult(double seconds) const noexcept;
+    };
+
+    /**
+     * Handles --worker flag.
+     *
+     * Connects to a coordinator, receives the job and searches the shards it is given with
+     * KeyspaceSearch::RunRange on all threads, reporting candidates after every table block.
+    */
+    class Worker
+    {
+    public:
+        /**
+         * Constructor, connects to the coordinator.
+         *
+         * Params:
+         * const std::string& address - IPv4 address and port of the coordinator, e.g. "127.0.0.1:7000".
+         * int threads - number of search threads, all available if < 1.
+         *
+         * Exceptions:
+         * If the address is invalid or the connection fails, an exception will be thrown.
+        */
+        Worker(const std::string& address, int threads) noexcept(false);
+
+        /* Destructor. Closes the connection. */
+        ~Worker() noexcept;
+
+        Worker(const Worker&) = delete;
+        Worker& operator=(const Worker&) = delete;
+
+        /**
+         * Searches shards until the coordinator finishes the search.
+         *
+         * Exceptions:
+         * If the connection breaks or the job does not match this build, an exception will be thrown.
+        */
+        void Run() noexcept(false);
+
+    private:
+        /* Connection to the coordinator. */
+        int Fd;
+
+        /* Number of search threads. */
+        int Threads;
+
+        /**
+         * Reads a whole message.
+         *
+         * Params:
+         * Protocol::FrameHeader& header - header of the message.
+         * std::string& body - body of the message.
+        */
+        void Receive(Protocol::FrameHeader& header, std::string& body) noexcept(false);
+
+        /**
+         * Sends a whole message.
+         *
+         * Params:
+         * uint8_t op - opcode.
+         * const std::string& body - body.
+        */
+        void Send(uint8_t op, const std::string& body) noexcept(false);
+    };
+}
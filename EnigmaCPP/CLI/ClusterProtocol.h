@@ -0,0 +1,81 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "DaemonProtocol.h"
+
+#include <cstdint>
+
+namespace EnigmaCLI
+{
+    /**
+     * Messages between the coordinator (--coordinator flag) and workers (--worker flag) of a distributed search.
+     *
+     * Framing is the one of DaemonProtocol.h (FrameHeader followed by Length bytes of body) over TCP.
+     * Integers are sent in host byte order, so all machines of a search must share it.
+     * Status and RequestID are zero.
+     *
+     * Worker -> coordinator:
+     * OpHello    - HelloBody, sent once after connecting.
+     * OpProgress - ProgressBody followed by the best candidates of the shard so far (KeyspaceCandidate[]).
+     * OpDone     - same as OpProgress, the shard is finished.
+     *
+     * Coordinator -> worker:
+     * OpJob      - JobBody followed by the ciphertext, the answer to OpHello.
+     * OpShard    - ShardBody, a range of keys to be searched.
+     * OpFinish   - empty, the search is over and the worker should exit.
+    */
+    namespace ClusterProtocol
+    {
+        enum Opcode : uint8_t { OpHello = 16, OpJob = 17, OpShard = 18, OpProgress = 19, OpDone = 20, OpFinish = 21 };
+
+        /* Version of the messages, checked by the coordinator. */
+        const uint32_t ProtocolVersion = 1;
+
+        struct HelloBody
+        {
+            /* ProtocolVersion of the worker. */
+            uint32_t Version;
+
+            /* Number of search threads of the worker. */
+            uint32_t Threads;
+        };
+
+        struct JobBody
+        {
+            /* KeyspaceSearch::Fingerprint of the search, checked by the worker. */
+            uint64_t Fingerprint;
+
+            /* Number of kept candidates (K). */
+            uint32_t TopK;
+
+            /* 1 if middle and right ring settings are searched. */
+            uint32_t SearchRings;
+        };
+
+        struct ShardBody
+        {
+            /* Index of the shard. */
+            uint64_t Shard;
+
+            /* Indices of the keys [First, Last). */
+            uint64_t First;
+            uint64_t Last;
+        };
+
+        struct ProgressBody
+        {
+            /* Index of the shard. */
+            uint64_t Shard;
+
+            /* Number of keys of the shard done so far. */
+            uint64_t KeysDone;
+        };
+
+        static_assert(sizeof(HelloBody) == 8 && sizeof(JobBody) == 16 && sizeof(ShardBody) == 24 && sizeof(ProgressBody) == 16,
+                      "Bodies must be packed.");
+    }
+}
@@ -0,0 +1,357 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "Daemon.h"
+#include "Encrypter.h"
+
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cerrno>
+#include <csignal>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/signalfd.h>
+#include <sys/resource.h>
+
+using namespace EnigmaCLI;
+using namespace EnigmaCLI::Protocol;
+
+Daemon::Daemon(const char *socketPath) : SocketPath(socketPath), ListenFd(-1), EpollFd(-1), SignalFd(-1), Cache(keyCacheBudget), NextKeyID(1)
+{
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (SocketPath.size() >= sizeof(addr.sun_path))
+        throw std::runtime_error("Socket path is too long.");
+    SocketPath.copy(addr.sun_path, SocketPath.size());
+
+    // Thousands of connections need thousands of descriptors.
+    rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < lim.rlim_max)
+    {
+        lim.rlim_cur = lim.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &lim);
+    }
+
+    ListenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (ListenFd < 0)
+        throw std::runtime_error("Unable to create socket.");
+    unlink(SocketPath.c_str());
+    if (bind(ListenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(ListenFd, SOMAXCONN) != 0)
+    {
+        close(ListenFd);
+        throw std::runtime_error("Unable to listen on " + SocketPath + '.');
+    }
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &mask, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+    SignalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    EpollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = ListenFd;
+    bool ok = SignalFd >= 0 && EpollFd >= 0 && epoll_ctl(EpollFd, EPOLL_CTL_ADD, ListenFd, &ev) == 0;
+    ev.data.fd = SignalFd;
+    ok = ok && epoll_ctl(EpollFd, EPOLL_CTL_ADD, SignalFd, &ev) == 0;
+    if (!ok)
+    {
+        close(ListenFd);
+        if (SignalFd >= 0) close(SignalFd);
+        if (EpollFd >= 0) close(EpollFd);
+        unlink(SocketPath.c_str());
+        throw std::runtime_error("Unable to set up epoll.");
+    }
+}
+
+Daemon::~Daemon() noexcept
+{
+    for (auto &con : Connections)
+        close(con.first);
+    close(ListenFd);
+    close(SignalFd);
+    close(EpollFd);
+    unlink(SocketPath.c_str());
+}
+
+void Daemon::Run()
+{
+    std::cout << "Listening on " << SocketPath << ". Send SIGINT or SIGTERM to stop." << std::endl;
+
+    std::vector<epoll_event> events(maxEvents);
+    bool running = true;
+    while (running)
+    {
+        int n = epoll_wait(EpollFd, events.data(), maxEvents, -1);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error("epoll_wait failed.");
+        }
+        for (int i = 0; i < n; i++)
+        {
+            int fd = events[i].data.fd;
+            if (fd == ListenFd)
+                AcceptConnections();
+            else if (fd == SignalFd)
+                running = false;
+            else
+            {
+                auto it = Connections.find(fd);
+                if (it == Connections.end())
+                    continue;
+                bool keep = true;
+                if (events[i].events & EPOLLOUT)
+                    keep = FlushOutput(fd, it->second);
+                // Also after EPOLLOUT, sent responses may resume requests left unread by HandleReadable.
+                if (keep)
+                    keep = HandleReadable(fd);
+                if (!keep)
+                    CloseConnection(fd);
+            }
+        }
+    }
+
+    std::cout << StatsText() << std::endl;
+}
+
+void Daemon::AcceptConnections() noexcept
+{
+    while (true)
+    {
+        int fd = accept4(ListenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        if (epoll_ctl(EpollFd, EPOLL_CTL_ADD, fd, &ev) != 0)
+        {
+            close(fd);
+            continue;
+        }
+        Connections[fd].Events = ev.events;
+    }
+}
+
+bool Daemon::HandleReadable(int fd) noexcept
+{
+    Connection &con = Connections[fd];
+    char buffer[64 * 1024];
+    bool peerClosed = false;
+    while (true)
+    {
+        size_t offset = 0;
+        while (PendingOutput(con) < maxPendingOutput && con.In.size() - offset >= sizeof(FrameHeader))
+        {
+            FrameHeader header;
+            std::memcpy(&header, con.In.data() + offset, sizeof(header));
+            if (header.Length > MaxBodyLength)
+                return false;
+            if (con.In.size() - offset - sizeof(header) < header.Length)
+                break;
+            ProcessFrame(header, con.In.data() + offset + sizeof(header), con);
+            offset += sizeof(header) + header.Length;
+        }
+        con.In.erase(0, offset);
+
+        // A client that does not read its responses is not read from either, so neither buffer grows without bound.
+        if (peerClosed || PendingOutput(con) >= maxPendingOutput)
+            break;
+        ssize_t got = read(fd, buffer, sizeof(buffer));
+        if (got > 0)
+            con.In.append(buffer, got);
+        else if (got == 0)
+            peerClosed = true;
+        else if (errno == EINTR)
+            continue;
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+        else
+            return false;
+    }
+
+    if (!FlushOutput(fd, con))
+        return false;
+    return !peerClosed;
+}
+
+bool Daemon::FlushOutput(int fd, Connection &con) noexcept
+{
+    while (con.OutOffset < con.Out.size())
+    {
+        ssize_t sent = write(fd, con.Out.data() + con.OutOffset, con.Out.size() - con.OutOffset);
+        if (sent > 0)
+            con.OutOffset += sent;
+        else if (sent < 0 && errno == EINTR)
+            continue;
+        else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        else
+            return false;
+    }
+
+    bool pending = con.OutOffset < con.Out.size();
+    if (!pending)
+    {
+        con.Out.clear();
+        con.OutOffset = 0;
+    }
+    else if (con.OutOffset >= con.Out.size() / 2)
+    {
+        // Sent bytes are dropped once they are the bigger part, so a client always reading a bit late does not grow the buffer.
+        con.Out.erase(0, con.OutOffset);
+        con.OutOffset = 0;
+    }
+
+    // Over the limit the connection waits only for its output to drain, EPOLLRDHUP would be reported again and again.
+    uint32_t events = PendingOutput(con) >= maxPendingOutput ? (uint32_t)EPOLLOUT : EPOLLIN | EPOLLRDHUP | (pending ? (uint32_t)EPOLLOUT : 0u);
+    if (events != con.Events)
+    {
+        epoll_event ev = {};
+        ev.events = events;
+        ev.data.fd = fd;
+        epoll_ctl(EpollFd, EPOLL_CTL_MOD, fd, &ev);
+        con.Events = events;
+    }
+    return true;
+}
+
+void Daemon::ProcessFrame(const FrameHeader &header, const char *body, Connection &con) noexcept
+{
+    auto start = std::chrono::steady_clock::now();
+    try
+    {
+        std::string response = Execute(header, body, con);
+        AppendFrame(con.Out, header.Opcode, StatusOk, header.RequestID, response.data(), (uint32_t)response.size());
+    }
+    catch (const std::exception &e)
+    {
+        std::string msg = e.what();
+        AppendFrame(con.Out, header.Opcode, StatusError, header.RequestID, msg.data(), (uint32_t)msg.size());
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    Latency.Record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+std::string Daemon::Execute(const FrameHeader &header, const char *body, Connection &con)
+{
+    switch (header.Opcode)
+    {
+    case OpLoadKey:
+    {
+        if (con.Keys.size() >= maxKeysPerConnection)
+            throw std::runtime_error("Too many keys loaded, release some first.");
+        Enigma::UserSettings settings = ParseSettings(std::string(body, header.Length));
+        KeySlot slot = {Cache.Get(settings), Enigma::CompiledKey::PositionsOf(settings)};
+        uint32_t id = NextKeyID++;
+        con.Keys.emplace(id, slot);
+        return std::string(reinterpret_cast<const char *>(&id), sizeof(id));
+    }
+    case OpEncrypt:
+    case OpDecrypt:
+    {
+        // Enigma is reciprocal, so both operations are the same.
+        KeySlot &key = FindKey(con, body, header.Length);
+        if (header.Length < sizeof(uint32_t) + 3)
+            throw std::runtime_error("Missing start position.");
+        const char *startPos = body + sizeof(uint32_t);
+        if (startPos[0] != 0)
+        {
+            for (int i = 0; i < 3; i++)
+                if (startPos[i] < 'A' || startPos[i] > 'Z')
+                    throw std::runtime_error("Invalid start position.");
+            for (int i = 0; i < 3; i++)
+                key.Positions[i] = startPos[i] - 'A';
+        }
+        size_t textOffset = sizeof(uint32_t) + 3;
+        std::string text = key.Key->EncryptString(std::string(body + textOffset, header.Length - textOffset), key.Positions);
+        return PositionsText(key) + text;
+    }
+    case OpPosition:
+    {
+        return PositionsText(FindKey(con, body, header.Length));
+    }
+    case OpReleaseKey:
+    {
+        FindKey(con, body, header.Length);
+        con.Keys.erase(ReadU32(body));
+        return "";
+    }
+    case OpStats:
+        return StatsText();
+    default:
+        throw std::runtime_error("Unknown opcode.");
+    }
+}
+
+Daemon::KeySlot &Daemon::FindKey(Connection &con, const char *body, uint32_t length)
+{
+    if (length < sizeof(uint32_t))
+        throw std::runtime_error("Missing key id.");
+    auto it = con.Keys.find(ReadU32(body));
+    if (it == con.Keys.end())
+        throw std::runtime_error("Unknown key id.");
+    return it->second;
+}
+
+std::string Daemon::PositionsText(const KeySlot &key) noexcept
+{
+    std::string res(3, 'A');
+    for (int i = 0; i < 3; i++)
+        res[i] = (char)('A' + key.Positions[i]);
+    return res;
+}
+
+Enigma::UserSettings Daemon::ParseSettings(const std::string &text)
+{
+    // Arguments are passed to Encrypter as if they were typed in the terminal after "EnigmaCPP -d [socket]".
+    std::istringstream stream(text);
+    std::vector<std::string> tokens = {"EnigmaCPP", "-d", ""};
+    std::string token;
+    while (stream >> token)
+        tokens.push_back(token);
+    std::vector<char *> argv;
+    for (std::string &tok : tokens)
+        argv.push_back(&tok[0]);
+
+    // Settings are validated by compiling them in KeyCache::Get, converting them here would do it twice.
+    Encrypter parser((int)argv.size(), argv.data());
+    return parser.getSettings();
+}
+
+void Daemon::CloseConnection(int fd) noexcept
+{
+    epoll_ctl(EpollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    Connections.erase(fd);
+}
+
+std::string Daemon::StatsText() const noexcept
+{
+    Enigma::KeyCacheStats cache = Cache.getStats();
+    size_t keys = 0;
+    for (const auto &con : Connections)
+        keys += con.second.Keys.size();
+    char line[384];
+    std::snprintf(line, sizeof(line), "requests=%llu p50_us=%.2f p99_us=%.2f max_us=%.2f keys=%zu connections=%zu "
+                  "cache_hits=%llu cache_misses=%llu cache_evictions=%llu",
+                  (unsigned long long)Latency.getCount(), Latency.Percentile(0.50) / 1000.0, Latency.Percentile(0.99) / 1000.0,
+                  Latency.getMax() / 1000.0, keys, Connections.size(),
+                  (unsigned long long)cache.Hits, (unsigned long long)cache.Misses, (unsigned long long)cache.Evictions);
+    return line;
+}
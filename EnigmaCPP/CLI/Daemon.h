@@ -0,0 +1,245 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include "include/EnigmaCPP.h"
+#include "include/KeyCache.h"
+#include "DaemonProtocol.h"
+#include "LatencyHistogram.h"
+
+namespace EnigmaCLI
+{
+    /**
+     * Handles -d flag.
+     *
+     * Long-running server listening on a Unix domain socket.
+     * Connections are multiplexed by a single epoll loop, loaded keys are kept
+     * in memory across requests and released when their connection is closed.
+     * Compiled keys are shared by all connections through the cache. Protocol is described in DaemonProtocol.h.
+    */
+    class Daemon
+    {
+    public:
+        /**
+         * Constructor.
+         *
+         * Creates, binds and starts listening on the socket.
+         * If the file under @socketPath already exists, it will be replaced.
+         *
+         * Params:
+         * const char* socketPath - path of the Unix socket.
+         *
+         * Exceptions:
+         * If socket, epoll or signal handling cannot be set up, an exception will be thrown.
+        */
+        Daemon(const char* socketPath) noexcept(false);
+
+        /* Destructor. Closes all connections and removes the socket file. */
+        ~Daemon() noexcept;
+
+        Daemon(const Daemon&) = delete;
+        Daemon& operator=(const Daemon&) = delete;
+
+        /**
+         * Serves requests until SIGINT or SIGTERM is received.
+         * Afterwards latency statistics are printed to std::cout.
+         *
+         * Exceptions:
+         * If epoll fails, an exception will be thrown.
+        */
+        void Run() noexcept(false);
+
+    private:
+        /* Key loaded by OpLoadKey. */
+        struct KeySlot
+        {
+            /* Compiled key, shared with the cache and other slots using the same settings. */
+            std::shared_ptr<const Enigma::CompiledKey> Key;
+
+            /* Current rotors position of the key. */
+            Enigma::RotorPositions Positions;
+        };
+
+        /* State of a single client connection. */
+        struct Connection
+        {
+            /* Received, not yet processed bytes. */
+            std::string In;
+
+            /* Responses waiting to be sent. */
+            std::string Out;
+
+            /* Number of bytes of @Out already sent. */
+            size_t OutOffset = 0;
+
+            /* Events the connection is registered for. */
+            uint32_t Events = 0;
+
+            /* Keys loaded by this connection by key id, released on close. */
+            std::unordered_map<uint32_t, KeySlot> Keys;
+        };
+
+        /* Memory budget of the compiled keys cache. */
+        static const size_t keyCacheBudget = 64 * 1024 * 1024;
+
+        /* Max number of keys loaded by one connection at a time. */
+        static const size_t maxKeysPerConnection = 1024;
+
+        /* Bytes of unsent responses above which requests of a connection are not read nor processed. */
+        static const size_t maxPendingOutput = 4 * 1024 * 1024;
+
+        /* Max number of events handled by one epoll_wait call. */
+        static const int maxEvents = 256;
+
+        /* Path of the socket file. */
+        std::string SocketPath;
+
+        /* Listening socket. */
+        int ListenFd;
+
+        /* Epoll instance. */
+        int EpollFd;
+
+        /* signalfd receiving SIGINT and SIGTERM. */
+        int SignalFd;
+
+        /* Open connections by file descriptor. */
+        std::unordered_map<int, Connection> Connections;
+
+        /* Compiled keys by settings, loading an already used key skips the conversion. */
+        Enigma::KeyCache Cache;
+
+        /* Id that will be given to the next loaded key. */
+        uint32_t NextKeyID;
+
+        /* Service time of processed requests. */
+        LatencyHistogram Latency;
+
+        /* Accepts all pending connections. */
+        void AcceptConnections() noexcept;
+
+        /**
+         * Reads available data, processes complete frames and sends responses.
+         * Once @maxPendingOutput bytes of responses wait to be sent, the rest is left unread until they are sent.
+         *
+         * Params:
+         * int fd - connection descriptor.
+         *
+         * Returns:
+         * bool - false if the connection should be closed.
+        */
+        bool HandleReadable(int fd) noexcept;
+
+        /**
+         * Sends as much of the pending responses as possible and updates the events the connection is registered for.
+         *
+         * Params:
+         * int fd - connection descriptor.
+         * Connection& con - connection state.
+         *
+         * Returns:
+         * bool - false if the connection should be closed.
+        */
+        bool FlushOutput(int fd, Connection& con) noexcept;
+
+        /**
+         * Processes a single request and appends the response to the output of the connection.
+         *
+         * Params:
+         * const Protocol::FrameHeader& header - header of the request.
+         * const char* body - body of the request.
+         * Connection& con - connection the request came from.
+        */
+        void ProcessFrame(const Protocol::FrameHeader& header, const char* body, Connection& con) noexcept;
+
+        /**
+         * Executes a request.
+         *
+         * Params:
+         * const Protocol::FrameHeader& header - header of the request.
+         * const char* body - body of the request.
+         * Connection& con - connection the request came from.
+         *
+         * Exceptions:
+         * If the request is malformed, refers to an unknown key or the connection has too many keys loaded, an exception will be thrown.
+         *
+         * Returns:
+         * std::string - body of the response.
+        */
+        std::string Execute(const Protocol::FrameHeader& header, const char* body, Connection& con) noexcept(false);
+
+        /**
+         * Finds a key loaded by a connection.
+         *
+         * Params:
+         * Connection& con - connection.
+         * const char* body - body starting with a key id.
+         * uint32_t length - length of the body.
+         *
+         * Exceptions:
+         * If body is too short or key is not loaded by @con, an exception will be thrown.
+         *
+         * Returns:
+         * KeySlot& - found key.
+        */
+        static KeySlot& FindKey(Connection& con, const char* body, uint32_t length) noexcept(false);
+
+        /**
+         * Returns number of response bytes waiting to be sent.
+         *
+         * Params:
+         * const Connection& con - connection.
+         *
+         * Returns:
+         * size_t - unsent bytes of @con.Out.
+        */
+        static size_t PendingOutput(const Connection& con) noexcept { return con.Out.size() - con.OutOffset; }
+
+        /**
+         * Returns current rotors position of a key as letters.
+         *
+         * Params:
+         * const KeySlot& key - loaded key.
+         *
+         * Returns:
+         * std::string - 3 letters from left to right.
+        */
+        static std::string PositionsText(const KeySlot& key) noexcept;
+
+        /**
+         * Builds UserSettings from text with the same arguments order as CLI.
+         *
+         * Params:
+         * const std::string& text - settings, e.g. "B I II III C B D F G D AZ BC".
+         *
+         * Exceptions:
+         * If the arguments cannot be parsed, an exception will be thrown. Settings themselves are validated by KeyCache::Get.
+         *
+         * Returns:
+         * Enigma::UserSettings - parsed settings.
+        */
+        static Enigma::UserSettings ParseSettings(const std::string& text) noexcept(false);
+
+        /**
+         * Closes a connection and releases its keys.
+         *
+         * Params:
+         * int fd - connection descriptor.
+        */
+        void CloseConnection(int fd) noexcept;
+
+        /**
+         * Returns statistics in human readable form.
+         *
+         * Returns:
+         * std::string - statistics.
+        */
+        std::string StatsText() const noexcept;
+    };
+}
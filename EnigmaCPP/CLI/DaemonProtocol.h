@@ -0,0 +1,106 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace EnigmaCLI
+{
+    /**
+     * Binary framing used between the daemon (-d flag) and its clients.
+     *
+     * Every message (request or response) is a FrameHeader followed by Length bytes of body.
+     * Integers are sent in host byte order, the protocol is only spoken over local Unix sockets.
+     *
+     * Request bodies:
+     * OpLoadKey     - settings as text, same order as CLI arguments, e.g. "B I II III C B D F G D AZ BC".
+     * OpEncrypt     - uint32 key id, 3 bytes start position ('A'-'Z', or 0 to continue), text.
+     * OpDecrypt     - same as OpEncrypt.
+     * OpPosition    - uint32 key id.
+     * OpReleaseKey  - uint32 key id.
+     * OpStats       - empty.
+     *
+     * Response bodies (Status == StatusOk):
+     * OpLoadKey     - uint32 key id.
+     * OpEncrypt     - 3 bytes final rotors position, text.
+     * OpDecrypt     - same as OpEncrypt.
+     * OpPosition    - 3 bytes current rotors position.
+     * OpReleaseKey  - empty.
+     * OpStats       - statistics as text.
+     *
+     * If Status == StatusError the body holds an error message.
+     *
+     * A key id is valid only on the connection that loaded it (at most 1024 keys at a time),
+     * keys are released when their connection is closed. Requests of a client that does not read
+     * its responses are left unread once 4 MiB of responses wait to be sent.
+    */
+    namespace Protocol
+    {
+        enum Opcode : uint8_t { OpLoadKey = 1, OpEncrypt = 2, OpDecrypt = 3, OpPosition = 4, OpReleaseKey = 5, OpStats = 6 };
+
+        enum Status : uint8_t { StatusOk = 0, StatusError = 1 };
+
+        /* Max accepted body length. Bigger frames close the connection. */
+        const uint32_t MaxBodyLength = 16 * 1024 * 1024;
+
+        /* Header preceding every frame. */
+        struct FrameHeader
+        {
+            /* Length of the body in bytes. */
+            uint32_t Length;
+
+            /* Requested operation (echoed in the response). */
+            uint8_t Opcode;
+
+            /* StatusOk or StatusError, zero in requests. */
+            uint8_t Status;
+
+            /* Unused, should be zero. */
+            uint16_t Reserved;
+
+            /* Chosen by the client, echoed in the response. */
+            uint32_t RequestID;
+        };
+
+        static_assert(sizeof(FrameHeader) == 12, "FrameHeader must be packed to 12 bytes.");
+
+        /**
+         * Appends a whole frame to the buffer.
+         *
+         * Params:
+         * std::string& out - buffer to be appended.
+         * uint8_t op - opcode.
+         * uint8_t status - status.
+         * uint32_t requestID - request id.
+         * const char* body - body of the frame.
+         * uint32_t length - length of the body.
+        */
+        inline void AppendFrame(std::string& out, uint8_t op, uint8_t status, uint32_t requestID, const char* body, uint32_t length) noexcept
+        {
+            FrameHeader header = {length, op, status, 0, requestID};
+            out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.append(body, length);
+        }
+
+        /**
+         * Reads uint32 from unaligned memory.
+         *
+         * Params:
+         * const char* src - source.
+         *
+         * Returns:
+         * uint32_t - read value.
+        */
+        inline uint32_t ReadU32(const char* src) noexcept
+        {
+            uint32_t val;
+            std::memcpy(&val, src, sizeof(val));
+            return val;
+        }
+    }
+}
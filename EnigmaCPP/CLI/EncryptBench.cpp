@@ -0,0 +1,320 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+/**
+ * Benchmarks of encryption, run by `make bench`.
+ *
+ * Micro: Encoder::EncryptChar, Encoder::EncryptString (short, medium and long texts), Encoder constructor,
+ *        Encoder::setNewSettings and SettingsConversion::ConvertToEnigmaSettings.
+ * Macro: Encrypter::EncryptFile on generated files of 1, 16, 256 and 4096 MB, up to --max-size.
+ *
+ * Reports ns/call, ns/char, MB/s, heap allocations per call (counted by the global operator new of this program)
+ * and resident memory. --json writes the results, --baseline compares them with an earlier JSON file
+ * and flags every result slower (or allocating more) than the baseline by more than --tolerance.
+ * Exit code is 2 if a regression is found.
+*/
+
+#include "Encrypter.h"
+#include "include/EnigmaCPP.h"
+#include "include/SettingsConversion.h"
+
+#include <new>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <filesystem>
+
+#include <unistd.h>
+#include <sys/resource.h>
+
+typedef std::chrono::steady_clock Clock;
+
+/* Heap allocations of the whole program. */
+static std::atomic<uint64_t> allocations(0);
+
+void *operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+/* One measured operation. */
+struct BenchResult
+{
+    /* Name of the operation. */
+    std::string Name;
+
+    /* Characters per call, 0 for operations not processing text. */
+    uint64_t Size;
+
+    /* Number of calls. */
+    uint64_t Calls;
+
+    /* Wall time of all calls in seconds. */
+    double Seconds;
+
+    /* Heap allocations per call. */
+    double AllocsPerCall;
+
+    /* Resident memory after the calls and peak resident memory of the program in KB. */
+    uint64_t RssKB;
+    uint64_t PeakRssKB;
+
+    double NsPerCall() const { return Seconds * 1e9 / Calls; }
+    double NsPerChar() const { return Size ? NsPerCall() / Size : 0; }
+    double MBPerSecond() const { return Size ? Size * (double)Calls / Seconds / (1024.0 * 1024.0) : 0; }
+};
+
+/* Returns current resident memory in KB. */
+uint64_t CurrentRssKB()
+{
+    std::ifstream statm("/proc/self/statm");
+    uint64_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * (uint64_t)sysconf(_SC_PAGESIZE) / 1024;
+}
+
+/* Returns peak resident memory in KB. */
+uint64_t PeakRssKB()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (uint64_t)usage.ru_maxrss;
+}
+
+/* Calls @op in batches, doubling the batch until it takes at least @minSeconds. */
+template <typename F>
+BenchResult Measure(const std::string &name, uint64_t size, F op, double minSeconds = 0.2)
+{
+    op();
+    for (uint64_t calls = 1;; calls *= 2)
+    {
+        uint64_t allocsBefore = allocations.load(std::memory_order_relaxed);
+        auto begin = Clock::now();
+        for (uint64_t i = 0; i < calls; i++)
+            op();
+        double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+        uint64_t allocs = allocations.load(std::memory_order_relaxed) - allocsBefore;
+        if (seconds >= minSeconds || calls >= ((uint64_t)1 << 40))
+            return {name, size, calls, seconds, (double)allocs / calls, CurrentRssKB(), PeakRssKB()};
+    }
+}
+
+/* Generates a file of random letters, spaces and new lines. */
+void GenerateFile(const std::string &path, uint64_t size)
+{
+    std::ofstream out(path, std::ios::binary);
+    std::vector<char> block(1024 * 1024);
+    uint64_t state = 2023;
+    for (char &c : block)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint32_t r = (uint32_t)(state >> 33) % 32;
+        c = r < 26 ? (char)('A' + r) : r < 31 ? ' ' : '\n';
+    }
+    for (uint64_t done = 0; done < size; done += block.size())
+        out.write(block.data(), (std::streamsize)std::min<uint64_t>(block.size(), size - done));
+    if (!out.good())
+        throw std::runtime_error("Error while writing to a file.");
+}
+
+/* Reads a number field of a JSON record written by WriteJson, -1 if absent. */
+double Field(const std::string &record, const std::string &key)
+{
+    size_t pos = record.find("\"" + key + "\": ");
+    if (pos == std::string::npos)
+        return -1;
+    return std::strtod(record.c_str() + pos + key.size() + 4, nullptr);
+}
+
+/* Reads a string field of a JSON record written by WriteJson. */
+std::string StringField(const std::string &record, const std::string &key)
+{
+    size_t pos = record.find("\"" + key + "\": \"");
+    if (pos == std::string::npos)
+        return "";
+    pos += key.size() + 5;
+    return record.substr(pos, record.find('"', pos) - pos);
+}
+
+void WriteJson(const std::string &path, const std::vector<BenchResult> &results)
+{
+    std::ostringstream json;
+    json << "{\n  \"benchmark\": \"encryption\",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult &res = results[i];
+        char line[512];
+        std::snprintf(line, sizeof(line),
+                      "    {\"name\": \"%s\", \"size\": %llu, \"calls\": %llu, \"nsPerCall\": %.3f, \"nsPerChar\": %.4f, \"mbPerSecond\": %.2f, "
+                      "\"allocsPerCall\": %.3f, \"rssKB\": %llu, \"peakRssKB\": %llu}%s\n",
+                      res.Name.c_str(), (unsigned long long)res.Size, (unsigned long long)res.Calls, res.NsPerCall(), res.NsPerChar(),
+                      res.MBPerSecond(), res.AllocsPerCall, (unsigned long long)res.RssKB, (unsigned long long)res.PeakRssKB,
+                      i + 1 < results.size() ? "," : "");
+        json << line;
+    }
+    json << "  ]\n}\n";
+    std::ofstream out(path);
+    out << json.str();
+    if (!out.good())
+        throw std::runtime_error("Error while writing to a file.");
+}
+
+/* Compares results with a baseline, returns number of regressions. */
+int Compare(const std::string &path, const std::vector<BenchResult> &results, double tolerance)
+{
+    std::ifstream in(path);
+    if (!in.good())
+        throw std::runtime_error("Error while reading file.");
+    std::vector<std::string> records;
+    std::string line;
+    while (std::getline(in, line))
+        if (line.find("\"name\": ") != std::string::npos)
+            records.push_back(line);
+
+    std::printf("\nComparison with %s (tolerance %.0f%%):\n", path.c_str(), tolerance * 100);
+    std::printf("%-28s %12s %12s %12s %9s %9s\n", "operation", "size", "baseline ns", "ns", "change", "allocs");
+    int regressions = 0;
+    for (const BenchResult &res : results)
+        for (const std::string &record : records)
+        {
+            if (StringField(record, "name") != res.Name || (uint64_t)Field(record, "size") != res.Size)
+                continue;
+            double baseNs = Field(record, "nsPerCall"), baseAllocs = Field(record, "allocsPerCall");
+            bool slower = res.NsPerCall() > baseNs * (1 + tolerance);
+            bool moreAllocs = res.AllocsPerCall > baseAllocs + 0.5;
+            std::printf("%-28s %12llu %12.1f %12.1f %+8.1f%% %+9.2f%s\n", res.Name.c_str(), (unsigned long long)res.Size, baseNs, res.NsPerCall(),
+                        100.0 * (res.NsPerCall() / baseNs - 1), res.AllocsPerCall - baseAllocs,
+                        slower || moreAllocs ? "  REGRESSION" : "");
+            regressions += slower || moreAllocs;
+        }
+    return regressions;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string jsonPath, baselinePath, directory = "/tmp";
+    double tolerance = 0.10;
+    uint64_t maxSize = 256;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--json")
+            jsonPath = argv[++i];
+        else if (i + 1 < argc && arg == "--baseline")
+            baselinePath = argv[++i];
+        else if (i + 1 < argc && arg == "--tolerance")
+            tolerance = std::atof(argv[++i]);
+        else if (i + 1 < argc && arg == "--max-size")
+            maxSize = std::strtoull(argv[++i], nullptr, 10);
+        else if (i + 1 < argc && arg == "--dir")
+            directory = argv[++i];
+        else
+        {
+            std::printf("EnigmaEncryptBench (--json output path) (--baseline JSON path) (--tolerance 0.10) (--max-size MB = 256, up to 4096) (--dir files directory = /tmp)\n");
+            return 0;
+        }
+    }
+
+    try
+    {
+        const Enigma::UserSettings settings(Enigma::B, {Enigma::UserRotor(Enigma::I, 'C', 'D'), Enigma::UserRotor(Enigma::II, 'B', 'F'),
+                                            Enigma::UserRotor(Enigma::III, 'D', 'G')}, {"AZ", "BC"});
+        const Enigma::UserSettings other(Enigma::C, {Enigma::UserRotor(Enigma::IV, 'A', 'A'), Enigma::UserRotor(Enigma::V, 'Q', 'E'),
+                                         Enigma::UserRotor(Enigma::I, 'Z', 'K')}, {"QW", "ER", "TY"});
+        std::vector<BenchResult> results;
+
+        Enigma::Encoder encoder(settings);
+        volatile char sink = 0;
+        results.push_back(Measure("EncryptChar", 1, [&] { sink = encoder.EncryptChar('E'); }));
+        for (uint64_t length : {64, 4096, 1024 * 1024})
+        {
+            std::string text(length, 'A');
+            for (uint64_t i = 0; i < length; i++)
+                text[i] = i % 7 == 6 ? ' ' : (char)('A' + i * 7 % 26);
+            results.push_back(Measure("EncryptString", length, [&] { sink = encoder.EncryptString(text)[0]; }));
+        }
+        results.push_back(Measure("Encoder", 0, [&] { Enigma::Encoder en(settings); sink = en.EncryptChar('A'); }));
+        bool flip = false;
+        results.push_back(Measure("setNewSettings", 0, [&] { encoder.setNewSettings((flip = !flip) ? other : settings); }));
+        results.push_back(Measure("ConvertToEnigmaSettings", 0, [&] { Enigma::SettingsConversion::ConvertToEnigmaSettings(settings); }));
+
+        // EncryptFile reports on std::cout, which is redirected; progress is off by default.
+        std::ostringstream discard;
+        for (uint64_t mb : {1, 16, 256, 4096})
+        {
+            if (mb > maxSize)
+                break;
+            std::string path = directory + "/EnigmaEncryptBench." + std::to_string(getpid()) + "." + std::to_string(mb) + ".txt";
+            GenerateFile(path, mb * 1024 * 1024);
+            BenchResult res = Measure("EncryptFile", mb * 1024 * 1024, [&] {
+                const char *args[] = {"EnigmaCPP", "-e", path.c_str(), "B", "I", "II", "III", "C", "B", "D", "F", "G", "D", "AZ", "BC"};
+                EnigmaCLI::Encrypter encrypter(15, const_cast<char **>(args));
+                std::streambuf *out = std::cout.rdbuf(discard.rdbuf());
+                encrypter.EncryptFile(path.c_str());
+                std::cout.rdbuf(out);
+                discard.str("");
+                // Every call makes a new copy, only the first name is reused.
+                std::filesystem::path copy = std::filesystem::path(path).replace_extension("");
+                std::filesystem::remove(copy.string() + " (encrypted).txt");
+            }, 0);
+            std::filesystem::remove(path);
+            results.push_back(res);
+        }
+
+        std::printf("%-28s %12s %12s %12s %10s %10s %10s %10s\n", "operation", "size", "calls", "ns/call", "ns/char", "MB/s", "allocs", "RSS KB");
+        for (const BenchResult &res : results)
+            std::printf("%-28s %12llu %12llu %12.1f %10.3f %10.1f %10.2f %10llu\n", res.Name.c_str(), (unsigned long long)res.Size,
+                        (unsigned long long)res.Calls, res.NsPerCall(), res.NsPerChar(), res.MBPerSecond(), res.AllocsPerCall,
+                        (unsigned long long)res.RssKB);
+        std::printf("Peak RSS: %llu KB.\n", (unsigned long long)PeakRssKB());
+
+        if (!jsonPath.empty())
+            WriteJson(jsonPath, results);
+        if (!baselinePath.empty() && Compare(baselinePath, results, tolerance) != 0)
+            return 2;
+    }
+    catch (const std::exception &e)
+    {
+        std::printf("%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -4,18 +4,64 @@
 */
 
 #include "Encrypter.h"
+#include "include/IndicatorProcedure.h"
+#include "include/Instrumentation.h"
 
 #include <vector>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <cstdio>
+#include <cstring>
 #include <stdexcept>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <filesystem>
 
+#include <unistd.h>
+
 #define MB 1048576
 #define KB 1024
 
 using namespace EnigmaCLI;
 
+namespace
+{
+    /* Blocks read between two checks of the clock for progress reports. */
+    const unsigned progressCheckBlocks = 64;
+
+    /* Seconds between progress reports. */
+    const double progressInterval = 1.0;
+
+    /* Returns CPU time of the process in seconds. */
+    double CpuSeconds()
+    {
+        return (double)std::clock() / CLOCKS_PER_SEC;
+    }
+
+    /**
+     * Removes options following program name, command and path (or string) from arguments.
+     * @take(i) returns the number of arguments used from argv[i] on, 0 keeps argv[i].
+     * argc is never raised, so argv is not written past its end.
+     */
+    template <typename Take>
+    void RemoveOptions(int& argc, char *argv[], Take take)
+    {
+        int kept = std::min(argc, 3);
+        for (int i = kept; i < argc; i++)
+        {
+            int used = take(i);
+            if (used == 0)
+                argv[kept++] = argv[i];
+            else
+                i += used - 1;
+        }
+        argv[kept] = nullptr;
+        argc = kept;
+    }
+}
+
 Encrypter::Encrypter(int argc, char *argv[])
 {
     if (argc < minNumberOfArgs || argc > maxNumberOfArgs)
@@ -23,6 +69,79 @@ Encrypter::Encrypter(int argc, char *argv[])
     ChangeSettings(argc, argv);
 }
 
+std::string Encrypter::JsonString(const std::string& text) noexcept
+{
+    std::string res = "\"";
+    for (unsigned char c : text)
+    {
+        if (c == '"' || c == '\\')
+            res += '\\';
+        if (c < 0x20)
+        {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            res += code;
+        }
+        else
+            res += (char)c;
+    }
+    return res + '"';
+}
+
+EncryptOptions Encrypter::ExtractOptions(int& argc, char *argv[])
+{
+    EncryptOptions res;
+    res.Progress = isatty(STDERR_FILENO);
+    RemoveOptions(argc, argv, [&](int i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0)
+            return 0;
+        if (arg == "--progress")
+            res.Progress = true;
+        else if (arg == "--no-progress")
+            res.Progress = false;
+        else if ((arg == "--max-size" || arg == "--stats-json") && i + 1 < argc)
+        {
+            std::string value = argv[i + 1];
+            if (arg == "--stats-json")
+                res.StatsJsonPath = value;
+            else
+            {
+                size_t end = 0;
+                unsigned long long size = 0;
+                try
+                {
+                    size = std::stoull(value, &end);
+                }
+                catch (const std::exception&)
+                {
+                    end = 0;
+                }
+                if (end != value.size() || size == 0)
+                    throw std::runtime_error("Invalid value of --max-size.");
+                res.MaxSize = (uintmax_t)size * MB;
+            }
+            return 2;
+        }
+        else
+            throw std::runtime_error("Unknown option or missing value: " + arg);
+        return 1;
+    });
+    return res;
+}
+
+bool Encrypter::ExtractDoubled(int& argc, char *argv[]) noexcept
+{
+    bool doubled = false;
+    RemoveOptions(argc, argv, [&](int i) {
+        if (std::string(argv[i]) != "--doubled")
+            return 0;
+        doubled = true;
+        return 1;
+    });
+    return doubled;
+}
+
 void Encrypter::ChangeSettings(int argc, char *argv[])
 {
     settings = BuildUserSettings(argc, argv);
@@ -71,8 +190,10 @@ void Encrypter::printRotorsPosition(const Enigma::Encoder& en) noexcept
     std::cout << rotFinal[0] << rotFinal[1] << rotFinal[2];
 }
 
-void Encrypter::EncryptString(const char *orgText) noexcept
+void Encrypter::EncryptString(const char *orgText)
 {
+    const auto start = std::chrono::steady_clock::now();
+    const double cpuStart = CpuSeconds();
     Enigma::Encoder en(settings);
     std::cout << "Creating encrypted message...\n";
     std::string enText = en.EncryptString(orgText);
@@ -80,6 +201,14 @@ void Encrypter::EncryptString(const char *orgText) noexcept
               << enText << '\n'
               << std::endl;
     std::cout << "Final rotors position: "; printRotorsPosition(en); std::cout << std::endl;   
+
+    RunStats stats;
+    stats.Command = "-s";
+    stats.BytesIn = std::strlen(orgText);
+    stats.BytesOut = enText.size();
+    stats.WallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.CpuSeconds = CpuSeconds() - cpuStart;
+    WriteStats(stats, en);
 }
 
 
@@ -89,23 +218,8 @@ void Encrypter::EncryptFile(const char *filePath)
     if (!file.good())
         throw std::runtime_error("Error while reading file.");
     uintmax_t fileLength = std::filesystem::file_size(std::filesystem::path(filePath));
-    if (fileLength > 50 * MB)
-    {
-        std::string ans;
-        do
-        {
-            std::cout << "The file is bigger than 50MB, the encryption can take a while. Do you still wish to continue? [Y/n]:" << std::endl;
-            std::cin >> ans;
-            if (ans.size() != 1)
-                continue;
-            ans[0] = std::toupper(ans[0]);
-        } while (ans[0] != 'N' && ans[0] != 'Y');
-        if (ans[0] == 'N')
-        {
-            file.close();
-            return;
-        }
-    }
+    if (options.MaxSize != 0 && fileLength > options.MaxSize)
+        throw std::runtime_error("The file is bigger than --max-size.");
 
     std::string outFilepath = provideEncryptedFilepathPretendent(filePath);
     std::ofstream outFile(outFilepath, std::ios::binary);
@@ -118,28 +232,168 @@ void Encrypter::EncryptFile(const char *filePath)
     std::vector<char> buffer(bufferSize);
 
     std::cout << "Creating encrypted copy..." << std::endl;
+
+    const auto start = std::chrono::steady_clock::now();
+    const double cpuStart = CpuSeconds();
+    auto nextReport = start + std::chrono::duration<double>(progressInterval);
+    uintmax_t bytesOut = 0;
     
     const uintmax_t noBlocks = fileLength / bufferSize;
     const uintmax_t restofDataSize = fileLength % bufferSize;
 
-    for(int i = 0; i < noBlocks; i++)
+    for(uintmax_t i = 0; i <= noBlocks; i++)
     {
-        file.read(reinterpret_cast<char *>(buffer.data()), bufferSize);
-        outFile << en.EncryptString(std::string(buffer.begin(), buffer.end()));
-    }
+        const unsigned blockSize = i < noBlocks ? bufferSize : restofDataSize;
+        if (blockSize == 0)
+            break;
+        {
+            ENIGMA_SCOPED_TIMER(PhaseFileRead);
+            file.read(reinterpret_cast<char *>(buffer.data()), blockSize);
+        }
+        ENIGMA_COUNT(BytesRead, blockSize);
+        std::string enText = en.EncryptString(std::string(buffer.begin(), buffer.begin() + blockSize));
+        {
+            ENIGMA_SCOPED_TIMER(PhaseFileWrite);
+            outFile << enText;
+        }
+        ENIGMA_COUNT(BytesWritten, enText.size());
+        bytesOut += enText.size();
 
-    if(restofDataSize != 0)
-    {
-        file.read(reinterpret_cast<char *>(buffer.data()), restofDataSize);
-        outFile << en.EncryptString(std::string(buffer.begin(), buffer.begin() + restofDataSize));
+        // The clock is read once per progressCheckBlocks blocks, so reports cost nothing per block.
+        if (options.Progress && i % progressCheckBlocks == progressCheckBlocks - 1)
+        {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= nextReport)
+            {
+                ReportProgress((uintmax_t)(i + 1) * bufferSize, fileLength, std::chrono::duration<double>(now - start).count());
+                nextReport = now + std::chrono::duration<double>(progressInterval);
+            }
+        }
     }
 
     outFile.flush();
     file.close();
     outFile.close();
 
+    if (!outFile.good())
+        throw std::runtime_error("Error while writing to a file.");
+
+    RunStats stats;
+    stats.Command = "-e";
+    stats.Input = filePath;
+    stats.Output = outFilepath;
+    stats.BytesIn = fileLength;
+    stats.BytesOut = bytesOut;
+    stats.WallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.CpuSeconds = CpuSeconds() - cpuStart;
+    if (options.Progress)
+        ReportProgress(fileLength, fileLength, stats.WallSeconds);
+
     std::cout << "Done. File saved under name: " << outFilepath << std::endl;
     std::cout << "Final rotors position: "; printRotorsPosition(en); std::cout << std::endl;   
+    WriteStats(stats, en);
+}
+
+void Encrypter::ReportProgress(uintmax_t done, uintmax_t total, double seconds) noexcept
+{
+    double speed = seconds > 0 ? done / seconds : 0;
+    double percent = total ? 100.0 * done / total : 100.0;
+    long long eta = speed > 0 ? (long long)((total - done) / speed + 0.5) : 0;
+    std::fprintf(stderr, "Progress: %5.1f%% %.1f / %.1f MB, %.1f MB/s, ETA %lld:%02lld:%02lld\n", percent, (double)done / MB,
+                 (double)total / MB, speed / MB, eta / 3600, eta / 60 % 60, eta % 60);
+}
+
+void Encrypter::WriteStats(const RunStats& stats, const Enigma::Encoder& en)
+{
+#ifdef ENIGMA_INSTRUMENTATION
+    std::string instrumentation = Enigma::Instrumentation::Collect().ToJson();
+    if (options.StatsJsonPath.empty())
+        std::cerr << instrumentation << std::endl;
+#endif
+    if (options.StatsJsonPath.empty())
+        return;
+
+    auto rotors = en.ReturnRotorsPosition();
+    std::ostringstream json;
+    json << "{\n  \"command\": " << JsonString(stats.Command)
+         << ",\n  \"input\": " << JsonString(stats.Input)
+         << ",\n  \"output\": " << JsonString(stats.Output)
+         << ",\n  \"bytesIn\": " << stats.BytesIn
+         << ",\n  \"bytesOut\": " << stats.BytesOut
+         << ",\n  \"lettersEncrypted\": " << stats.BytesOut
+         << ",\n  \"wallSeconds\": " << stats.WallSeconds
+         << ",\n  \"cpuSeconds\": " << stats.CpuSeconds
+         << ",\n  \"megabytesPerSecond\": " << (stats.WallSeconds > 0 ? stats.BytesIn / stats.WallSeconds / MB : 0)
+         << ",\n  \"finalRotorsPosition\": " << JsonString(std::string(rotors.begin(), rotors.end()));
+#ifdef ENIGMA_INSTRUMENTATION
+    json << ",\n  \"instrumentation\": " << instrumentation;
+#endif
+    json << "\n}\n";
+
+    std::ofstream out(options.StatsJsonPath);
+    out << json.str();
+    if (!out.good())
+        throw std::runtime_error("Error while writing to a file.");
+}
+
+void Encrypter::ProcessIndicatorBatch(const char *filePath, bool encrypt, bool doubled)
+{
+    std::ifstream file(filePath);
+    if (!file.good())
+        throw std::runtime_error("Error while reading file.");
+
+    std::vector<Enigma::IndicatorMessage> messages;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        size_t keyBegin = line.find_first_not_of(" \t\r");
+        size_t keyEnd = line.find_first_of(" \t\r", keyBegin);
+        Enigma::IndicatorMessage msg;
+        if (keyBegin != std::string::npos)
+        {
+            msg.Key = line.substr(keyBegin, keyEnd - keyBegin);
+            if (keyEnd != std::string::npos)
+                msg.Body = line.substr(keyEnd);
+        }
+        messages.push_back(msg);
+    }
+    if (file.bad())
+        throw std::runtime_error("Error while reading file.");
+    file.close();
+
+    Enigma::IndicatorProcedure procedure(settings, doubled);
+    Enigma::ThreadPool pool;
+
+    std::cout << "Processing " << messages.size() << " messages..." << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Enigma::IndicatorResult> results = procedure.ProcessBatch(messages, encrypt, pool);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::string outFilepath = provideEncryptedFilepathPretendent(filePath);
+    std::ofstream outFile(outFilepath);
+    if (!outFile.good())
+        throw std::runtime_error("Error while writing to a file.");
+
+    size_t failed = 0;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        if (messages[i].Key.empty())
+            outFile << '\n';
+        else if (results[i].Error != nullptr)
+        {
+            outFile << "ERROR " << results[i].Error << '\n';
+            failed++;
+        }
+        else if (encrypt)
+            outFile << results[i].Indicator << ' ' << results[i].Body << '\n';
+        else
+            outFile << results[i].MessageKey << ' ' << results[i].Body << '\n';
+    }
+    outFile.close();
+    if (outFile.fail())
+        throw std::runtime_error("Error while writing to a file.");
+
+    std::cout << "Done in " << ms << " ms, " << failed << " messages failed. File saved under name: " << outFilepath << std::endl;
 }
 
 std::string Encrypter::provideEncryptedFilepathPretendent(const char *orgF)
@@ -6,11 +6,25 @@
 #pragma once
 
 #include <string>
+#include <cstdint>
 
 #include "include/EnigmaCPP.h"
 
 namespace EnigmaCLI
 {
+    /* Options of -e and -s, given as flags after the settings. */
+    struct EncryptOptions
+    {
+        /* Files bigger than this (in bytes) are refused, 0 - no limit. */
+        uintmax_t MaxSize = 0;
+
+        /* True to report progress of -e on stderr. */
+        bool Progress = false;
+
+        /* Path of the JSON file with statistics of the run, empty - none. */
+        std::string StatsJsonPath;
+    };
+
     /* Class for handling program logic: flags, communication and encryption. */
     class Encrypter
     {
@@ -104,9 +118,60 @@ namespace EnigmaCLI
         */
         void printRotorsPosition(const Enigma::Encoder& en) noexcept;
 
+        /* Statistics of a -e or -s run. */
+        struct RunStats
+        {
+            /* Flag of the run, "-e" or "-s". */
+            std::string Command;
+
+            /* Path of the input file, empty for -s. */
+            std::string Input;
+
+            /* Path of the output file, empty for -s. */
+            std::string Output;
+
+            /* Size of the input in bytes. */
+            uintmax_t BytesIn = 0;
+
+            /* Size of the output in bytes. */
+            uintmax_t BytesOut = 0;
+
+            /* Wall-clock time of the run in seconds. */
+            double WallSeconds = 0;
+
+            /* Processor time used by the process during the run in seconds (std::clock). */
+            double CpuSeconds = 0;
+        };
+
+        /**
+         * Writes statistics of a run to options.StatsJsonPath, if set. In a build with
+         * ENIGMA_INSTRUMENTATION the snapshot of Instrumentation is included, or printed to stderr without the path.
+         *
+         * Params:
+         * const RunStats& stats - statistics.
+         * const Enigma::Encoder& en - encoder after the run, for final rotors position.
+         *
+         * Exceptions:
+         * If the file cannot be written, an exception will be thrown.
+        */
+        void WriteStats(const RunStats& stats, const Enigma::Encoder& en) noexcept(false);
+
+        /**
+         * Prints progress of -e to stderr.
+         *
+         * Params:
+         * uintmax_t done - bytes read so far.
+         * uintmax_t total - size of the file.
+         * double seconds - time since the start.
+        */
+        static void ReportProgress(uintmax_t done, uintmax_t total, double seconds) noexcept;
+
         /* Settings used for encryption. */
         Enigma::UserSettings settings;
 
+        /* Options of -e and -s. */
+        EncryptOptions options;
+
     public:
         /**
          * Constructor.
@@ -123,13 +188,67 @@ namespace EnigmaCLI
         */
         Encrypter(int argc, char *argv[]) noexcept(false);
 
+        /**
+         * Removes flags of -e and -s from arguments, so the rest can be given to the constructor.
+         *
+         * Flags (anywhere after the file path or string):
+         * --max-size [MB] - refuse files bigger than MB.
+         * --progress / --no-progress - report progress on stderr, by default only if stderr is a terminal.
+         * --stats-json [path] - write statistics of the run as JSON.
+         *
+         * Params:
+         * int& argc - number of arguments, decreased by the number of removed ones.
+         * char *argv[] - arguments.
+         *
+         * Exceptions:
+         * If a flag is unknown or its value is missing or invalid, an exception will be thrown.
+         *
+         * Returns:
+         * EncryptOptions - options.
+        */
+        static EncryptOptions ExtractOptions(int& argc, char *argv[]) noexcept(false);
+
+        /**
+         * Removes --doubled flag of -ie and -id from arguments, so the rest can be given to the constructor.
+         *
+         * Params:
+         * int& argc - number of arguments, decreased if the flag was removed.
+         * char *argv[] - arguments.
+         *
+         * Returns:
+         * bool - true if the flag was given.
+        */
+        static bool ExtractDoubled(int& argc, char *argv[]) noexcept;
+
+        /**
+         * Quotes text as a JSON string.
+         *
+         * Params:
+         * const std::string& text - text.
+         *
+         * Returns:
+         * std::string - JSON string, with quotes.
+        */
+        static std::string JsonString(const std::string& text) noexcept;
+
+        /**
+         * Sets options of -e and -s.
+         *
+         * Params:
+         * const EncryptOptions& nOptions - options.
+        */
+        void setOptions(const EncryptOptions& nOptions) noexcept { options = nOptions; }
+
         /**
          * Handles -s flag. User communication and encryption.
          * 
          * Params:
          * const char* orgText - text to be encrypted.
+         *
+         * Exceptions:
+         * If statistics cannot be written, an exception will be thrown.
         */
-        void EncryptString(const char* orgText) noexcept;
+        void EncryptString(const char* orgText) noexcept(false);
 
         /**
          * Handles -e flag. User communication and encryption.
@@ -139,11 +258,31 @@ namespace EnigmaCLI
          *
          * Exceptions:
          * If any unrecoverable problem appears during writing or reading (std::ios::bad), or
-         * program will not be able to find free file name for saving,  
+         * program will not be able to find free file name for saving, or
+         * the file is bigger than options.MaxSize, or statistics cannot be written,
          * then an exception will be thrown.
         */
         void EncryptFile(const char* filePath) noexcept(false);
 
+        /**
+         * Handles -ie and -id flags. Indicator procedure over a batch of messages.
+         *
+         * Settings are used as the daily key, their rotors position as Grundstellung.
+         * Every line of the file holds a message: message key (-ie) or indicator (-id), then the body.
+         * Output file holds one line per message: indicator and ciphertext (-ie) or
+         * message key and plaintext (-id). Messages are processed in parallel.
+         * With @doubled message keys are typed twice (6 letter indicators, procedure used until 1940).
+         *
+         * Params:
+         * const char* filePath - batch file path.
+         * bool encrypt - true for -ie, false for -id.
+         * bool doubled - true for doubled message keys (--doubled).
+         *
+         * Exceptions:
+         * If the batch cannot be read or the output cannot be written, an exception will be thrown.
+        */
+        void ProcessIndicatorBatch(const char* filePath, bool encrypt, bool doubled) noexcept(false);
+
         /**
          * Changes encryption settings using raw arguments provied from user terminal.
          * 
@@ -157,5 +296,13 @@ namespace EnigmaCLI
          * then an exception will be thrown.
         */
         void ChangeSettings(int argc, char *argv[]) noexcept(false);
+
+        /**
+         * Returns settings used for encryption.
+         *
+         * Returns:
+         * const Enigma::UserSettings& - settings.
+        */
+        const Enigma::UserSettings& getSettings() const noexcept { return settings; }
     };
 }
\ No newline at end of file
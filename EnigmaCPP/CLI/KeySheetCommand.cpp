@@ -0,0 +1,36 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "KeySheetCommand.h"
+#include "include/KeySheet.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace EnigmaCLI;
+
+void KeySheetCommand::Run(const char *filePath, const char *binaryOutPath)
+{
+    Enigma::ThreadPool pool;
+
+    auto start = std::chrono::steady_clock::now();
+    Enigma::KeySheet sheet = Enigma::KeySheet::Load(filePath, pool);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    const auto &errors = sheet.getErrors();
+    std::cout << "Loaded " << sheet.size() << " keys, " << errors.size() << " invalid, in " << ms << " ms ("
+              << pool.getSize() << " threads)." << std::endl;
+    for (size_t i = 0; i < errors.size() && i < maxPrintedErrors; i++)
+        std::cout << "Line " << errors[i].Line << ": " << errors[i].Reason << '\n';
+    if (errors.size() > maxPrintedErrors)
+        std::cout << "... and " << errors.size() - maxPrintedErrors << " more." << '\n';
+
+    if (binaryOutPath != nullptr)
+    {
+        sheet.SaveBinary(binaryOutPath);
+        std::cout << "Binary key sheet saved under name: " << binaryOutPath << '\n';
+    }
+    std::cout << std::flush;
+}
@@ -0,0 +1,29 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+namespace EnigmaCLI
+{
+    /* Handles -k flag. Bulk loading and validation of key sheets. */
+    class KeySheetCommand
+    {
+        /* Max number of invalid entries printed. */
+        static const int maxPrintedErrors = 100;
+
+    public:
+        /**
+         * Loads a key sheet (text or binary), prints a summary and invalid entries with line numbers.
+         *
+         * Params:
+         * const char* filePath - key sheet path.
+         * const char* binaryOutPath - if not nullptr, valid entries are saved there in binary format.
+         *
+         * Exceptions:
+         * If the key sheet cannot be read or the output cannot be written, an exception will be thrown.
+        */
+        static void Run(const char* filePath, const char* binaryOutPath) noexcept(false);
+    };
+}
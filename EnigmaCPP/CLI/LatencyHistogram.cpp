@@ -0,0 +1,76 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "LatencyHistogram.h"
+
+using namespace EnigmaCLI;
+
+LatencyHistogram::LatencyHistogram() noexcept :
+Buckets((64 - subBucketBits + 1) * subBucketCount, 0), Count(0), Max(0) {}
+
+int LatencyHistogram::BucketIndex(uint64_t ns) noexcept
+{
+    // Values smaller than subBucketCount have their own buckets.
+    if (ns < subBucketCount)
+        return (int)ns;
+    int msb = 63 - __builtin_clzll(ns);
+    int shift = msb - subBucketBits;
+    int sub = (int)((ns >> shift) & (subBucketCount - 1));
+    return (shift + 1) * subBucketCount + sub;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(int index) noexcept
+{
+    if (index < subBucketCount)
+        return (uint64_t)index;
+    int shift = index / subBucketCount - 1;
+    uint64_t sub = (uint64_t)(index % subBucketCount);
+    return (((uint64_t)subBucketCount + sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t ns) noexcept
+{
+    Buckets[BucketIndex(ns)]++;
+    Count++;
+    if (ns > Max)
+        Max = ns;
+}
+
+uint64_t LatencyHistogram::Percentile(double p) const noexcept
+{
+    if (Count == 0)
+        return 0;
+    uint64_t rank = (uint64_t)(p * (double)Count);
+    if (rank >= Count)
+        rank = Count - 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < (int)Buckets.size(); i++)
+    {
+        seen += Buckets[i];
+        if (seen > rank)
+        {
+            uint64_t bound = BucketUpperBound(i);
+            return bound < Max ? bound : Max;
+        }
+    }
+    return Max;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) noexcept
+{
+    for (int i = 0; i < (int)Buckets.size(); i++)
+        Buckets[i] += other.Buckets[i];
+    Count += other.Count;
+    if (other.Max > Max)
+        Max = other.Max;
+}
+
+void LatencyHistogram::Reset() noexcept
+{
+    for (uint64_t& bucket : Buckets)
+        bucket = 0;
+    Count = 0;
+    Max = 0;
+}
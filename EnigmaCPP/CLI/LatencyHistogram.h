@@ -0,0 +1,110 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace EnigmaCLI
+{
+    /**
+     * Log-linear histogram of latencies in nanoseconds.
+     *
+     * Values are grouped by their highest set bit and each group is split into
+     * 2^subBucketBits equal buckets, so the relative error of a percentile is below 1/16.
+     * Recording is O(1) and allocation free.
+    */
+    class LatencyHistogram
+    {
+    public:
+        /* Constructor. Histogram is empty. */
+        LatencyHistogram() noexcept;
+
+        /**
+         * Records a single value.
+         *
+         * Params:
+         * uint64_t ns - latency in nanoseconds.
+        */
+        void Record(uint64_t ns) noexcept;
+
+        /**
+         * Returns value below which lies a given fraction of records.
+         *
+         * Params:
+         * double p - fraction, e.g. 0.99 for p99.
+         *
+         * Returns:
+         * uint64_t - latency in nanoseconds (upper bound of the bucket), 0 if histogram is empty.
+        */
+        uint64_t Percentile(double p) const noexcept;
+
+        /**
+         * Returns number of records.
+         *
+         * Returns:
+         * uint64_t - number of records.
+        */
+        uint64_t getCount() const noexcept { return Count; }
+
+        /**
+         * Returns the biggest recorded value.
+         *
+         * Returns:
+         * uint64_t - max latency in nanoseconds.
+        */
+        uint64_t getMax() const noexcept { return Max; }
+
+        /**
+         * Adds records of other histogram to this one.
+         *
+         * Params:
+         * const LatencyHistogram& other - histogram to be merged.
+        */
+        void Merge(const LatencyHistogram& other) noexcept;
+
+        /* Removes all records. */
+        void Reset() noexcept;
+
+    private:
+        /* Number of bits used for buckets inside of one power of two. */
+        static const int subBucketBits = 4;
+
+        /* Number of buckets inside of one power of two. */
+        static const int subBucketCount = 1 << subBucketBits;
+
+        /* Buckets. */
+        std::vector<uint64_t> Buckets;
+
+        /* Number of records. */
+        uint64_t Count;
+
+        /* The biggest recorded value. */
+        uint64_t Max;
+
+        /**
+         * Returns index of the bucket holding a given value.
+         *
+         * Params:
+         * uint64_t ns - value.
+         *
+         * Returns:
+         * int - bucket index.
+        */
+        static int BucketIndex(uint64_t ns) noexcept;
+
+        /**
+         * Returns the biggest value that falls into a given bucket.
+         *
+         * Params:
+         * int index - bucket index.
+         *
+         * Returns:
+         * uint64_t - upper bound of the bucket.
+        */
+        static uint64_t BucketUpperBound(int index) noexcept;
+    };
+}
@@ -0,0 +1,242 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+/**
+ * Load generator for the daemon (EnigmaCPP -d).
+ *
+ * For every concurrency level opens that many connections, each connection loads
+ * its own key and sends encryption requests in a closed loop (next request after the response).
+ * Client side latency percentiles and throughput are printed per level.
+*/
+
+#include "DaemonProtocol.h"
+#include "LatencyHistogram.h"
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+
+using namespace EnigmaCLI;
+using namespace EnigmaCLI::Protocol;
+
+typedef std::chrono::steady_clock Clock;
+
+/* State of a single client connection. */
+struct Client
+{
+    int Fd;
+    int Remaining;
+    Clock::time_point SentAt;
+    std::string In;
+    std::string Request;
+};
+
+/* Connects to the daemon, returns blocking socket. */
+int Connect(const std::string &socketPath)
+{
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    socketPath.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+        throw std::runtime_error("Unable to connect to " + socketPath + '.');
+    return fd;
+}
+
+/* Writes whole buffer, spinning on a non-blocking socket if needed. */
+void WriteAll(int fd, const std::string &data)
+{
+    size_t done = 0;
+    while (done < data.size())
+    {
+        ssize_t sent = write(fd, data.data() + done, data.size() - done);
+        if (sent > 0)
+            done += sent;
+        else if (sent < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+            continue;
+        else
+            throw std::runtime_error("Write failed.");
+    }
+}
+
+/* Sends a single request over a blocking socket and returns the response body. */
+std::string Call(int fd, uint8_t op, const std::string &body)
+{
+    std::string frame;
+    AppendFrame(frame, op, 0, 0, body.data(), (uint32_t)body.size());
+    WriteAll(fd, frame);
+
+    FrameHeader header;
+    size_t got = 0;
+    while (got < sizeof(header))
+    {
+        ssize_t n = read(fd, reinterpret_cast<char *>(&header) + got, sizeof(header) - got);
+        if (n <= 0)
+            throw std::runtime_error("Connection closed by the daemon.");
+        got += n;
+    }
+    std::string resp(header.Length, '\0');
+    got = 0;
+    while (got < header.Length)
+    {
+        ssize_t n = read(fd, &resp[got], header.Length - got);
+        if (n <= 0)
+            throw std::runtime_error("Connection closed by the daemon.");
+        got += n;
+    }
+    if (header.Status != StatusOk)
+        throw std::runtime_error("Daemon error: " + resp);
+    return resp;
+}
+
+/* Builds an encryption request of a loaded key, starting at AAA. */
+std::string EncryptRequest(const std::string &keyID, int messageLength)
+{
+    std::string body = keyID + "AAA";
+    for (int i = 0; i < messageLength; i++)
+        body += (char)('A' + i % 26);
+    std::string request;
+    AppendFrame(request, OpEncrypt, 0, 0, body.data(), (uint32_t)body.size());
+    return request;
+}
+
+/* Runs a single concurrency level and prints its results. */
+void RunLevel(const std::string &socketPath, const std::string &settings, int messageLength, int concurrency, int requestsPerConnection)
+{
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    std::unordered_map<int, Client> clients;
+    LatencyHistogram latency;
+
+    auto begin = Clock::now();
+    for (int i = 0; i < concurrency; i++)
+    {
+        int fd = Connect(socketPath);
+        // Keys belong to the connection which loaded them.
+        std::string request = EncryptRequest(Call(fd, OpLoadKey, settings), messageLength);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+        Client &cl = clients[fd];
+        cl.Fd = fd;
+        cl.Remaining = requestsPerConnection - 1;
+        cl.SentAt = Clock::now();
+        cl.Request = request;
+        WriteAll(fd, request);
+    }
+
+    int active = concurrency;
+    std::vector<epoll_event> events(256);
+    char buffer[64 * 1024];
+    while (active > 0)
+    {
+        int n = epoll_wait(epollFd, events.data(), (int)events.size(), -1);
+        for (int i = 0; i < n; i++)
+        {
+            Client &cl = clients[events[i].data.fd];
+            ssize_t got;
+            while ((got = read(cl.Fd, buffer, sizeof(buffer))) > 0)
+                cl.In.append(buffer, got);
+            if (got == 0)
+                throw std::runtime_error("Connection closed by the daemon.");
+
+            size_t offset = 0;
+            while (cl.In.size() - offset >= sizeof(FrameHeader))
+            {
+                FrameHeader header;
+                std::memcpy(&header, cl.In.data() + offset, sizeof(header));
+                if (cl.In.size() - offset - sizeof(header) < header.Length)
+                    break;
+                if (header.Status != StatusOk)
+                    throw std::runtime_error("Daemon error: " + cl.In.substr(offset + sizeof(header), header.Length));
+                offset += sizeof(header) + header.Length;
+
+                auto now = Clock::now();
+                latency.Record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now - cl.SentAt).count());
+                if (cl.Remaining > 0)
+                {
+                    cl.Remaining--;
+                    cl.SentAt = Clock::now();
+                    WriteAll(cl.Fd, cl.Request);
+                }
+                else
+                    active--;
+            }
+            cl.In.erase(0, offset);
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    for (auto &cl : clients)
+        close(cl.first);
+    close(epollFd);
+
+    std::printf("%11d %10llu %12.0f %10.2f %10.2f %10.2f %10.2f\n", concurrency, (unsigned long long)latency.getCount(),
+                latency.getCount() / seconds, latency.Percentile(0.50) / 1000.0, latency.Percentile(0.99) / 1000.0,
+                latency.Percentile(0.999) / 1000.0, latency.getMax() / 1000.0);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::printf("EnigmaLoadGen [socket path] (requests per connection = 200) (message length = 64) (concurrency levels = 1 16 256 1024)\n");
+        return 0;
+    }
+
+    try
+    {
+        std::string socketPath = argv[1];
+        int requestsPerConnection = argc > 2 ? std::atoi(argv[2]) : 200;
+        int messageLength = argc > 3 ? std::atoi(argv[3]) : 64;
+        std::vector<int> levels;
+        for (int i = 4; i < argc; i++)
+            levels.push_back(std::atoi(argv[i]));
+        if (levels.empty())
+            levels = {1, 16, 256, 1024};
+        if (requestsPerConnection < 1 || messageLength < 0)
+            throw std::runtime_error("Pass valid arguments.");
+
+        rlimit lim;
+        if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < lim.rlim_max)
+        {
+            lim.rlim_cur = lim.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &lim);
+        }
+        signal(SIGPIPE, SIG_IGN);
+
+        const std::string settings = "B I II III C B D F G D AZ BC";
+        int control = Connect(socketPath);
+        std::string keyID = Call(control, OpLoadKey, settings);
+
+        std::printf("%11s %10s %12s %10s %10s %10s %10s\n", "concurrency", "requests", "req/s", "p50_us", "p99_us", "p999_us", "max_us");
+        for (int level : levels)
+            RunLevel(socketPath, settings, messageLength, level, requestsPerConnection);
+
+        Call(control, OpReleaseKey, keyID);
+        std::printf("Daemon: %s\n", Call(control, OpStats, "").c_str());
+        close(control);
+    }
+    catch (const std::exception &e)
+    {
+        std::printf("Error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
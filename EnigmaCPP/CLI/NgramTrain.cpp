@@ -0,0 +1,128 @@
+/**
+ * EnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+/**
+ * Trains n-gram models (EnigmaCPP --attack plugs) from a corpus.
+ *
+ * German letters are transliterated the way Enigma operators wrote them (AE, OE, UE, SS),
+ * every order is saved to "[output prefix][n].engm". Each saved model is mapped back and
+ * its load time and scoring speed over the corpus are printed.
+*/
+
+#include "include/NgramModel.h"
+#include "include/MappedFile.h"
+#include "include/CompiledKey.h"
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+typedef std::chrono::steady_clock Clock;
+
+/* Replaces UTF-8 umlauts and sharp s with their two letter forms. */
+std::string Transliterate(const char *data, size_t size)
+{
+    std::string text;
+    text.reserve(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        unsigned char c = data[i];
+        if (c == 0xC3 && i + 1 < size)
+        {
+            const char *replacement = nullptr;
+            switch ((unsigned char)data[i + 1])
+            {
+            case 0x84:
+            case 0xA4:
+                replacement = "AE";
+                break;
+            case 0x96:
+            case 0xB6:
+                replacement = "OE";
+                break;
+            case 0x9C:
+            case 0xBC:
+                replacement = "UE";
+                break;
+            case 0x9F:
+                replacement = "SS";
+                break;
+            }
+            if (replacement != nullptr)
+            {
+                text += replacement;
+                i++;
+                continue;
+            }
+        }
+        text += (char)c;
+    }
+    return text;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        std::printf("EnigmaNgramTrain [corpus path] [output prefix] (language = en) (type float/int16 = float) (orders = 2 3 4)\n");
+        return 0;
+    }
+
+    try
+    {
+        std::string language = argc > 3 ? argv[3] : "en";
+        std::string type = argc > 4 ? argv[4] : "float";
+        if (type != "float" && type != "int16")
+            throw std::runtime_error("Pass valid arguments.");
+        std::vector<int> orders;
+        for (int i = 5; i < argc; i++)
+            orders.push_back(std::atoi(argv[i]));
+        if (orders.empty())
+            orders = {2, 3, 4};
+
+        std::string corpus;
+        {
+            Enigma::MappedFile file(argv[1]);
+            corpus = Transliterate(file.getData(), file.getSize());
+        }
+        std::vector<uint8_t> letters = Enigma::CompiledKey::ToIndices(corpus);
+        std::printf("Corpus: %zu letters.\n", letters.size());
+
+        std::printf("%5s %12s %10s %10s %12s\n", "order", "file bytes", "train_ms", "load_us", "score_MB/s");
+        for (int order : orders)
+        {
+            auto begin = Clock::now();
+            Enigma::NgramModel model = Enigma::NgramModel::Train(corpus, order, language, type == "float" ? Enigma::NgramFloat32 : Enigma::NgramInt16);
+            std::string path = std::string(argv[2]) + std::to_string(order) + ".engm";
+            model.Save(path);
+            double trainMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+            begin = Clock::now();
+            Enigma::NgramModel mapped = Enigma::NgramModel::Load(path);
+            double loadUs = std::chrono::duration<double, std::micro>(Clock::now() - begin).count();
+
+            // Warm up the page cache and the CPU caches before timing.
+            volatile double score = mapped.Score(letters.data(), letters.size());
+            begin = Clock::now();
+            const int rounds = 5;
+            for (int i = 0; i < rounds; i++)
+                score = mapped.Score(letters.data(), letters.size());
+            double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+            (void)score;
+
+            Enigma::MappedFile saved(path);
+            std::printf("%5d %12zu %10.1f %10.1f %12.0f\n", order, saved.getSize(), trainMs, loadUs, letters.size() * rounds / seconds / 1e6);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::printf("%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,267 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "EnigmaCPP.h"
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Enigma
+{
+    /* Rotors position from left to right as indices in the alphabet (A -> 0 ... Z -> 25). */
+    typedef std::array<int, 3> RotorPositions;
+
+    /**
+     * Key compiled to flat lookup tables.
+     *
+     * Holds everything needed for encryption except rotors position, which is passed by the caller.
+     * Thanks to that a single instance can be shared between threads and messages.
+     * Gives the same results as Encoder for the same settings.
+     */
+    class CompiledKey
+    {
+    public:
+        /* Length of the alphabet (asserted to be English). */
+        static const int alphabetLength = 26;
+
+        /**
+         * Constructor, compiles given settings.
+         * Rotors position in @USettings is validated but not stored, see PositionsOf().
+         *
+         * Params:
+         * const UserSettings& USettings - settings to be compiled.
+         *
+         * Exceptions:
+         * If @USettings are invalid an exception will be thrown.
+         */
+        explicit CompiledKey(const UserSettings& USettings) noexcept(false);
+
+        /**
+         * Constructor, compiles already validated parts of settings.
+         * Used on hot paths where settings are checked without exceptions (e.g. key sheets).
+         *
+         * Params:
+         * ReflectorID ReflectorName - ID of the reflector.
+         * const std::array<RotorID, 3>& Rotors - rotors from left to right.
+         * const std::array<int, 3>& RingSettings - ring settings from left to right (0 - 25).
+         * const uint8_t* PlugboardWiring - 26 alphabet indices, must be an involution.
+         */
+        CompiledKey(ReflectorID ReflectorName, const std::array<RotorID, 3>& Rotors, const std::array<int, 3>& RingSettings, const uint8_t* PlugboardWiring) noexcept;
+
+        /**
+         * Returns rotors position stored in given settings.
+         *
+         * Params:
+         * const UserSettings& USettings - settings.
+         *
+         * Exceptions:
+         * If number of rotors is not 3 or any position is not an uppercase letter, an exception will be thrown.
+         *
+         * Returns:
+         * RotorPositions - rotors position from left to right.
+         */
+        static RotorPositions PositionsOf(const UserSettings& USettings) noexcept(false);
+
+        /**
+         * Returns canonical text form of the position independent part of settings,
+         * that is reflector, rotors, ring settings and sorted plugboard connections.
+         * Settings that differ only in rotors position or in order of connections share the same form.
+         *
+         * Params:
+         * const UserSettings& USettings - settings.
+         *
+         * Exceptions:
+         * If any connection is not two different uppercase letters or there are more than 13, an exception will be thrown.
+         *
+         * Returns:
+         * std::string - canonical form.
+         */
+        static std::string CanonicalForm(const UserSettings& USettings) noexcept(false);
+
+        /**
+         * Encrypts/decrypts given letter and advances @positions.
+         *
+         * Params:
+         * int letter - letter as an index in the alphabet (0 - 25).
+         * RotorPositions& positions - current rotors position, will be stepped.
+         *
+         * Returns:
+         * int - encrypted/decrypted letter as an index in the alphabet.
+         */
+        inline int EncryptIndex(int letter, RotorPositions& positions) const noexcept
+        {
+            Step(positions);
+            return PermuteIndex(letter, positions);
+        }
+
+        /**
+         * Encrypts/decrypts given letter at given rotors position, without stepping.
+         *
+         * Params:
+         * int letter - letter as an index in the alphabet (0 - 25).
+         * const RotorPositions& positions - rotors position used for this letter.
+         *
+         * Returns:
+         * int - encrypted/decrypted letter as an index in the alphabet.
+         */
+        inline int PermuteIndex(int letter, const RotorPositions& positions) const noexcept
+        {
+            letter = Plugboard[letter];
+            for (int i = 2; i >= 0; i--)
+            {
+                int offset = positions[i] - Rings[i] + alphabetLength;
+                letter = ModTable[Forward[i][ModTable[letter + offset]] - offset + 2 * alphabetLength];
+            }
+            letter = Reflector[letter];
+            for (int i = 0; i < 3; i++)
+            {
+                int offset = positions[i] - Rings[i] + alphabetLength;
+                letter = ModTable[Backward[i][ModTable[letter + offset]] - offset + 2 * alphabetLength];
+            }
+            return Plugboard[letter];
+        }
+
+        /**
+         * Handles stepping and checks turnover positions, same as in Encoder.
+         *
+         * Params:
+         * RotorPositions& positions - rotors position to be stepped.
+         */
+        inline void Step(RotorPositions& positions) const noexcept
+        {
+            if (positions[1] == Notches[1])
+            {
+                positions[1] = ModTable[positions[1] + 1];
+                positions[0] = ModTable[positions[0] + 1];
+            }
+            else if (positions[2] == Notches[2])
+                positions[1] = ModTable[positions[1] + 1];
+            positions[2] = ModTable[positions[2] + 1];
+        }
+
+        /**
+         * Encrypts/decrypts a buffer of alphabet indices.
+         *
+         * Params:
+         * const uint8_t* in - letters as indices in the alphabet.
+         * uint8_t* out - output buffer, may be the same as @in.
+         * size_t length - number of letters.
+         * RotorPositions& positions - current rotors position, will be stepped.
+         */
+        void EncryptIndices(const uint8_t* in, uint8_t* out, size_t length, RotorPositions& positions) const noexcept;
+
+        /**
+         * Encrypts/decrypts given text, same rules as Encoder::EncryptString.
+         *
+         * Params:
+         * const std::string& originalText - text to be encrypted/decrypted.
+         * RotorPositions& positions - current rotors position, will be stepped.
+         *
+         * Returns:
+         * std::string - encrypted/decrypted text.
+         */
+        std::string EncryptString(const std::string& originalText, RotorPositions& positions) const noexcept;
+
+        /**
+         * Converts text to alphabet indices, the form used by EncryptIndices and search engines.
+         * Characters out of the alphabet are skipped, same as in EncryptString.
+         *
+         * Params:
+         * const std::string& text - text.
+         *
+         * Returns:
+         * std::vector<uint8_t> - letters as indices in the alphabet.
+         */
+        static std::vector<uint8_t> ToIndices(const std::string& text) noexcept;
+
+        /**
+         * Returns forward wiring of a rotor.
+         *
+         * Params:
+         * int rotor - rotor index from left to right.
+         *
+         * Returns:
+         * const uint8_t* - 26 alphabet indices.
+         */
+        const uint8_t* getForward(int rotor) const noexcept { return Forward[rotor]; }
+
+        /**
+         * Returns inverse wiring of a rotor.
+         *
+         * Params:
+         * int rotor - rotor index from left to right.
+         *
+         * Returns:
+         * const uint8_t* - 26 alphabet indices.
+         */
+        const uint8_t* getBackward(int rotor) const noexcept { return Backward[rotor]; }
+
+        /**
+         * Returns reflector wiring.
+         *
+         * Returns:
+         * const uint8_t* - 26 alphabet indices.
+         */
+        const uint8_t* getReflector() const noexcept { return Reflector; }
+
+        /**
+         * Returns plugboard wiring, every unused letter is mapped to itself.
+         *
+         * Returns:
+         * const uint8_t* - 26 alphabet indices.
+         */
+        const uint8_t* getPlugboard() const noexcept { return Plugboard; }
+
+        /**
+         * Returns turnover positions of rotors.
+         *
+         * Returns:
+         * const int* - 3 notches from left to right.
+         */
+        const int* getNotches() const noexcept { return Notches; }
+
+        /**
+         * Returns ring settings of rotors.
+         *
+         * Returns:
+         * const int* - 3 ring settings from left to right.
+         */
+        const int* getRings() const noexcept { return Rings; }
+
+        /**
+         * Returns number of bytes occupied by the key.
+         *
+         * Returns:
+         * size_t - memory footprint.
+         */
+        size_t MemoryFootprint() const noexcept { return sizeof(CompiledKey); }
+
+    private:
+        /* Maps 0 - 77 to the value modulo alphabetLength, avoids division on the hot path. */
+        static const uint8_t ModTable[3 * alphabetLength];
+
+        /* Forward wiring of rotors from left to right. */
+        uint8_t Forward[3][alphabetLength];
+
+        /* Inverse wiring of rotors from left to right. */
+        uint8_t Backward[3][alphabetLength];
+
+        /* Reflector wiring. */
+        uint8_t Reflector[alphabetLength];
+
+        /* Plugboard wiring. */
+        uint8_t Plugboard[alphabetLength];
+
+        /* Turnover positions from left to right. */
+        int Notches[3];
+
+        /* Ring settings from left to right. */
+        int Rings[3];
+    };
+}
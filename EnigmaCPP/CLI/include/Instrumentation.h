@@ -0,0 +1,196 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include <string>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Opt-in instrumentation of Encoder and the CLI encrypter.
+ *
+ * Compiled in only when ENIGMA_INSTRUMENTATION is defined (make INSTRUMENT=1, for both the library and the CLI).
+ * Otherwise ENIGMA_COUNT and ENIGMA_SCOPED_TIMER expand to nothing and Collect() returns zeros.
+ *
+ * Every thread updates its own block of counters, blocks are summed by Collect(), so the hot path takes no lock
+ * and shares no cache line. Phases run per letter (stepping, plugboard, rotors) are timed for one call of 64,
+ * the time of the other calls is extrapolated. Other phases are timed on every call and, where perf_event_open
+ * is allowed, also count CPU cycles, instructions and cache misses of the thread.
+ */
+#ifdef ENIGMA_INSTRUMENTATION
+#define ENIGMA_INSTRUMENTATION_CONCAT2(a, b) a##b
+#define ENIGMA_INSTRUMENTATION_CONCAT(a, b) ENIGMA_INSTRUMENTATION_CONCAT2(a, b)
+#define ENIGMA_COUNT(counter, n) ::Enigma::Instrumentation::Add(::Enigma::Instrumentation::counter, (n))
+#define ENIGMA_SCOPED_TIMER(phase) ::Enigma::Instrumentation::ScopedTimer ENIGMA_INSTRUMENTATION_CONCAT(enigmaTimer, __LINE__)(::Enigma::Instrumentation::phase)
+#else
+#define ENIGMA_COUNT(counter, n) ((void)0)
+#define ENIGMA_SCOPED_TIMER(phase) ((void)0)
+#endif
+
+namespace Enigma
+{
+    namespace Instrumentation
+    {
+#ifdef ENIGMA_INSTRUMENTATION
+        const bool enabled = true;
+#else
+        const bool enabled = false;
+#endif
+
+        enum Counter
+        {
+            /* Letters encrypted by Encoder. */
+            LettersProcessed,
+            /* Characters out of the alphabet skipped by Encoder::EncryptString. */
+            NonLettersDropped,
+            /* Double steps of the middle rotor. */
+            DoubleSteps,
+            /* Settings converted by the Encoder constructor or setNewSettings. */
+            ReKeys,
+            /* Bytes read and written by the CLI encrypter. */
+            BytesRead,
+            BytesWritten,
+            numberOfCounters
+        };
+
+        enum Phase
+        {
+            /* Per letter, sampled. */
+            PhaseStepping,
+            PhasePlugboard,
+            PhaseRotors,
+            /* Whole calls. */
+            PhaseEncryptString,
+            PhaseReKey,
+            PhaseFileRead,
+            PhaseFileWrite,
+            numberOfPhases
+        };
+
+        /* Names of counters and phases, used in snapshots. */
+        extern const char* const counterNames[numberOfCounters];
+        extern const char* const phaseNames[numberOfPhases];
+
+        /* Statistics of a phase. */
+        struct PhaseStats
+        {
+            /* Number of calls. */
+            uint64_t Calls = 0;
+
+            /* Number of timed calls. */
+            uint64_t TimedCalls = 0;
+
+            /* Time of timed calls in nanoseconds. */
+            uint64_t Nanoseconds = 0;
+
+            /* CPU cycles, instructions and cache misses of timed calls, zero without perf_event_open. */
+            uint64_t Cycles = 0;
+            uint64_t Instructions = 0;
+            uint64_t CacheMisses = 0;
+
+            /**
+             * Returns time of all calls, extrapolated from the timed ones.
+             *
+             * Returns:
+             * double - time in nanoseconds.
+             */
+            double EstimatedNanoseconds() const noexcept { return TimedCalls ? (double)Nanoseconds * Calls / TimedCalls : 0; }
+        };
+
+        /* Sum of the counters of all threads. */
+        struct Snapshot
+        {
+            /* True if instrumentation is compiled in. */
+            bool Enabled = enabled;
+
+            /* True if at least one thread got hardware counters. */
+            bool HardwareCounters = false;
+
+            /* Number of threads which recorded anything. */
+            uint64_t Threads = 0;
+
+            /* Values of Counter. */
+            uint64_t Counters[numberOfCounters] = {};
+
+            /* Statistics of Phase. */
+            PhaseStats Phases[numberOfPhases];
+
+            /**
+             * Returns the snapshot as a JSON object.
+             *
+             * Returns:
+             * std::string - JSON.
+             */
+            std::string ToJson() const noexcept;
+        };
+
+        /**
+         * Sums the counters of all threads, also of finished ones.
+         *
+         * Returns:
+         * Snapshot - statistics.
+         */
+        Snapshot Collect() noexcept;
+
+        /* Zeroes the counters of all threads. Counters updated at the same time may be partly kept. */
+        void Reset() noexcept;
+
+#ifdef ENIGMA_INSTRUMENTATION
+        /* Counters of a thread, written only by the thread. */
+        struct ThreadBlock;
+
+        /**
+         * Returns block of the calling thread, registered on the first call.
+         *
+         * Returns:
+         * ThreadBlock& - block.
+         */
+        ThreadBlock& LocalBlock() noexcept;
+
+        /**
+         * Adds to a counter of the calling thread.
+         *
+         * Params:
+         * Counter counter - counter.
+         * uint64_t n - value to be added.
+         */
+        void Add(Counter counter, uint64_t n) noexcept;
+
+        /* Times a phase from construction to destruction. */
+        class ScopedTimer
+        {
+        public:
+            /**
+             * Constructor, starts timing if this call of the phase is timed.
+             *
+             * Params:
+             * Phase phase - phase.
+             */
+            explicit ScopedTimer(Phase phase) noexcept;
+
+            /* Destructor, records the call. */
+            ~ScopedTimer() noexcept;
+
+            ScopedTimer(const ScopedTimer&) = delete;
+            ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        private:
+            /* Block of the thread. */
+            ThreadBlock& Block;
+
+            /* Timed phase. */
+            Phase TimedPhase;
+
+            /* True if this call is timed. */
+            bool Timed;
+
+            /* Start time and hardware counters (cycles, instructions, cache misses). */
+            std::chrono::steady_clock::time_point Start;
+            uint64_t StartCounters[3];
+        };
+#endif
+    }
+}
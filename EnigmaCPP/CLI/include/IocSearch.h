@@ -0,0 +1,114 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "CandidateHeap.h"
+#include "ThreadPool.h"
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Enigma
+{
+    /* Options of IocSearch. */
+    struct IocSearchOptions
+    {
+        /* Number of kept candidates (K). */
+        size_t TopK = 10;
+
+        /* Reflectors to be searched. */
+        std::vector<ReflectorID> Reflectors = {B, C};
+
+        /* Wheel orders from left to right, all 60 of WheelOrders() if empty. */
+        std::vector<std::array<RotorID, 3>> WheelOrders;
+
+        /* Ring settings used for every wheel order (0 - 25). */
+        std::array<int, 3> Rings = {{0, 0, 0}};
+
+        /**
+         * Searches ring settings too, @Rings is then ignored. Instead of all 26^3 rings for every start position
+         * only one key per core offset and RingClasses class of the text length is tested.
+         */
+        bool SearchRings = false;
+
+        /**
+         * Early abort: once the heap is full, a start position is dropped if after @AbortFraction of the
+         * text its partial index of coincidence is more than @AbortDeviations standard errors below the lowest kept score.
+         * The standard error is estimated from the letter counts of the checkpoint, so the cut-off widens for short texts.
+         * AbortDeviations = 0 disables early abort.
+         */
+        double AbortFraction = 0.5;
+        double AbortDeviations = 3;
+    };
+
+    /* Result of IocSearch. */
+    struct IocSearchResult
+    {
+        /* Best candidates, from the best one. Score is the index of coincidence of the decryption. */
+        std::vector<KeyCandidate> Candidates;
+
+        /* Number of tested keys (reflector x wheel order x start position, x ring class with SearchRings). */
+        uint64_t KeysTested;
+
+        /* Number of keys the tested ones stand for, with SearchRings all 26^3 ring settings of every start position. */
+        uint64_t KeysCovered;
+
+        /* Number of keys dropped by early abort. */
+        uint64_t KeysAborted;
+
+        /* Wall time of the search in seconds. */
+        double Seconds;
+    };
+
+    /**
+     * Ciphertext-only search of reflector, wheel order and start position.
+     *
+     * Every key is used to decrypt the text with empty plugboard and scored by the index of coincidence.
+     * For every (reflector, wheel order) the machine is expanded to a KeystreamTable and its stepping
+     * to a successor table, so the inner loop is two lookups per letter.
+     * Searching ring settings steps the windows through the successor table and maps them to core offsets,
+     * one more lookup per letter, and tests only the representatives of RingClasses.
+     * Wheel orders are spread across the threads of the pool, each thread keeps its own top-K heap.
+     */
+    class IocSearch
+    {
+    public:
+        /**
+         * Runs the search.
+         *
+         * Params:
+         * const std::string& cipherText - ciphertext, characters out of the alphabet are ignored.
+         * const IocSearchOptions& options - options.
+         * ThreadPool& pool - threads used for the search.
+         *
+         * Returns:
+         * IocSearchResult - best candidates and statistics.
+         */
+        static IocSearchResult Run(const std::string& cipherText, const IocSearchOptions& options, ThreadPool& pool) noexcept;
+
+        /**
+         * Returns all 60 wheel orders of 3 different rotors out of I - V.
+         *
+         * Returns:
+         * std::vector<std::array<RotorID, 3>> - wheel orders from left to right.
+         */
+        static std::vector<std::array<RotorID, 3>> WheelOrders() noexcept;
+
+        /**
+         * Computes index of coincidence of letters given as alphabet indices.
+         *
+         * Params:
+         * const uint8_t* text - letters.
+         * size_t length - number of letters.
+         *
+         * Returns:
+         * double - index of coincidence, 0 for less than 2 letters.
+         */
+        static double IndexOfCoincidence(const uint8_t* text, size_t length) noexcept;
+    };
+}
@@ -0,0 +1,127 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "CompiledKey.h"
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+namespace Enigma
+{
+    /* Snapshot of KeyCache counters. */
+    struct KeyCacheStats
+    {
+        /* Lookups answered from the cache. */
+        uint64_t Hits;
+
+        /* Lookups that required compilation. */
+        uint64_t Misses;
+
+        /* Keys removed because of the memory budget. */
+        uint64_t Evictions;
+
+        /* Number of cached keys. */
+        uint64_t Entries;
+
+        /* Bytes occupied by cached keys, with their list and index nodes and canonical forms. */
+        uint64_t Bytes;
+    };
+
+    /**
+     * Thread-safe LRU cache of compiled keys.
+     *
+     * Keys are looked up by CompiledKey::CanonicalForm, so settings differing only in rotors position
+     * share one compiled key. The cache is split into shards, each with its own lock and LRU list,
+     * selected by the hash of the canonical form. Every shard gets an equal part of the memory budget.
+     */
+    class KeyCache
+    {
+    public:
+        /**
+         * Constructor.
+         *
+         * Params:
+         * size_t MemoryBudget - max number of bytes occupied by cached keys, with their list and index nodes and canonical forms.
+         * int NumberOfShards - number of independently locked shards, at least 1.
+         */
+        KeyCache(size_t MemoryBudget, int NumberOfShards = 16) noexcept;
+
+        KeyCache(const KeyCache&) = delete;
+        KeyCache& operator=(const KeyCache&) = delete;
+
+        /**
+         * Returns compiled key for given settings, compiling it on a miss.
+         *
+         * Params:
+         * const UserSettings& USettings - settings to be looked up.
+         *
+         * Exceptions:
+         * If @USettings are invalid an exception will be thrown.
+         *
+         * Returns:
+         * std::shared_ptr<const CompiledKey> - compiled key, stays valid after eviction.
+         */
+        std::shared_ptr<const CompiledKey> Get(const UserSettings& USettings) noexcept(false);
+
+        /**
+         * Returns counters.
+         *
+         * Returns:
+         * KeyCacheStats - snapshot of counters.
+         */
+        KeyCacheStats getStats() const noexcept;
+
+        /* Removes all cached keys. Counters are kept. */
+        void Clear() noexcept;
+
+    private:
+        /* Single LRU list with its own lock. */
+        struct Shard
+        {
+            /* Entries from the most to the least recently used. */
+            std::list<std::pair<std::string, std::shared_ptr<const CompiledKey>>> Lru;
+
+            /* Canonical form -> entry in @Lru. */
+            std::unordered_map<std::string, decltype(Lru)::iterator> Index;
+
+            /* Bytes occupied by entries of this shard. */
+            size_t Bytes = 0;
+
+            /* Guards all members of the shard. */
+            std::mutex Lock;
+        };
+
+        /**
+         * Returns bytes of an entry: the key with the control block of its shared pointer,
+         * list and index nodes, a bucket of the index and heap memory of both copies of the canonical form.
+         *
+         * Params:
+         * const std::string& listForm - canonical form stored in the list.
+         * const std::string& indexForm - canonical form stored in the index.
+         * const CompiledKey& key - compiled key.
+         *
+         * Returns:
+         * size_t - bytes.
+         */
+        static size_t EntryBytes(const std::string& listForm, const std::string& indexForm, const CompiledKey& key) noexcept;
+
+        /* Memory budget of a single shard. */
+        size_t ShardBudget;
+
+        /* Shards. */
+        std::vector<std::unique_ptr<Shard>> Shards;
+
+        /* Counters. */
+        std::atomic<uint64_t> Hits, Misses, Evictions;
+    };
+}
@@ -0,0 +1,261 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "CompiledKey.h"
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+
+namespace Enigma
+{
+    /* Values of every dimension of a Keyspace. */
+    struct KeyspaceOptions
+    {
+        /* Returns letters 0 - 25, all positions or ring settings of a rotor. */
+        static std::vector<int> AllLetters() noexcept;
+
+        /* Reflectors. */
+        std::vector<ReflectorID> Reflectors = {B, C};
+
+        /* Wheel orders from left to right, all 60 of IocSearch::WheelOrders() if empty. */
+        std::vector<std::array<RotorID, 3>> WheelOrders;
+
+        /* Plugboards, each a list of connections such as "AB". */
+        std::vector<std::vector<std::string>> Plugboards = {std::vector<std::string>()};
+
+        /* Ring settings of every rotor from left to right (0 - 25). */
+        std::array<std::vector<int>, 3> Rings = {{{0}, {0}, {0}}};
+
+        /* Start positions of every rotor from left to right (0 - 25). */
+        std::array<std::vector<int>, 3> Positions = {{AllLetters(), AllLetters(), AllLetters()}};
+    };
+
+    /* Key of a Keyspace. */
+    struct KeyspaceKey
+    {
+        /* ID of the reflector. */
+        ReflectorID Reflector;
+
+        /* Rotors from left to right. */
+        std::array<RotorID, 3> Rotors;
+
+        /* Index of the plugboard in KeyspaceOptions::Plugboards. */
+        size_t Plugboard;
+
+        /* Ring settings from left to right (0 - 25). */
+        std::array<int, 3> Rings;
+
+        /* Start position from left to right (0 - 25). */
+        RotorPositions Positions;
+    };
+
+    /* Range of key indices [First, Last). */
+    struct KeyspaceShard
+    {
+        uint64_t First;
+        uint64_t Last;
+
+        /* Number of keys. */
+        uint64_t size() const noexcept { return Last - First; }
+    };
+
+    /**
+     * Set of settings (reflector x wheel order x plugboard x rings x start position) with every key numbered.
+     *
+     * Index of a key is a mixed-radix number of its dimensions, so rank and unrank are O(1).
+     * The order keeps the start position innermost, the right rotor fastest, like stepping does:
+     * keys sharing reflector, wheel order, plugboard and rings (one CompiledKey or KeystreamTable) are contiguous
+     * blocks of getTableSize() keys. Iterators are lazy and step the key like an odometer.
+     * Split() cuts the space into balanced shards, which is the unit of parallel and resumable searches.
+     */
+    class Keyspace
+    {
+    public:
+        /* Number of dimensions: reflector, wheel order, plugboard, 3 rings, 3 positions. */
+        static const int numberOfDimensions = 9;
+
+        /* Lazy forward iterator over keys. */
+        class Iterator
+        {
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef KeyspaceKey value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const KeyspaceKey* pointer;
+            typedef const KeyspaceKey& reference;
+
+            /* Empty iterator. */
+            Iterator() noexcept : Space(nullptr), Index(0), Digits(), Key(), Changed(0) {}
+
+            const KeyspaceKey& operator*() const noexcept { return Key; }
+            const KeyspaceKey* operator->() const noexcept { return &Key; }
+
+            /* Steps to the next key, the fastest dimension first. */
+            Iterator& operator++() noexcept;
+            Iterator operator++(int) noexcept
+            {
+                Iterator old = *this;
+                ++*this;
+                return old;
+            }
+
+            bool operator==(const Iterator& other) const noexcept { return Index == other.Index; }
+            bool operator!=(const Iterator& other) const noexcept { return Index != other.Index; }
+
+            /* Index of the current key. */
+            uint64_t getIndex() const noexcept { return Index; }
+
+            /* Returns true at the first key and if the last step changed reflector, wheel order, plugboard or rings (tables must be rebuilt). */
+            bool isNewTable() const noexcept { return Changed < 6; }
+
+        private:
+            friend class Keyspace;
+
+            /* Space of the keys. */
+            const Keyspace* Space;
+
+            /* Index of the current key. */
+            uint64_t Index;
+
+            /* Index of the value of every dimension. */
+            std::array<uint32_t, numberOfDimensions> Digits;
+
+            /* Current key. */
+            KeyspaceKey Key;
+
+            /* Outermost dimension changed by the last step. */
+            int Changed;
+        };
+
+        /**
+         * Constructor.
+         *
+         * Params:
+         * const KeyspaceOptions& Options - values of every dimension.
+         *
+         * Exceptions:
+         * If a dimension is empty, has repeated or invalid values (e.g. a wheel order with a repeated rotor), a plugboard is invalid,
+         * or the space has more than 2^64 - 1 keys, an exception will be thrown.
+         */
+        explicit Keyspace(const KeyspaceOptions& Options) noexcept(false);
+
+        /**
+         * Returns key of given index.
+         *
+         * Params:
+         * uint64_t index - index of the key, less than size().
+         *
+         * Returns:
+         * KeyspaceKey - key.
+         */
+        KeyspaceKey Unrank(uint64_t index) const noexcept;
+
+        /**
+         * Returns index of a key.
+         *
+         * Params:
+         * const KeyspaceKey& key - key.
+         *
+         * Exceptions:
+         * If the key is out of this space, an exception will be thrown.
+         *
+         * Returns:
+         * uint64_t - index of the key.
+         */
+        uint64_t Rank(const KeyspaceKey& key) const noexcept(false);
+
+        /**
+         * Returns index of settings.
+         *
+         * Params:
+         * const UserSettings& settings - settings, the plugboard is matched regardless of the order of connections.
+         *
+         * Exceptions:
+         * If the settings are out of this space, an exception will be thrown.
+         *
+         * Returns:
+         * uint64_t - index of the settings.
+         */
+        uint64_t Rank(const UserSettings& settings) const noexcept(false);
+
+        /**
+         * Converts a key to settings.
+         *
+         * Params:
+         * const KeyspaceKey& key - key of this space.
+         *
+         * Returns:
+         * UserSettings - settings.
+         */
+        UserSettings ToUserSettings(const KeyspaceKey& key) const noexcept;
+
+        /**
+         * Splits the space into balanced shards.
+         *
+         * Params:
+         * size_t count - wanted number of shards.
+         * uint64_t granularity - shards start at multiples of it, e.g. getTableSize() so no table is shared between shards.
+         *
+         * Returns:
+         * std::vector<KeyspaceShard> - consecutive non-empty shards covering the space, at most @count.
+         *   Their numbers of @granularity units differ by at most 1.
+         */
+        std::vector<KeyspaceShard> Split(size_t count, uint64_t granularity = 1) const noexcept;
+
+        /**
+         * Returns iterator at given key.
+         *
+         * Params:
+         * uint64_t index - index of the key, up to size().
+         *
+         * Returns:
+         * Iterator - iterator, end() for size().
+         */
+        Iterator At(uint64_t index) const noexcept;
+
+        Iterator begin() const noexcept { return At(0); }
+        Iterator end() const noexcept { return At(Size); }
+
+        /* Number of keys. */
+        uint64_t size() const noexcept { return Size; }
+
+        /* Number of consecutive keys sharing reflector, wheel order, plugboard and rings (start positions). */
+        uint64_t getTableSize() const noexcept { return Strides[5]; }
+
+        /* Values of every dimension. */
+        const KeyspaceOptions& getOptions() const noexcept { return Options; }
+
+        /* Plugboard of a key as 26 alphabet indices. */
+        const uint8_t* getPlugboard(size_t index) const noexcept { return PlugboardWirings[index].data(); }
+
+    private:
+        /* Writes the value of dimension @dimension with index @digit to @key. */
+        void SetDimension(KeyspaceKey& key, int dimension, uint32_t digit) const noexcept;
+
+        /* Values of every dimension, wheel orders filled in. */
+        KeyspaceOptions Options;
+
+        /* Number of keys. */
+        uint64_t Size;
+
+        /* Number of values of every dimension. */
+        std::array<uint64_t, numberOfDimensions> Radices;
+
+        /* Index distance between consecutive values of every dimension. */
+        std::array<uint64_t, numberOfDimensions> Strides;
+
+        /* Index of every letter in the 6 ring and position dimensions, -1 if not used. */
+        std::array<std::array<int, CompiledKey::alphabetLength>, 6> LetterIndices;
+
+        /* Plugboards as wirings. */
+        std::vector<std::array<uint8_t, CompiledKey::alphabetLength>> PlugboardWirings;
+    };
+}
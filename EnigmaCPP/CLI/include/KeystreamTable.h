@@ -0,0 +1,249 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "CompiledKey.h"
+#include "MappedFile.h"
+
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+namespace Enigma
+{
+    /**
+     * Whole-machine permutations of a key for every rotors position.
+     *
+     * For each of 26^3 positions holds the 26 letter permutation of plugboard, rotors and reflector,
+     * so encryption of a letter is a single lookup after stepping.
+     * The table can be saved to a versioned, page-aligned file and later mapped read-only,
+     * which lets processes share it through the page cache.
+     */
+    class KeystreamTable
+    {
+    public:
+        /* Number of rotors positions. */
+        static const int numberOfStates = CompiledKey::alphabetLength * CompiledKey::alphabetLength * CompiledKey::alphabetLength;
+
+        /* Version of the file format. */
+        static const uint32_t formatVersion = 1;
+
+        /**
+         * Constructor, builds the table in memory.
+         *
+         * Params:
+         * const CompiledKey& Key - key to be expanded.
+         */
+        explicit KeystreamTable(const CompiledKey& Key) noexcept;
+
+        /**
+         * Maps a table saved by Save().
+         *
+         * Params:
+         * const std::string& FilePath - path of the file.
+         * const std::string& CanonicalForm - CompiledKey::CanonicalForm of the expected key.
+         *
+         * Returns:
+         * std::unique_ptr<KeystreamTable> - mapped table, nullptr if the file is missing, damaged,
+         * belongs to other key or was built with other format or wiring tables version.
+         */
+        static std::unique_ptr<KeystreamTable> Open(const std::string& FilePath, const std::string& CanonicalForm) noexcept;
+
+        /**
+         * Saves the table. The file is written under a temporary name, flushed to disk and renamed,
+         * so readers never see a partial file, not even after a crash.
+         *
+         * Params:
+         * const std::string& FilePath - path of the file.
+         * const std::string& CanonicalForm - CompiledKey::CanonicalForm of the key.
+         *
+         * Exceptions:
+         * If the file cannot be written, an exception will be thrown.
+         */
+        void Save(const std::string& FilePath, const std::string& CanonicalForm) const noexcept(false);
+
+        /**
+         * Returns index of a rotors position, (left * 26 + middle) * 26 + right.
+         *
+         * Params:
+         * const RotorPositions& positions - rotors position.
+         *
+         * Returns:
+         * int - index in [0, numberOfStates).
+         */
+        static inline int StateIndex(const RotorPositions& positions) noexcept
+        {
+            return (positions[0] * CompiledKey::alphabetLength + positions[1]) * CompiledKey::alphabetLength + positions[2];
+        }
+
+        /**
+         * Returns the permutation used at rotors position of given index.
+         *
+         * Params:
+         * int state - index of rotors position, see StateIndex().
+         *
+         * Returns:
+         * const uint8_t* - 26 alphabet indices.
+         */
+        inline const uint8_t* getPermutation(int state) const noexcept
+        {
+            return Table + state * CompiledKey::alphabetLength;
+        }
+
+        /**
+         * Returns the stepping of the key as a table: for every state index, index of the state after a key press.
+         * Lets search engines follow the rotors with a single lookup per letter.
+         *
+         * Returns:
+         * std::vector<uint16_t> - numberOfStates successors.
+         */
+        std::vector<uint16_t> NextStates() const noexcept;
+
+        /**
+         * Returns the permutation used at given rotors position.
+         *
+         * Params:
+         * const RotorPositions& positions - rotors position.
+         *
+         * Returns:
+         * const uint8_t* - 26 alphabet indices.
+         */
+        inline const uint8_t* getPermutation(const RotorPositions& positions) const noexcept
+        {
+            return getPermutation(StateIndex(positions));
+        }
+
+        /**
+         * Encrypts/decrypts given letter and advances @positions.
+         *
+         * Params:
+         * int letter - letter as an index in the alphabet (0 - 25).
+         * RotorPositions& positions - current rotors position, will be stepped.
+         *
+         * Returns:
+         * int - encrypted/decrypted letter as an index in the alphabet.
+         */
+        inline int EncryptIndex(int letter, RotorPositions& positions) const noexcept
+        {
+            if (positions[1] == Notches[1])
+            {
+                positions[1] = (positions[1] + 1) % CompiledKey::alphabetLength;
+                positions[0] = (positions[0] + 1) % CompiledKey::alphabetLength;
+            }
+            else if (positions[2] == Notches[2])
+                positions[1] = (positions[1] + 1) % CompiledKey::alphabetLength;
+            positions[2] = (positions[2] + 1) % CompiledKey::alphabetLength;
+            return getPermutation(positions)[letter];
+        }
+
+        /**
+         * Encrypts/decrypts a buffer of alphabet indices.
+         *
+         * Params:
+         * const uint8_t* in - letters as indices in the alphabet.
+         * uint8_t* out - output buffer, may be the same as @in.
+         * size_t length - number of letters.
+         * RotorPositions& positions - current rotors position, will be stepped.
+         */
+        void EncryptIndices(const uint8_t* in, uint8_t* out, size_t length, RotorPositions& positions) const noexcept;
+
+        /**
+         * Encrypts/decrypts given text, same rules as Encoder::EncryptString.
+         *
+         * Params:
+         * const std::string& originalText - text to be encrypted/decrypted.
+         * RotorPositions& positions - current rotors position, will be stepped.
+         *
+         * Returns:
+         * std::string - encrypted/decrypted text.
+         */
+        std::string EncryptString(const std::string& originalText, RotorPositions& positions) const noexcept;
+
+        /**
+         * Returns true if the table is mapped from a file.
+         *
+         * Returns:
+         * bool - true if mapped, false if built in memory.
+         */
+        bool isMapped() const noexcept { return Mapping != nullptr; }
+
+    private:
+        /* Default constructor, used by Open(). */
+        KeystreamTable() noexcept : Table(nullptr) {}
+
+        /* Table built in memory, empty if mapped. */
+        std::vector<uint8_t> Owned;
+
+        /* Mapping of the file, nullptr if built in memory. */
+        std::unique_ptr<MappedFile> Mapping;
+
+        /* numberOfStates permutations, either in @Owned or in @Mapping. */
+        const uint8_t* Table;
+
+        /* Turnover positions from left to right. */
+        int Notches[3];
+    };
+
+    /**
+     * Directory of saved keystream tables.
+     *
+     * A table is looked up by the hash of CompiledKey::CanonicalForm. Missing or stale files
+     * (other format or wiring tables version) are rebuilt and saved, otherwise getting a table is a single mmap.
+     * Tables mapped by this object are kept and shared.
+     */
+    class KeystreamCache
+    {
+    public:
+        /**
+         * Constructor.
+         *
+         * Params:
+         * const std::string& Directory - existing directory holding the tables.
+         */
+        explicit KeystreamCache(const std::string& Directory) noexcept : Directory(Directory) {}
+
+        /**
+         * Returns table of given settings, mapping or building it if needed.
+         *
+         * Params:
+         * const UserSettings& USettings - settings, rotors position is ignored.
+         *
+         * Exceptions:
+         * If @USettings are invalid or a rebuilt table cannot be saved, an exception will be thrown.
+         *
+         * Returns:
+         * std::shared_ptr<const KeystreamTable> - table of the key.
+         */
+        std::shared_ptr<const KeystreamTable> Get(const UserSettings& USettings) noexcept(false);
+
+        /**
+         * Returns path of the file holding table of given settings.
+         *
+         * Params:
+         * const UserSettings& USettings - settings.
+         *
+         * Exceptions:
+         * If any plugboard connection is invalid, an exception will be thrown.
+         *
+         * Returns:
+         * std::string - path of the file.
+         */
+        std::string PathOf(const UserSettings& USettings) const noexcept(false);
+
+    private:
+        /* Directory holding the tables. */
+        std::string Directory;
+
+        /* Tables already used by this process, by canonical form. */
+        std::unordered_map<std::string, std::shared_ptr<const KeystreamTable>> Loaded;
+
+        /* Guards @Loaded. */
+        std::mutex Lock;
+    };
+}
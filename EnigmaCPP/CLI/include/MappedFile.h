@@ -0,0 +1,75 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace Enigma
+{
+    /**
+     * Read-only memory mapping of a whole file.
+     *
+     * Pages are shared with other processes through the page cache.
+     */
+    class MappedFile
+    {
+    public:
+        /**
+         * Constructor, maps given file.
+         *
+         * Params:
+         * const std::string& FilePath - path of the file.
+         *
+         * Exceptions:
+         * If the file cannot be opened or mapped, an exception will be thrown.
+         */
+        explicit MappedFile(const std::string& FilePath) noexcept(false);
+
+        /* Destructor, unmaps the file. */
+        ~MappedFile() noexcept;
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /**
+         * Returns mapped content.
+         *
+         * Returns:
+         * const char* - first byte of the file, nullptr for an empty file.
+         */
+        const char* getData() const noexcept { return Data; }
+
+        /**
+         * Returns size of the file.
+         *
+         * Returns:
+         * size_t - size in bytes.
+         */
+        size_t getSize() const noexcept { return Size; }
+
+    private:
+        /* Mapped content. */
+        const char* Data;
+
+        /* Size of the mapping. */
+        size_t Size;
+    };
+
+    /**
+     * Publishes a written temporary file under its final name. Data is flushed to the disk before the rename,
+     * so a crash cannot leave a truncated file under @FilePath. On failure the temporary file is removed.
+     *
+     * Params:
+     * const std::string& TmpPath - temporary file, written and closed.
+     * const std::string& FilePath - final path.
+     * bool Written - false if writing the temporary file failed.
+     *
+     * Exceptions:
+     * If @Written is false or flushing or renaming fails, an exception will be thrown.
+     */
+    void PublishFile(const std::string& TmpPath, const std::string& FilePath, bool Written) noexcept(false);
+}
@@ -0,0 +1,218 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "MappedFile.h"
+#include "NumaTopology.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Enigma
+{
+    /* Type of values of an n-gram table. */
+    enum NgramValueType : uint32_t
+    {
+        /* log10 probability as float. */
+        NgramFloat32 = 0,
+        /* log10 probability * NgramModel::int16Scale, rounded; half the size of float, so quadgrams fit in L2 cache. */
+        NgramInt16 = 1
+    };
+
+    /**
+     * Language model of letter n-grams (n = 1 - 4).
+     *
+     * Holds log10 probability of every one of 26^n n-grams in a flat table indexed by
+     * letters read as a base-26 number, so scoring a text is a lookup per letter.
+     * N-grams absent from the corpus get a floor probability.
+     * Models are saved to versioned, page-aligned files and mapped read-only, so loading takes a single mmap.
+     */
+    class NgramModel
+    {
+    public:
+        /* Highest supported n. */
+        static const int maxOrder = 4;
+
+        /* Version of the file format. */
+        static const uint32_t formatVersion = 1;
+
+        /* Multiplier of log10 probabilities stored as int16. */
+        static const int int16Scale = 1000;
+
+        /**
+         * Counts n-grams of a corpus.
+         *
+         * Params:
+         * const char* Corpus - training text, characters out of the alphabet are skipped.
+         * size_t Length - length of the text.
+         * int Order - n, 1 - maxOrder.
+         * const std::string& Language - name of the language stored with the model, e.g. "de", at most 15 characters.
+         * NgramValueType Type - type of table values.
+         *
+         * Exceptions:
+         * If @Order is out of range or the corpus holds no n-gram, an exception will be thrown.
+         *
+         * Returns:
+         * NgramModel - trained model.
+         */
+        static NgramModel Train(const char* Corpus, size_t Length, int Order, const std::string& Language = "", NgramValueType Type = NgramFloat32) noexcept(false);
+
+        /**
+         * Same as Train(const char*, size_t, ...).
+         */
+        static NgramModel Train(const std::string& Corpus, int Order, const std::string& Language = "", NgramValueType Type = NgramFloat32) noexcept(false)
+        {
+            return Train(Corpus.data(), Corpus.size(), Order, Language, Type);
+        }
+
+        /**
+         * Maps a model saved by Save().
+         *
+         * Params:
+         * const std::string& FilePath - path of the file.
+         *
+         * Exceptions:
+         * If the file cannot be mapped, is damaged or has other format version, an exception will be thrown.
+         *
+         * Returns:
+         * NgramModel - mapped model.
+         */
+        static NgramModel Load(const std::string& FilePath) noexcept(false);
+
+        /**
+         * Saves the model. The file is written under a temporary name and renamed.
+         *
+         * Params:
+         * const std::string& FilePath - path of the file.
+         *
+         * Exceptions:
+         * If the file cannot be written, an exception will be thrown.
+         */
+        void Save(const std::string& FilePath) const noexcept(false);
+
+        /**
+         * Returns sum of log10 probabilities of all n-grams of a text.
+         * Indices of n-grams are computed in blocks without dependencies between letters,
+         * so the compiler vectorizes them; lookups are summed into independent accumulators.
+         *
+         * Params:
+         * const uint8_t* text - letters as indices in the alphabet.
+         * size_t length - number of letters.
+         *
+         * Returns:
+         * double - score, higher means more alike the corpus.
+         */
+        double Score(const uint8_t* text, size_t length) const noexcept;
+
+        /**
+         * Copies the table to the memory of every NUMA node, then Score() reads the copy of the node
+         * the calling thread runs on, so threads of a pinned ThreadPool do not cross sockets.
+         * Calling it again replaces the copies.
+         *
+         * Params:
+         * bool HugePages - true to back the copies by transparent huge pages.
+         *
+         * Exceptions:
+         * If memory cannot be mapped, an exception will be thrown.
+         */
+        void Replicate(bool HugePages = true) noexcept(false);
+
+        /**
+         * Returns true if the table has per-node copies.
+         *
+         * Returns:
+         * bool - true after Replicate().
+         */
+        bool isReplicated() const noexcept { return !Replicas.empty(); }
+
+        /**
+         * Returns log10 probability of an n-gram.
+         *
+         * Params:
+         * size_t index - n-gram as a base-26 number, first letter is the most significant.
+         *
+         * Returns:
+         * float - log10 probability.
+         */
+        float getLogProbability(size_t index) const noexcept
+        {
+            return Type == NgramFloat32 ? Floats[index] : (float)Int16s[index] / int16Scale;
+        }
+
+        /**
+         * Returns n.
+         *
+         * Returns:
+         * int - order of the model.
+         */
+        int getOrder() const noexcept { return Order; }
+
+        /**
+         * Returns type of table values.
+         *
+         * Returns:
+         * NgramValueType - type.
+         */
+        NgramValueType getValueType() const noexcept { return Type; }
+
+        /**
+         * Returns language given when training.
+         *
+         * Returns:
+         * const std::string& - language.
+         */
+        const std::string& getLanguage() const noexcept { return Language; }
+
+        /**
+         * Returns number of entries of the table, 26^n.
+         *
+         * Returns:
+         * size_t - number of n-grams.
+         */
+        size_t size() const noexcept { return Size; }
+
+        /**
+         * Returns true if the model is mapped from a file.
+         *
+         * Returns:
+         * bool - true if mapped, false if trained in memory.
+         */
+        bool isMapped() const noexcept { return Mapping != nullptr; }
+
+    private:
+        /* Constructor, used by Train() and Load(). */
+        NgramModel(int Order, NgramValueType Type, const std::string& Language) noexcept;
+
+        /* n. */
+        int Order;
+
+        /* Type of values. */
+        NgramValueType Type;
+
+        /* Language given when training. */
+        std::string Language;
+
+        /* Number of entries, 26^n. */
+        size_t Size;
+
+        /* Tables of a trained model, empty if mapped. */
+        std::vector<float> OwnedFloats;
+        std::vector<int16_t> OwnedInt16s;
+
+        /* Mapping of the file, nullptr if trained in memory. */
+        std::unique_ptr<MappedFile> Mapping;
+
+        /* Table used for scoring, the one matching @Type, the other is nullptr. */
+        const float* Floats;
+        const int16_t* Int16s;
+
+        /* Copies of the table on every node, empty if not replicated. */
+        std::vector<NodeBuffer> Replicas;
+    };
+}
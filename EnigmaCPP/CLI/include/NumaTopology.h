@@ -0,0 +1,179 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace Enigma
+{
+    /* Placement of worker threads of a ThreadPool. */
+    enum ThreadPlacement
+    {
+        /* Threads are not pinned, the scheduler moves them freely. */
+        PlacementNone = 0,
+        /* Threads are pinned to CPUs of the first node, then of the next one, so they share caches and replicas. */
+        PlacementCompact = 1,
+        /* Threads are pinned round-robin across nodes, so every node's memory bandwidth is used. */
+        PlacementSpread = 2
+    };
+
+    /**
+     * NUMA nodes and CPUs the process may run on.
+     *
+     * Read once from /sys/devices/system/node and limited to the affinity mask of the process,
+     * so taskset and cgroups are respected. A machine without NUMA information is a single node.
+     */
+    class NumaTopology
+    {
+    public:
+        /**
+         * Returns topology of this machine, read on the first call.
+         *
+         * Returns:
+         * const NumaTopology& - topology.
+         */
+        static const NumaTopology& System() noexcept;
+
+        /**
+         * Returns number of nodes with at least one usable CPU.
+         *
+         * Returns:
+         * int - number of nodes.
+         */
+        int getNumberOfNodes() const noexcept { return (int)Cpus.size(); }
+
+        /**
+         * Returns usable CPUs of a node.
+         *
+         * Params:
+         * int node - node, 0 - getNumberOfNodes() - 1 (not the kernel's node number).
+         *
+         * Returns:
+         * const std::vector<int>& - CPU numbers.
+         */
+        const std::vector<int>& getCpus(int node) const noexcept { return Cpus[node]; }
+
+        /**
+         * Returns node of a CPU.
+         *
+         * Params:
+         * int cpu - CPU number.
+         *
+         * Returns:
+         * int - node, 0 if the CPU is unknown.
+         */
+        int NodeOf(int cpu) const noexcept;
+
+        /**
+         * Chooses CPUs for threads.
+         *
+         * Params:
+         * int count - number of threads.
+         * ThreadPlacement placement - placement, PlacementNone gives an empty list.
+         *
+         * Returns:
+         * std::vector<int> - CPU of every thread, CPUs are reused if there are more threads than CPUs.
+         */
+        std::vector<int> Place(int count, ThreadPlacement placement) const noexcept;
+
+        /**
+         * Pins the calling thread to a CPU and remembers its node for CurrentNode().
+         *
+         * Params:
+         * int cpu - CPU number.
+         *
+         * Returns:
+         * bool - true on success.
+         */
+        bool PinCurrentThread(int cpu) const noexcept;
+
+        /**
+         * Returns node the calling thread runs on: the one it is pinned to,
+         * otherwise the node of the CPU it runs on at the moment.
+         *
+         * Returns:
+         * int - node, 0 - getNumberOfNodes() - 1.
+         */
+        int CurrentNode() const noexcept;
+
+    private:
+        /* Reads the topology. */
+        NumaTopology() noexcept;
+
+        /* Usable CPUs of every node. */
+        std::vector<std::vector<int>> Cpus;
+
+        /* Node of every CPU number, -1 if unusable. */
+        std::vector<int> Nodes;
+
+        /* Kernel's number of every node, used by memory policies. */
+        std::vector<int> KernelNodes;
+
+        friend class NodeBuffer;
+    };
+
+    /**
+     * Memory placed on a NUMA node, optionally backed by transparent huge pages.
+     *
+     * Pages are mapped anonymously with a preferred-node policy before they are touched,
+     * so they come from the node's memory even if the buffer is filled by a thread running elsewhere.
+     * Huge pages cut TLB misses of big lookup tables; they are a hint the kernel may ignore.
+     */
+    class NodeBuffer
+    {
+    public:
+        /* Constructor, empty buffer. */
+        NodeBuffer() noexcept : Data(nullptr), Size(0), Mapped(0) {}
+
+        /**
+         * Constructor, maps memory.
+         *
+         * Params:
+         * size_t size - size in bytes.
+         * int node - node, 0 - getNumberOfNodes() - 1 of NumaTopology::System().
+         * bool hugePages - true to ask for transparent huge pages.
+         *
+         * Exceptions:
+         * If memory cannot be mapped, an exception will be thrown.
+         */
+        NodeBuffer(size_t size, int node, bool hugePages) noexcept(false);
+
+        /* Destructor, unmaps memory. */
+        ~NodeBuffer() noexcept;
+
+        NodeBuffer(const NodeBuffer&) = delete;
+        NodeBuffer& operator=(const NodeBuffer&) = delete;
+        NodeBuffer(NodeBuffer&& other) noexcept;
+        NodeBuffer& operator=(NodeBuffer&& other) noexcept;
+
+        /**
+         * Returns the memory.
+         *
+         * Returns:
+         * void* - first byte, nullptr if empty.
+         */
+        void* data() const noexcept { return Data; }
+
+        /**
+         * Returns size given to the constructor.
+         *
+         * Returns:
+         * size_t - size in bytes.
+         */
+        size_t size() const noexcept { return Size; }
+
+    private:
+        /* Memory. */
+        void* Data;
+
+        /* Requested size. */
+        size_t Size;
+
+        /* Mapped size, rounded up to the page (or huge page) size. */
+        size_t Mapped;
+    };
+}
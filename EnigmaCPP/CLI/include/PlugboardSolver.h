@@ -0,0 +1,135 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "CompiledKey.h"
+#include "NgramModel.h"
+#include "ThreadPool.h"
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Enigma
+{
+    /* Plugboard wiring, every unused letter is mapped to itself. */
+    typedef std::array<uint8_t, 26> PlugboardWiring;
+
+    /* Options of PlugboardSolver. */
+    struct PlugboardSolverOptions
+    {
+        /* Number of hill-climbing runs, the first one starts from empty plugboard, others from random cables. */
+        int Restarts = 16;
+
+        /* Max number of cables, 13 is the limit of the machine. */
+        int MaxCables = 13;
+
+        /* If true, every run first climbs on the index of coincidence, which works with few correct cables. */
+        bool IocStage = true;
+
+        /* Seed of random starts, the same seed gives the same result. */
+        uint64_t Seed = 1;
+    };
+
+    /* Result of PlugboardSolver. */
+    struct PlugboardSolution
+    {
+        /* Score of the decryption given by the last stage. */
+        double Score;
+
+        /* Found wiring. */
+        PlugboardWiring Plugboard;
+
+        /* Index of the run which found the wiring. */
+        int Restart;
+
+        /**
+         * Returns the wiring as plugboard connections accepted by UserSettings, e.g. "AZ".
+         *
+         * Returns:
+         * std::vector<std::string> - connections.
+         */
+        std::vector<std::string> getConnections() const noexcept;
+    };
+
+    /**
+     * Recovers plugboard connections when the rest of the key is known.
+     *
+     * The permutation of rotors and reflector at every letter of the ciphertext does not depend on the plugboard,
+     * so it is computed once; decryption with a candidate plugboard P is then P[core[P[c]]] per letter.
+     * Every run hill-climbs over swaps of cables, scoring with the stages in order (index of coincidence,
+     * then given n-gram models, e.g. bigrams, trigrams, quadgrams). Runs are spread across a thread pool.
+     */
+    class PlugboardSolver
+    {
+    public:
+        /**
+         * Constructor, computes rotors and reflector permutations for every letter of the ciphertext.
+         *
+         * Params:
+         * const UserSettings& RotorSettings - reflector, rotors, rings and start position; plugboard is ignored.
+         * const std::string& CipherText - ciphertext, characters out of the alphabet are skipped.
+         *
+         * Exceptions:
+         * If @RotorSettings are invalid, an exception will be thrown.
+         */
+        PlugboardSolver(const UserSettings& RotorSettings, const std::string& CipherText) noexcept(false);
+
+        /**
+         * Runs all restarts and returns the best result.
+         *
+         * Params:
+         * const std::vector<const NgramModel*>& Models - n-gram models used as stages, in order.
+         * const PlugboardSolverOptions& options - options.
+         * ThreadPool& pool - threads used for the restarts.
+         *
+         * Returns:
+         * PlugboardSolution - best wiring, ties go to the lowest run index.
+         */
+        PlugboardSolution Solve(const std::vector<const NgramModel*>& Models, const PlugboardSolverOptions& options, ThreadPool& pool) const noexcept;
+
+        /**
+         * Hill-climbs from given wiring until no swap of cables improves the score of any stage.
+         *
+         * Params:
+         * PlugboardWiring start - initial wiring.
+         * const std::vector<const NgramModel*>& Models - n-gram models used as stages, in order.
+         * const PlugboardSolverOptions& options - options.
+         *
+         * Returns:
+         * PlugboardSolution - local optimum, Restart is 0.
+         */
+        PlugboardSolution Climb(PlugboardWiring start, const std::vector<const NgramModel*>& Models, const PlugboardSolverOptions& options) const noexcept;
+
+        /**
+         * Decrypts the ciphertext with given plugboard.
+         *
+         * Params:
+         * const PlugboardWiring& plugboard - wiring.
+         * uint8_t* out - output buffer of getLength() letters.
+         */
+        void Decrypt(const PlugboardWiring& plugboard, uint8_t* out) const noexcept;
+
+        /**
+         * Returns number of letters of the ciphertext.
+         *
+         * Returns:
+         * size_t - length.
+         */
+        size_t getLength() const noexcept { return Text.size(); }
+
+    private:
+        /* Scores a wiring with a stage, nullptr model means index of coincidence. */
+        double Evaluate(const PlugboardWiring& plugboard, const NgramModel* model, uint8_t* buffer) const noexcept;
+
+        /* Ciphertext as alphabet indices. */
+        std::vector<uint8_t> Text;
+
+        /* Permutation of rotors and reflector for every letter, 26 entries per letter. */
+        std::vector<uint8_t> Core;
+    };
+}
@@ -0,0 +1,145 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "NumaTopology.h"
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <functional>
+#include <condition_variable>
+
+namespace Enigma
+{
+    /* Options of ThreadPool. */
+    struct ThreadPoolOptions
+    {
+        /* Total number of threads running a loop (including the caller), if < 1 then std::thread::hardware_concurrency(). */
+        int NumberOfThreads = 0;
+
+        /* Pinning of worker threads to CPUs. */
+        ThreadPlacement Placement = PlacementNone;
+    };
+
+    /**
+     * Fixed set of worker threads running parallel loops.
+     *
+     * Used by all batch and search engines of the library.
+     * Only one loop runs at a time, the calling thread takes part in it.
+     * Workers may be pinned to CPUs chosen by NumaTopology::Place(); the calling thread is never pinned,
+     * it takes the CPU of the first slot only if the caller pins it itself.
+     */
+    class ThreadPool
+    {
+    public:
+        /**
+         * Constructor, starts worker threads.
+         *
+         * Params:
+         * int NumberOfThreads - total number of threads running a loop (including the caller),
+         * if < 1 then std::thread::hardware_concurrency() is used.
+         */
+        explicit ThreadPool(int NumberOfThreads = 0) noexcept(false);
+
+        /**
+         * Constructor, starts worker threads and pins them as requested.
+         * A worker that cannot be pinned (e.g. its CPU is not allowed) runs unpinned.
+         *
+         * Params:
+         * const ThreadPoolOptions& options - options.
+         */
+        explicit ThreadPool(const ThreadPoolOptions& options) noexcept(false);
+
+        /* Destructor, joins worker threads. */
+        ~ThreadPool() noexcept;
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * Calls @task for every index in [0, count) and waits for all of them.
+         * Indices are handed out dynamically, one at a time, so tasks may differ in cost.
+         *
+         * Params:
+         * size_t count - number of tasks.
+         * const std::function<void(size_t)>& task - task, called with index of the task.
+         *
+         * Exceptions:
+         * Tasks must not throw.
+         */
+        void ParallelFor(size_t count, const std::function<void(size_t)>& task) noexcept;
+
+        /**
+         * Returns number of threads running a loop (including the caller).
+         *
+         * Returns:
+         * int - number of threads.
+         */
+        int getSize() const noexcept { return (int)Workers.size() + 1; }
+
+        /**
+         * Returns placement of worker threads.
+         *
+         * Returns:
+         * ThreadPlacement - placement given to the constructor.
+         */
+        ThreadPlacement getPlacement() const noexcept { return Placement; }
+
+    private:
+        /* Worker threads. */
+        std::vector<std::thread> Workers;
+
+        /* Guards loop publication. */
+        std::mutex Lock;
+
+        /* Signals a new loop or shutdown to workers. */
+        std::condition_variable WakeUp;
+
+        /* Signals the end of a loop to the caller. */
+        std::condition_variable Finished;
+
+        /* Task of the current loop. */
+        const std::function<void(size_t)>* Task;
+
+        /* Number of tasks of the current loop. */
+        size_t Count;
+
+        /* Next index to be handed out. */
+        std::atomic<size_t> Next;
+
+        /* Number of workers that still run the current loop. */
+        int Busy;
+
+        /* Pinning of worker threads. */
+        ThreadPlacement Placement;
+
+        /* Increased for every loop, lets workers recognize a new one. */
+        unsigned long Generation;
+
+        /* True when the pool is being destroyed. */
+        bool Stopping;
+
+        /**
+         * Runs tasks of the current loop until none is left.
+         *
+         * Params:
+         * const std::function<void(size_t)>& task - task of the loop.
+         * size_t count - number of tasks of the loop.
+         */
+        void Drain(const std::function<void(size_t)>& task, size_t count) noexcept;
+
+        /**
+         * Main function of a worker thread.
+         *
+         * Params:
+         * int cpu - CPU the thread is pinned to, -1 to leave it unpinned.
+         */
+        void WorkerLoop(int cpu) noexcept;
+    };
+}
@@ -0,0 +1,120 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "CompiledKey.h"
+#include "ThreadPool.h"
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Enigma
+{
+    /* Intercepted message header: Grundstellung sent in clear and the doubled message key encrypted at it. */
+    struct ZygalskiIndicator
+    {
+        /* 3 letters, rotors position chosen by the operator. */
+        std::string Grundstellung;
+
+        /* 6 letters, encrypted doubled message key. */
+        std::string Indicator;
+    };
+
+    /* Options of ZygalskiSheets::Run. */
+    struct ZygalskiOptions
+    {
+        /* Reflectors to be searched. */
+        std::vector<ReflectorID> Reflectors = {B, C};
+
+        /* Max number of survivors kept and verified per wheel order. */
+        size_t MaxSurvivors = 100;
+    };
+
+    /* Ring settings left by the sheets of a wheel order. */
+    struct ZygalskiSurvivor
+    {
+        /* ID of the reflector. */
+        ReflectorID Reflector;
+
+        /* Rotors from left to right. */
+        std::array<RotorID, 3> Rotors;
+
+        /* Ring settings from left to right (0 - 25). */
+        std::array<int, 3> Rings;
+
+        /* True if Encoder with these settings allows every used female. */
+        bool Verified;
+    };
+
+    /* Result of ZygalskiSheets::Run. */
+    struct ZygalskiResult
+    {
+        /* Survivors of all wheel orders, verified ones first. */
+        std::vector<ZygalskiSurvivor> Survivors;
+
+        /* Number of survivors before MaxSurvivors was applied. */
+        uint64_t NumberOfSurvivors;
+
+        /* Number of females (equal letters i and i + 3) in the indicators. */
+        size_t Females;
+
+        /* Number of sheets laid over all wheel orders, females with a turnover inside the indicator are skipped. */
+        uint64_t SheetsApplied;
+
+        /* Wall time of the search in seconds. */
+        double Seconds;
+    };
+
+    /**
+     * Zygalski sheets.
+     *
+     * A female is a doubled indicator whose letters i and i + 3 are equal. It is possible only if the product
+     * of the permutations of key presses i and i + 3 has a fixed point, which does not depend on the plugboard.
+     * With rotors position and ring setting only their difference (the core offset) matters, so a sheet is a bitmap
+     * over 26^3 core offsets marking those where a female can occur, with the right rotor alone stepping.
+     *
+     * For a message with Grundstellung G the unknown rings R must have the bit G - R set, so every female shifts
+     * its sheet by its G and the sheets are intersected. The bitmap is held as 676 rows of 26 bits (left, middle
+     * offset), a shift moves rows and rotates them, and the intersection is a wide AND of rows, 8 at a time with AVX2.
+     * Females whose indicator has a middle or left rotor step are skipped, as their sheet would not be a plain shift.
+     * Wheel orders run in parallel, surviving rings are verified with Encoder.
+     */
+    class ZygalskiSheets
+    {
+    public:
+        /**
+         * Runs the sheets.
+         *
+         * Params:
+         * const std::vector<ZygalskiIndicator>& indicators - intercepted message headers.
+         * const ZygalskiOptions& options - options.
+         * ThreadPool& pool - threads used for the search.
+         *
+         * Exceptions:
+         * If a Grundstellung is not 3 letters or an indicator is not 6 letters, an exception will be thrown.
+         * Lower case letters are accepted.
+         *
+         * Returns:
+         * ZygalskiResult - surviving settings and statistics.
+         */
+        static ZygalskiResult Run(const std::vector<ZygalskiIndicator>& indicators, const ZygalskiOptions& options, ThreadPool& pool) noexcept(false);
+
+        /**
+         * Checks with Encoder that settings allow a female.
+         *
+         * Params:
+         * const ZygalskiSurvivor& settings - reflector, rotors and rings.
+         * const std::string& grundstellung - 3 letters.
+         * int pair - index of the female pair (0 - 2): letters pair and pair + 3.
+         *
+         * Returns:
+         * bool - true if some message key encrypts letters pair and pair + 3 to the same letter.
+         */
+        static bool AllowsFemale(const ZygalskiSurvivor& settings, const std::string& grundstellung, int pair) noexcept(false);
+    };
+}
@@ -4,6 +4,12 @@
 */
 
 #include "Encrypter.h"
+#include "Daemon.h"
+#include "KeySheetCommand.h"
+#include "AttackCommand.h"
+#include "CatalogCommand.h"
+#include "AnalyzeCommand.h"
+#include "Cluster.h"
 
 #include <string>
 #include <vector>
@@ -23,14 +29,56 @@ int main(int argc, char *argv[])
             std::string com = argv[1];
             if (com == "-e")
             {
+                EncryptOptions options = Encrypter::ExtractOptions(argc, argv);
                 Encrypter Enigma(argc, argv);
+                Enigma.setOptions(options);
                 Enigma.EncryptFile(argv[2]);
             }
             else if (com == "-s")
             {
+                EncryptOptions options = Encrypter::ExtractOptions(argc, argv);
                 Encrypter Enigma(argc, argv);
+                Enigma.setOptions(options);
                 Enigma.EncryptString(argv[2]);
             }
+            else if (com == "-ie" || com == "-id")
+            {
+                bool doubled = Encrypter::ExtractDoubled(argc, argv);
+                Encrypter Enigma(argc, argv);
+                Enigma.ProcessIndicatorBatch(argv[2], com == "-ie", doubled);
+            }
+            else if (com == "-d" && argc == 3)
+            {
+                Daemon server(argv[2]);
+                server.Run();
+            }
+            else if (com == "-k" && (argc == 3 || argc == 4))
+            {
+                KeySheetCommand::Run(argv[2], argc == 4 ? argv[3] : nullptr);
+            }
+            else if (com == "--attack")
+            {
+                AttackCommand::Run(argc, argv);
+            }
+            else if (com == "--catalog")
+            {
+                CatalogCommand::Run(argc, argv);
+            }
+            else if (com == "--analyze")
+            {
+                AnalyzeCommand::Run(argc, argv);
+            }
+            else if (com == "--coordinator" && argc >= 4)
+            {
+                Coordinator server(AttackCommand::ReadCipherText(argv[2]), argv[3], argc > 4 ? std::stoul(argv[4]) : 10,
+                                   argc > 5 && std::string(argv[5]) == "rings");
+                server.Run();
+            }
+            else if (com == "--worker" && (argc == 3 || argc == 4))
+            {
+                Worker client(argv[2], argc == 4 ? std::stoi(argv[3]) : 0);
+                client.Run();
+            }
             else if (com == "-h")
             {
                 DisplayHelp();
@@ -57,6 +105,49 @@ void DisplayHelp()
     EnigmaCPP -e [file path] [reflector B/C/ETW] 3x [rotor number I-V] 3x [rotor initial position] + 3x [rotor ring setting] (optional plug board connections max. 13) \n\n \
     -s -> Encrypt string \n \
     EnigmaCPP -s [string] [reflector B/C/ETW] 3x [rotor number I-V] 3x [rotor initial position] + 3x [rotor ring setting] (optional plug board connections max. 13) \n\n \
+    Options of -e and -s (after the file path or string): --max-size [MB] refuses bigger files, \n \
+    --progress / --no-progress reports speed and ETA on stderr (default: only if stderr is a terminal), \n \
+    --stats-json [path] writes bytes, letters, wall and CPU time, MB/s and final rotors position as JSON \n\n \
+    -ie / -id -> Indicator procedure over a batch file (one message per line: message key or indicator, then body), \n \
+    settings are the daily key with Grundstellung as rotors position, --doubled types message keys twice (6 letter indicators) \n \
+    EnigmaCPP -ie [batch path] [reflector B/C/ETW] 3x [rotor number I-V] 3x [Grundstellung] + 3x [rotor ring setting] (optional plug board connections max. 13) (--doubled) \n\n \
+    -d -> Run as a daemon serving requests on a Unix socket (see DaemonProtocol.h) \n \
+    EnigmaCPP -d [socket path] \n\n \
+    -k -> Load and validate a key sheet (one key per line, same order as above), optionally save it in binary form \n \
+    EnigmaCPP -k [key sheet path] (binary key sheet output path) \n\n \
+    --attack ioc -> Ciphertext-only search of reflector, wheel order and start position (empty plug board), scored by index of coincidence \n \
+    With rings the middle and right ring settings are searched too, one key per class of equivalent (position, ring setting) \n \
+    Early abort drops keys whose index of coincidence over half of the text is 3 standard errors below the kept candidates, noabort disables it \n \
+    EnigmaCPP --attack ioc [ciphertext path] (number of candidates = 10) (rings) (noabort) \n\n \
+    --attack plugs -> Recover plug board connections by hill climbing scored with n-grams of a corpus \n \
+    Without settings the rotors are taken from the best candidates of --attack ioc \n \
+    Models are a corpus or comma separated .engm files made by EnigmaNgramTrain, used in given order \n \
+    EnigmaCPP --attack plugs [ciphertext path] [corpus path / models] ([reflector B/C/ETW] 3x [rotor number I-V] 3x [rotor initial position] + 3x [rotor ring setting]) \n\n \
+    --attack bombe -> Turing-Welchman bombe: wheel order, start position and steckers from a crib (known plaintext) \n \
+    Rings are AAA, so a key with another right ring is missed if the crib spans a turnover (always with 26+ letters); \n \
+    with rings the middle and right ring settings are searched too, one key per turnover class (many times slower) \n \
+    EnigmaCPP --attack bombe [ciphertext path] [crib] (position of the crib in the ciphertext = 0) (rings) \n\n \
+    --attack drag -> Crib dragging: offsets where cribs can be placed (Enigma never encrypts a letter to itself) \n \
+    EnigmaCPP --attack drag [ciphertext path] [crib] (more cribs) \n\n \
+    --catalog build -> Build Rejewski's catalog of the characteristic (cycles of AD, BE, CF) of doubled indicators \n \
+    EnigmaCPP --catalog build [output path] (rings = AAA) \n\n \
+    --catalog find -> Find Grundstellungen matching doubled indicators of a day (indicator first on every line) \n \
+    EnigmaCPP --catalog find [catalog path] [indicators path] \n\n \
+    --attack zygalski -> Zygalski sheets: wheel order and rings from females of doubled indicators (line: Grundstellung indicator) \n \
+    EnigmaCPP --attack zygalski [message headers path] \n\n \
+    --attack depth -> Find messages in depth (same or overlapping keystream), one ciphertext per line \n \
+    EnigmaCPP --attack depth [messages path] (max relative offset = 10) (listed pairs = 20) \n\n \
+    --attack scan -> Resumable index of coincidence search over reflectors, wheel orders and start positions \n \
+    Progress is saved to the checkpoint every few seconds and on SIGINT, the same command resumes it \n \
+    With rings the middle and right ring settings are searched too \n \
+    EnigmaCPP --attack scan [ciphertext path] [checkpoint path] (number of candidates = 10) (rings) \n\n \
+    --coordinator -> Distributed --attack scan: hands out shards of the keyspace to workers connected over TCP \n \
+    Shards of lost workers are searched again, progress and speed of all workers are printed every second \n \
+    EnigmaCPP --coordinator [ciphertext path] [address:port] (number of candidates = 10) (rings) \n\n \
+    --worker -> Search shards given by a coordinator on all threads (or given number of them) \n \
+    EnigmaCPP --worker [address:port] (number of threads) \n\n \
+    --analyze -> Letter counts, index of coincidence and repeated trigrams (Kasiski) of files (directories recursively), files in parallel, as JSON \n \
+    EnigmaCPP --analyze [JSON output path or -] [file or directory path] (more paths) \n\n \
     -h -> Display this help \n\n \
     Example: \n \
     EnigmaCPP -e text.txt B I II III C B D F G D AZ BC \n";
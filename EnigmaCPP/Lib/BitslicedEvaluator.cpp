@@ -0,0 +1,349 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "BitslicedEvaluator.h"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace Enigma;
+
+namespace
+{
+#if defined(__AVX512F__)
+    typedef uint64_t LaneWord __attribute__((vector_size(64)));
+#elif defined(__AVX2__)
+    typedef uint64_t LaneWord __attribute__((vector_size(32)));
+#else
+    typedef uint64_t LaneWord __attribute__((vector_size(16)));
+#endif
+
+    const int alphabetLength = CompiledKey::alphabetLength;
+    const int wordsPerLane = sizeof(LaneWord) / sizeof(uint64_t);
+    const int numberOfLanes = wordsPerLane * 64;
+
+    /* Bits of a number 0 - 25. */
+    const int numberOfPlanes = 5;
+
+    /* Max number of different wirings in a rotor slot, one per RotorID / ReflectorID. */
+    const int maxWirings = 8;
+
+    /* Letter held one-hot: bit of a lane is set in exactly one of the words. */
+    typedef LaneWord Letter[alphabetLength];
+
+    /* Number 0 - 25 held as bit-planes, least significant first. */
+    typedef LaneWord Number[numberOfPlanes];
+
+    /* Wiring (and its inverse) used by lanes of @Mask. */
+    struct WiringGroup
+    {
+        uint8_t Wiring[alphabetLength];
+        uint8_t Inverse[alphabetLength];
+        LaneWord Mask;
+        /* Wiring as 4 overlapping words, compared instead of memcmp when grouping lanes. */
+        uint64_t Key[4];
+    };
+
+    /* Wirings of a slot (rotor direction or reflector). */
+    struct Wirings
+    {
+        WiringGroup Groups[maxWirings];
+        int Count;
+        /* Group of the last added lane. */
+        int Last;
+    };
+
+    /* Keys of a Test() call in bitsliced form. */
+    struct Batch
+    {
+        /* Position - ring of every rotor, left to right. */
+        Number Offsets[3];
+
+        /* Offset at which middle and right rotor step the next one. */
+        Number NotchOffsets[3];
+
+        /* Rotors from left to right, inverse wirings are the backward paths. */
+        Wirings Rotors[3];
+        Wirings Reflector;
+
+        /* Plugboard[a][b] has bits of lanes whose plugboard maps a to b. */
+        Letter Plugboard[alphabetLength];
+
+        /* Lanes holding a key. */
+        LaneWord Valid;
+    };
+
+    inline bool IsZero(const LaneWord& word) noexcept
+    {
+        uint64_t any = 0;
+        for (int i = 0; i < wordsPerLane; i++)
+            any |= word[i];
+        return any == 0;
+    }
+
+    /* Word of a lane word; written through plain stores, element access of vector types compiles to shuffles. */
+    typedef uint64_t LaneBits __attribute__((may_alias));
+
+    inline void SetLane(LaneWord& word, int lane) noexcept
+    {
+        reinterpret_cast<LaneBits*>(&word)[lane >> 6] |= 1ull << (lane & 63);
+    }
+
+    /* Adds a group of lanes using @wiring, or finds the group already using it. */
+    inline void AddToGroup(Wirings& wirings, const uint8_t* wiring, const uint8_t* inverse, int lane) noexcept
+    {
+        uint64_t key[4];
+        std::memcpy(&key[0], wiring, 8);
+        std::memcpy(&key[1], wiring + 8, 8);
+        std::memcpy(&key[2], wiring + 16, 8);
+        std::memcpy(&key[3], wiring + alphabetLength - 8, 8);
+
+        // Neighbouring lanes usually share the wiring, so the group of the previous lane is checked first.
+        int g = wirings.Last;
+        if (g >= wirings.Count || wirings.Groups[g].Key[0] != key[0] || wirings.Groups[g].Key[1] != key[1] ||
+            wirings.Groups[g].Key[2] != key[2] || wirings.Groups[g].Key[3] != key[3])
+        {
+            g = 0;
+            while (g < wirings.Count && (wirings.Groups[g].Key[0] != key[0] || wirings.Groups[g].Key[1] != key[1] ||
+                                         wirings.Groups[g].Key[2] != key[2] || wirings.Groups[g].Key[3] != key[3]))
+                g++;
+        }
+        wirings.Last = g;
+        if (g == wirings.Count)
+        {
+            // Keys are compiled from RotorID / ReflectorID, so there are never more than maxWirings groups.
+            std::memcpy(wirings.Groups[g].Wiring, wiring, alphabetLength);
+            std::memcpy(wirings.Groups[g].Inverse, inverse, alphabetLength);
+            std::memcpy(wirings.Groups[g].Key, key, sizeof(key));
+            wirings.Groups[g].Mask = LaneWord{};
+            wirings.Count++;
+        }
+        SetLane(wirings.Groups[g].Mask, lane);
+    }
+
+    /* Returns mask of lanes where a == b. */
+    inline LaneWord Equal(const Number& a, const Number& b) noexcept
+    {
+        LaneWord eq = ~LaneWord{};
+        for (int i = 0; i < numberOfPlanes; i++)
+            eq &= ~(a[i] ^ b[i]);
+        return eq;
+    }
+
+    /* Adds 1 modulo 26 in lanes of @mask. */
+    inline void Increment(Number& number, LaneWord mask) noexcept
+    {
+        LaneWord carry = mask;
+        for (int i = 0; i < numberOfPlanes; i++)
+        {
+            LaneWord bit = number[i];
+            number[i] = bit ^ carry;
+            carry = bit & carry;
+        }
+        // 26 = 11010b wraps to 0.
+        LaneWord wrap = number[4] & number[3] & ~number[2] & number[1] & ~number[0];
+        for (int i = 0; i < numberOfPlanes; i++)
+            number[i] &= ~wrap;
+    }
+
+    /* Computes (a - b) modulo 26. */
+    inline void Subtract(const Number& a, const Number& b, Number& res) noexcept
+    {
+        LaneWord borrow = LaneWord{};
+        for (int i = 0; i < numberOfPlanes; i++)
+        {
+            res[i] = a[i] ^ b[i] ^ borrow;
+            borrow = (~a[i] & b[i]) | (~(a[i] ^ b[i]) & borrow);
+        }
+        // Negative results get 26 = 11010b added, modulo 32.
+        LaneWord carry = LaneWord{};
+        for (int i = 0; i < numberOfPlanes; i++)
+        {
+            LaneWord add = (26 >> i) & 1 ? borrow : LaneWord{};
+            LaneWord bit = res[i];
+            res[i] = bit ^ add ^ carry;
+            carry = (bit & add) | (carry & (bit ^ add));
+        }
+    }
+
+    /* Moves a letter by +number (or -number if @back) around the alphabet, per lane. */
+    inline void Rotate(Letter& letter, const Number& number, bool back) noexcept
+    {
+        for (int b = 0; b < numberOfPlanes; b++)
+        {
+            const LaneWord mask = number[b];
+            if (IsZero(mask))
+                continue;
+            const int shift = back ? alphabetLength - (1 << b) : (1 << b);
+            Letter moved;
+            for (int k = 0; k < alphabetLength; k++)
+            {
+                const int from = k - shift < 0 ? k - shift + alphabetLength : k - shift;
+                moved[k] = (letter[from] & mask) | (letter[k] & ~mask);
+            }
+            std::memcpy(letter, moved, sizeof(Letter));
+        }
+    }
+
+    /* Passes a letter through the wirings of its lanes. */
+    inline void Wire(const Letter& in, Letter& out, const Wirings& wirings, bool inverse) noexcept
+    {
+        if (wirings.Count == 1)
+        {
+            const uint8_t* wiring = inverse ? wirings.Groups[0].Inverse : wirings.Groups[0].Wiring;
+            for (int k = 0; k < alphabetLength; k++)
+                out[wiring[k]] = in[k];
+            return;
+        }
+        for (int k = 0; k < alphabetLength; k++)
+            out[k] = LaneWord{};
+        for (int g = 0; g < wirings.Count; g++)
+        {
+            const uint8_t* wiring = inverse ? wirings.Groups[g].Inverse : wirings.Groups[g].Wiring;
+            const LaneWord mask = wirings.Groups[g].Mask;
+            for (int k = 0; k < alphabetLength; k++)
+                out[wiring[k]] |= in[k] & mask;
+        }
+    }
+
+    /**
+     * Transposes keys into lanes. Works on 64 lanes at a time with plain words,
+     * so every bit is set in a register rather than scattered over the batch.
+     */
+    void Setup(Batch& batch, const CompiledKey* keys, const RotorPositions* positions, int count) noexcept
+    {
+        for (int i = 0; i < 3; i++)
+            batch.Rotors[i].Count = batch.Rotors[i].Last = 0;
+        batch.Reflector.Count = batch.Reflector.Last = 0;
+
+        for (int chunk = 0; chunk < wordsPerLane; chunk++)
+        {
+            const int first = chunk * 64;
+            const int last = count < first + 64 ? count : first + 64;
+            if (first >= last)
+            {
+                // Unused lanes only need empty masks.
+                for (int i = 0; i < 3; i++)
+                    for (int b = 0; b < numberOfPlanes; b++)
+                        reinterpret_cast<LaneBits*>(&batch.Offsets[i][b])[chunk] = reinterpret_cast<LaneBits*>(&batch.NotchOffsets[i][b])[chunk] = 0;
+                for (int a = 0; a < alphabetLength; a++)
+                    for (int b = 0; b < alphabetLength; b++)
+                        reinterpret_cast<LaneBits*>(&batch.Plugboard[a][b])[chunk] = 0;
+                reinterpret_cast<LaneBits*>(&batch.Valid)[chunk] = 0;
+                continue;
+            }
+
+            // Offsets and notch offsets of the chunk as bytes, transposed to bit-planes below.
+            uint8_t numbers[6][64] = {};
+            uint64_t plugboards[alphabetLength][alphabetLength] = {};
+            for (int lane = first; lane < last; lane++)
+            {
+                const int l = lane - first;
+                const CompiledKey& key = keys[lane];
+                for (int i = 0; i < 3; i++)
+                {
+                    const int ring = key.getRings()[i];
+                    int offset = positions[lane][i] - ring, notch = key.getNotches()[i] - ring;
+                    numbers[i][l] = (uint8_t)(offset < 0 ? offset + alphabetLength : offset);
+                    numbers[3 + i][l] = (uint8_t)(notch < 0 ? notch + alphabetLength : notch);
+                    AddToGroup(batch.Rotors[i], key.getForward(i), key.getBackward(i), lane);
+                }
+                AddToGroup(batch.Reflector, key.getReflector(), key.getReflector(), lane);
+
+                const uint64_t bit = 1ull << l;
+                const uint8_t* plugboard = key.getPlugboard();
+                for (int a = 0; a < alphabetLength; a++)
+                    plugboards[a][plugboard[a]] |= bit;
+            }
+
+            for (int n = 0; n < 6; n++)
+            {
+                Number& number = n < 3 ? batch.Offsets[n] : batch.NotchOffsets[n - 3];
+                uint64_t planes[numberOfPlanes] = {};
+                for (int w = 0; w < 8; w++)
+                {
+                    // Bit b of 8 bytes gathered into 8 bits by a multiply (little-endian bytes).
+                    uint64_t bytes;
+                    std::memcpy(&bytes, &numbers[n][8 * w], sizeof(bytes));
+                    for (int b = 0; b < numberOfPlanes; b++)
+                        planes[b] |= ((((bytes >> b) & 0x0101010101010101ull) * 0x0102040810204080ull) >> 56) << (8 * w);
+                }
+                for (int b = 0; b < numberOfPlanes; b++)
+                    reinterpret_cast<LaneBits*>(&number[b])[chunk] = planes[b];
+            }
+            for (int a = 0; a < alphabetLength; a++)
+                for (int b = 0; b < alphabetLength; b++)
+                    reinterpret_cast<LaneBits*>(&batch.Plugboard[a][b])[chunk] = plugboards[a][b];
+
+            const int used = last - first;
+            reinterpret_cast<LaneBits*>(&batch.Valid)[chunk] = used == 64 ? ~0ull : (1ull << used) - 1;
+        }
+    }
+}
+
+BitslicedEvaluator::BitslicedEvaluator(const std::string& Crib, const std::string& CipherText)
+    : Crib(CompiledKey::ToIndices(Crib)), CipherText(CompiledKey::ToIndices(CipherText))
+{
+    if (this->Crib.empty() || this->Crib.size() != this->CipherText.size())
+        throw std::runtime_error("Crib and ciphertext must have the same, non-zero length.");
+}
+
+int BitslicedEvaluator::getNumberOfLanes() noexcept
+{
+    return numberOfLanes;
+}
+
+void BitslicedEvaluator::Test(const CompiledKey* keys, const RotorPositions* positions, size_t count, uint64_t* mismatch) const noexcept
+{
+    if (count > (size_t)numberOfLanes)
+        count = numberOfLanes;
+    Batch batch;
+    Setup(batch, keys, positions, (int)count);
+
+    LaneWord alive = batch.Valid;
+    Number* offsets = batch.Offsets;
+    Letter a, b;
+    for (size_t i = 0; i < Crib.size() && !IsZero(alive); i++)
+    {
+        // Stepping, same as CompiledKey::Step: position equals notch iff offset equals notch - ring.
+        LaneWord middleAtNotch = Equal(offsets[1], batch.NotchOffsets[1]);
+        LaneWord rightAtNotch = Equal(offsets[2], batch.NotchOffsets[2]);
+        Increment(offsets[0], middleAtNotch);
+        Increment(offsets[1], middleAtNotch | rightAtNotch);
+        Increment(offsets[2], ~LaneWord{});
+
+        // Between two rotors the letter moves by the difference of their offsets, saving a rotate per rotor.
+        Number middleRight, leftMiddle;
+        Subtract(offsets[1], offsets[2], middleRight);
+        Subtract(offsets[0], offsets[1], leftMiddle);
+
+        std::memcpy(a, batch.Plugboard[Crib[i]], sizeof(Letter));
+        Rotate(a, offsets[2], false);
+        Wire(a, b, batch.Rotors[2], false);
+        Rotate(b, middleRight, false);
+        Wire(b, a, batch.Rotors[1], false);
+        Rotate(a, leftMiddle, false);
+        Wire(a, b, batch.Rotors[0], false);
+        Rotate(b, offsets[0], true);
+        Wire(b, a, batch.Reflector, false);
+        Rotate(a, offsets[0], false);
+        Wire(a, b, batch.Rotors[0], true);
+        Rotate(b, leftMiddle, true);
+        Wire(b, a, batch.Rotors[1], true);
+        Rotate(a, middleRight, true);
+        Wire(a, b, batch.Rotors[2], true);
+        Rotate(b, offsets[2], true);
+
+        // Plugboard is an involution: it maps b to the ciphertext letter c iff it maps c to b.
+        const Letter& expected = batch.Plugboard[CipherText[i]];
+        LaneWord match = LaneWord{};
+        for (int k = 0; k < alphabetLength; k++)
+            match |= b[k] & expected[k];
+        alive &= match;
+    }
+
+    for (int w = 0; w < wordsPerLane; w++)
+        mismatch[w] = ~alive[w];
+}
@@ -0,0 +1,76 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "CompiledKey.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Enigma
+{
+    /**
+     * Known-plaintext test of many keys at once.
+     *
+     * Every key occupies one bit lane of a lane word (128, 256 or 512 bits, chosen at compile time by
+     * __AVX512F__ / __AVX2__). A letter is held one-hot as 26 lane words, so fixed wirings are renaming of words,
+     * rotor offsets are conditional rotates by the 5 bit-planes of the offset, and plugboard, rotors and reflector
+     * of each lane are selected by lane masks. Stepping runs on bitsliced counters of rotor offsets.
+     * All lanes process the crib in lockstep, which stops as soon as every lane has a mismatch.
+     */
+    class BitslicedEvaluator
+    {
+    public:
+        /**
+         * Constructor.
+         *
+         * Params:
+         * const std::string& Crib - known plaintext.
+         * const std::string& CipherText - ciphertext of the crib, characters out of the alphabet are skipped in both.
+         *
+         * Exceptions:
+         * If the crib is empty or its length differs from the ciphertext, an exception will be thrown.
+         */
+        BitslicedEvaluator(const std::string& Crib, const std::string& CipherText) noexcept(false);
+
+        /**
+         * Returns number of keys tested by a single Test() call.
+         *
+         * Returns:
+         * int - number of bit lanes, 128, 256 or 512.
+         */
+        static int getNumberOfLanes() noexcept;
+
+        /**
+         * Tests keys at given start positions.
+         *
+         * Params:
+         * const CompiledKey* keys - keys, one per lane.
+         * const RotorPositions* positions - start position of every key.
+         * size_t count - number of keys, at most getNumberOfLanes(), the rest is ignored.
+         * uint64_t* mismatch - getNumberOfLanes() / 64 words; bit i is set if key i does not encrypt
+         *                      the crib to the ciphertext or i >= count.
+         */
+        void Test(const CompiledKey* keys, const RotorPositions* positions, size_t count, uint64_t* mismatch) const noexcept;
+
+        /**
+         * Returns number of letters of the crib.
+         *
+         * Returns:
+         * size_t - length.
+         */
+        size_t getLength() const noexcept { return Crib.size(); }
+
+    private:
+        /* Crib as alphabet indices. */
+        std::vector<uint8_t> Crib;
+
+        /* Ciphertext as alphabet indices. */
+        std::vector<uint8_t> CipherText;
+    };
+}
@@ -0,0 +1,272 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "Bombe.h"
+#include "IocSearch.h"
+#include "KeystreamTable.h"
+#include "RingClasses.h"
+
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace Enigma;
+
+namespace
+{
+    const int alphabetLength = CompiledKey::alphabetLength;
+
+    /* Orders stops: verified first, then by score, then by the key so the result does not depend on scheduling. */
+    bool StopBefore(const BombeStop& a, const BombeStop& b) noexcept
+    {
+        if (a.Verified != b.Verified)
+            return a.Verified;
+        if (a.Key.Score != b.Key.Score)
+            return a.Key.Score > b.Key.Score;
+        if (a.Key.Reflector != b.Key.Reflector)
+            return a.Key.Reflector < b.Key.Reflector;
+        if (a.Key.Rotors != b.Key.Rotors)
+            return a.Key.Rotors < b.Key.Rotors;
+        if (a.Key.Rings != b.Key.Rings)
+            return a.Key.Rings < b.Key.Rings;
+        if (a.Key.Positions != b.Key.Positions)
+            return a.Key.Positions < b.Key.Positions;
+        return a.Steckers < b.Steckers;
+    }
+
+    /* Finds the root of a letter in a union-find forest. */
+    int Root(int* parent, int letter) noexcept
+    {
+        while (parent[letter] != letter)
+            letter = parent[letter] = parent[parent[letter]];
+        return letter;
+    }
+
+    /**
+     * Checks a stop by decrypting the crib with CompiledKey, the way Encoder does it.
+     * Letters with undetermined steckers are unplugged, so only positions with both letters determined must agree.
+     */
+    void Verify(BombeStop& stop, const uint32_t* steckers, const BombeMenu& menu, int cribOffset) noexcept
+    {
+        const std::vector<uint8_t>& crib = menu.getCrib();
+        const std::vector<uint8_t>& cipherText = menu.getCipherText();
+        CompiledKey key(stop.Key.Reflector, stop.Key.Rotors, stop.Key.Rings, stop.Steckers.data());
+        RotorPositions positions = stop.Key.Positions;
+        for (int i = 0; i < cribOffset; i++)
+            key.Step(positions);
+
+        size_t matches = 0;
+        stop.Verified = true;
+        for (size_t i = 0; i < crib.size(); i++)
+        {
+            bool match = key.EncryptIndex(cipherText[i], positions) == crib[i];
+            matches += match;
+            if (!match && steckers[crib[i]] != 0 && steckers[cipherText[i]] != 0)
+                stop.Verified = false;
+        }
+        stop.Key.Score = (double)matches / crib.size();
+    }
+}
+
+BombeMenu::BombeMenu(const std::string& Crib, const std::string& CipherText)
+    : Crib(CompiledKey::ToIndices(Crib)), CipherText(CompiledKey::ToIndices(CipherText)), CentralLetter(0), Loops(0)
+{
+    if (this->Crib.empty() || this->Crib.size() != this->CipherText.size())
+        throw std::runtime_error("Crib and ciphertext must have the same, non-zero length.");
+    for (size_t i = 0; i < this->Crib.size(); i++)
+        if (this->Crib[i] == this->CipherText[i])
+            throw std::runtime_error("Crib is misplaced, a letter cannot be encrypted to itself.");
+
+    int parent[alphabetLength];
+    for (int i = 0; i < alphabetLength; i++)
+        parent[i] = i;
+    for (size_t i = 0; i < this->Crib.size(); i++)
+        parent[Root(parent, this->Crib[i])] = Root(parent, this->CipherText[i]);
+
+    // The part with most edges is used, ties go to the one with the lowest letter.
+    int edges[alphabetLength] = {0};
+    for (size_t i = 0; i < this->Crib.size(); i++)
+        edges[Root(parent, this->Crib[i])]++;
+    int best = 0;
+    for (int i = 0; i < alphabetLength; i++)
+        if (edges[Root(parent, i)] > edges[Root(parent, best)])
+            best = i;
+    best = Root(parent, best);
+
+    int degree[alphabetLength] = {0};
+    for (size_t i = 0; i < this->Crib.size(); i++)
+        if (Root(parent, this->Crib[i]) == best)
+        {
+            Edges.push_back(MenuEdge{(int)i, this->Crib[i], this->CipherText[i]});
+            degree[this->Crib[i]]++;
+            degree[this->CipherText[i]]++;
+        }
+
+    int letters = 0;
+    for (int i = 0; i < alphabetLength; i++)
+    {
+        letters += degree[i] > 0;
+        if (degree[i] > degree[CentralLetter])
+            CentralLetter = i;
+    }
+    Loops = (int)Edges.size() - letters + 1;
+}
+
+std::string BombeMenu::ToString() const noexcept
+{
+    std::string text;
+    for (const MenuEdge& edge : Edges)
+    {
+        if (!text.empty())
+            text += ' ';
+        text += std::string{(char)('A' + edge.Plain), '-', (char)('A' + edge.Cipher), '@'} + std::to_string(edge.Position);
+    }
+    return text;
+}
+
+BombeResult Bombe::Run(const BombeMenu& menu, const BombeOptions& options, ThreadPool& pool) noexcept
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    const std::vector<MenuEdge>& edges = menu.getEdges();
+    const int central = menu.getCentralLetter();
+    int lastPosition = 0;
+    for (const MenuEdge& edge : edges)
+        lastPosition = std::max(lastPosition, edge.Position);
+
+    // Edges of every letter as (other letter, edge index), both directions.
+    std::vector<std::vector<std::pair<uint8_t, uint16_t>>> adjacency(alphabetLength);
+    for (size_t e = 0; e < edges.size(); e++)
+    {
+        adjacency[edges[e].Plain].push_back(std::make_pair(edges[e].Cipher, (uint16_t)e));
+        adjacency[edges[e].Cipher].push_back(std::make_pair(edges[e].Plain, (uint16_t)e));
+    }
+
+    std::vector<std::array<RotorID, 3>> orders = IocSearch::WheelOrders();
+    const size_t tasks = options.Reflectors.size() * orders.size();
+    std::vector<std::vector<BombeStop>> stops(tasks);
+    // Stepping within the message (up to the end of the crib) decides which ring settings are equivalent.
+    RingClasses classes((size_t)options.CribOffset + lastPosition + 1);
+
+    pool.ParallelFor(tasks, [&](size_t t) {
+        ReflectorID reflector = options.Reflectors[t / orders.size()];
+        const std::array<RotorID, 3>& order = orders[t % orders.size()];
+
+        PlugboardWiring identity;
+        for (int i = 0; i < alphabetLength; i++)
+            identity[i] = (uint8_t)i;
+        std::array<int, 3> rings = options.SearchRings ? std::array<int, 3>{{0, 0, 0}} : options.Rings;
+        CompiledKey key(reflector, order, rings, identity.data());
+        KeystreamTable table{key};
+        std::vector<uint16_t> next = table.NextStates();
+
+        // Every fact (x, y) is pushed at most once per neighbour and once for symmetry.
+        std::vector<uint16_t> stack;
+        stack.reserve(alphabetLength * alphabetLength * (2 * edges.size() + 2));
+        std::vector<const uint8_t*> scramblers(edges.size());
+        std::vector<int> states(lastPosition + 1);
+
+        // Tests one start position; states are stepped through @next and mapped through @remap to the state of the permutation if given.
+        auto test = [&](const uint16_t* remap, const RotorPositions& positions, const std::array<int, 3>& keyRings) {
+            int state = KeystreamTable::StateIndex(positions);
+            for (int i = 0; i < options.CribOffset; i++)
+                state = next[state];
+            for (int i = 0; i <= lastPosition; i++)
+            {
+                state = next[state];
+                states[i] = remap ? remap[state] : state;
+            }
+            for (size_t e = 0; e < edges.size(); e++)
+                scramblers[e] = table.getPermutation(states[edges[e].Position]);
+
+            // Row x holds the letters x may be steckered to; lit holds every fact of classes already tested.
+            uint32_t lit[alphabetLength] = {0};
+            for (int hypothesis = 0; hypothesis < alphabetLength; hypothesis++)
+            {
+                if (lit[central] & (1u << hypothesis))
+                    continue;
+
+                uint32_t steckers[alphabetLength] = {0};
+                bool contradiction = false;
+                stack.clear();
+                stack.push_back((uint16_t)(central * alphabetLength + hypothesis));
+                while (!stack.empty() && !contradiction)
+                {
+                    const int x = stack.back() / alphabetLength, y = stack.back() % alphabetLength;
+                    stack.pop_back();
+                    if (steckers[x] & (1u << y))
+                        continue;
+                    steckers[x] |= 1u << y;
+                    contradiction |= (steckers[x] & (steckers[x] - 1)) != 0;
+                    stack.push_back((uint16_t)(y * alphabetLength + x));
+                    for (const std::pair<uint8_t, uint16_t>& edge : adjacency[x])
+                        stack.push_back((uint16_t)(edge.first * alphabetLength + scramblers[edge.second][y]));
+                }
+                // Every fact lit so far is equivalent to the hypothesis, so a contradiction refutes all of them
+                // and propagation can stop early; other hypotheses about the central letter lit here are skipped.
+                for (int i = 0; i < alphabetLength; i++)
+                    lit[i] |= steckers[i];
+                if (contradiction)
+                    continue;
+
+                BombeStop stop;
+                int cables = 0;
+                for (int i = 0; i < alphabetLength; i++)
+                {
+                    stop.Steckers[i] = (uint8_t)(steckers[i] ? __builtin_ctz(steckers[i]) : i);
+                    cables += stop.Steckers[i] > i;
+                }
+                if (cables > alphabetLength / 2)
+                    continue;
+                stop.Key.Reflector = reflector;
+                stop.Key.Rotors = order;
+                stop.Key.Rings = keyRings;
+                stop.Key.Positions = positions;
+                Verify(stop, steckers, menu, options.CribOffset);
+                stops[t].push_back(stop);
+            }
+        };
+
+        if (!options.SearchRings)
+        {
+            for (int start = 0; start < KeystreamTable::numberOfStates; start++)
+                test(nullptr, {{start / (alphabetLength * alphabetLength), start / alphabetLength % alphabetLength, start % alphabetLength}}, rings);
+        }
+        else
+        {
+            // As in IocSearch: the table is built with rings AAA, so its states are core offsets and its stepping is that of the windows.
+            // Left ring is always A, every middle and right ring is paired with the representative windows of every turnover class.
+            const int* notches = key.getNotches();
+            std::vector<uint16_t> remap(KeystreamTable::numberOfStates);
+            for (int ringMiddle = 0; ringMiddle < alphabetLength; ringMiddle++)
+                for (int ringRight = 0; ringRight < alphabetLength; ringRight++)
+                {
+                    for (int state = 0; state < KeystreamTable::numberOfStates; state++)
+                        remap[state] = (uint16_t)KeystreamTable::StateIndex({{state / 676, (state / 26 % 26 + 26 - ringMiddle) % 26, (state % 26 + 26 - ringRight) % 26}});
+                    std::array<int, 3> keyRings = {{0, ringMiddle, ringRight}};
+                    for (const std::array<int, 2>& rep : classes.getRepresentatives())
+                    {
+                        int middle = (notches[1] - rep[1] + 26) % 26, right = (notches[2] - rep[0] + 26) % 26;
+                        for (int left = 0; left < alphabetLength; left++)
+                            test(remap.data(), {{left, middle, right}}, keyRings);
+                    }
+                }
+        }
+    });
+
+    BombeResult res;
+    res.NumberOfStops = 0;
+    for (std::vector<BombeStop>& task : stops)
+    {
+        res.NumberOfStops += task.size();
+        res.Stops.insert(res.Stops.end(), task.begin(), task.end());
+    }
+    std::sort(res.Stops.begin(), res.Stops.end(), StopBefore);
+    if (res.Stops.size() > options.MaxStops)
+        res.Stops.resize(options.MaxStops);
+    res.PositionsTested = (uint64_t)tasks * KeystreamTable::numberOfStates * (options.SearchRings ? classes.size() : 1);
+    res.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return res;
+}
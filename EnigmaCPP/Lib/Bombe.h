@@ -0,0 +1,185 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "CandidateHeap.h"
+#include "PlugboardSolver.h"
+#include "ThreadPool.h"
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Enigma
+{
+    /* Connection of the menu: at @Position of the crib, @Plain and @Cipher encrypt to each other. */
+    struct MenuEdge
+    {
+        int Position;
+        uint8_t Plain;
+        uint8_t Cipher;
+    };
+
+    /**
+     * Letter-pair menu of a crib.
+     *
+     * Letters are vertices, every crib position is an edge between its plain and cipher letter.
+     * The bombe runs on the connected part with most edges; its loops (closures) are what makes wrong
+     * positions contradict themselves, so menus with more loops give fewer stops.
+     */
+    class BombeMenu
+    {
+    public:
+        /**
+         * Constructor, builds the menu.
+         *
+         * Params:
+         * const std::string& Crib - known plaintext.
+         * const std::string& CipherText - ciphertext of the crib, characters out of the alphabet are skipped in both.
+         *
+         * Exceptions:
+         * If lengths differ, the crib is empty or a letter would encrypt to itself, an exception will be thrown.
+         */
+        BombeMenu(const std::string& Crib, const std::string& CipherText) noexcept(false);
+
+        /**
+         * Returns edges of the connected part used by the bombe.
+         *
+         * Returns:
+         * const std::vector<MenuEdge>& - edges.
+         */
+        const std::vector<MenuEdge>& getEdges() const noexcept { return Edges; }
+
+        /**
+         * Returns the letter with most connections, hypotheses about its partner are tested.
+         *
+         * Returns:
+         * int - letter as an index in the alphabet.
+         */
+        int getCentralLetter() const noexcept { return CentralLetter; }
+
+        /**
+         * Returns number of independent loops of the used part (edges - letters + 1).
+         *
+         * Returns:
+         * int - number of loops.
+         */
+        int getLoops() const noexcept { return Loops; }
+
+        /**
+         * Returns the crib as alphabet indices.
+         *
+         * Returns:
+         * const std::vector<uint8_t>& - crib.
+         */
+        const std::vector<uint8_t>& getCrib() const noexcept { return Crib; }
+
+        /**
+         * Returns the ciphertext of the crib as alphabet indices.
+         *
+         * Returns:
+         * const std::vector<uint8_t>& - ciphertext.
+         */
+        const std::vector<uint8_t>& getCipherText() const noexcept { return CipherText; }
+
+        /**
+         * Returns the menu in readable form, e.g. "A-B@0 B-Q@3 ...".
+         *
+         * Returns:
+         * std::string - menu.
+         */
+        std::string ToString() const noexcept;
+
+    private:
+        std::vector<uint8_t> Crib;
+        std::vector<uint8_t> CipherText;
+        std::vector<MenuEdge> Edges;
+        int CentralLetter;
+        int Loops;
+    };
+
+    /* Options of Bombe. */
+    struct BombeOptions
+    {
+        /* Reflectors to be searched. */
+        std::vector<ReflectorID> Reflectors = {B, C};
+
+        /**
+         * Ring settings used for every wheel order (0 - 25). They decide where the middle (and left) rotor steps,
+         * so with wrong middle or right ring a key is missed once the crib spans a turnover, as every crib of 26 letters does.
+         */
+        std::array<int, 3> Rings = {{0, 0, 0}};
+
+        /**
+         * Searches ring settings too, @Rings is then ignored. For every start core offset one key per RingClasses class
+         * of the message up to the end of the crib is tested, so stops are found whatever the turnover points are.
+         */
+        bool SearchRings = false;
+
+        /* Position of the crib in the message; rotors positions of stops are given at the message start. */
+        int CribOffset = 0;
+
+        /* Max number of returned stops. */
+        size_t MaxStops = 100;
+    };
+
+    /* Position at which a hypothesis about the central letter survived propagation. */
+    struct BombeStop
+    {
+        /* Reflector, wheel order, rings and message start position; Score is the fraction of crib letters decrypted correctly. */
+        KeyCandidate Key;
+
+        /* Steckers implied by the surviving hypothesis, undetermined letters are unplugged. */
+        PlugboardWiring Steckers;
+
+        /* True if decryption with CompiledKey agrees with every crib letter whose steckers are determined. */
+        bool Verified;
+    };
+
+    /* Result of Bombe. */
+    struct BombeResult
+    {
+        /* Stops, verified first, then by score. */
+        std::vector<BombeStop> Stops;
+
+        /* Tested positions (reflector x wheel order x start position, x ring class with SearchRings). */
+        uint64_t PositionsTested;
+
+        /* Number of stops before truncation to MaxStops. */
+        uint64_t NumberOfStops;
+
+        /* Wall time of the search in seconds. */
+        double Seconds;
+    };
+
+    /**
+     * Turing-Welchman bombe.
+     *
+     * For every wheel order and start position, the scrambler permutation (rotors and reflector, no plugboard)
+     * of each menu position is taken from a KeystreamTable. A hypothesis "central letter is steckered to L"
+     * implies, through every edge X-Z at position i, that Z is steckered to S_i(partner of X), and by the
+     * diagonal board that steckering is symmetric. Implications are propagated on 26 bitset rows; a letter
+     * with two partners contradicts the hypothesis and everything it implied, which typically lights all
+     * 26 hypotheses at once. Positions where a hypothesis survives are stops, checked by full decryption.
+     */
+    class Bombe
+    {
+    public:
+        /**
+         * Runs the search over all wheel orders and start positions.
+         *
+         * Params:
+         * const BombeMenu& menu - menu of the crib.
+         * const BombeOptions& options - options.
+         * ThreadPool& pool - threads used for the search.
+         *
+         * Returns:
+         * BombeResult - stops and statistics.
+         */
+        static BombeResult Run(const BombeMenu& menu, const BombeOptions& options, ThreadPool& pool) noexcept;
+    };
+}
@@ -0,0 +1,75 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "CandidateHeap.h"
+
+#include <limits>
+#include <algorithm>
+
+using namespace Enigma;
+
+namespace
+{
+    /**
+     * Orders candidates so that the worst one is on the top of std heap functions.
+     * Equal scores are ordered by the key itself, so the result does not depend on the order of pushes.
+     */
+    bool Better(const KeyCandidate& a, const KeyCandidate& b) noexcept
+    {
+        if (a.Score != b.Score)
+            return a.Score > b.Score;
+        if (a.Reflector != b.Reflector)
+            return a.Reflector < b.Reflector;
+        if (a.Rotors != b.Rotors)
+            return a.Rotors < b.Rotors;
+        if (a.Rings != b.Rings)
+            return a.Rings < b.Rings;
+        return a.Positions < b.Positions;
+    }
+}
+
+UserSettings KeyCandidate::ToUserSettings() const noexcept
+{
+    std::vector<UserRotor> rotors;
+    for (int i = 0; i < 3; i++)
+        rotors.push_back(UserRotor(Rotors[i], (char)('A' + Positions[i]), (char)('A' + Rings[i])));
+    return UserSettings(Reflector, rotors, std::vector<std::string>());
+}
+
+bool CandidateHeap::Push(const KeyCandidate& candidate) noexcept
+{
+    if (Heap.size() < Capacity)
+    {
+        Heap.push_back(candidate);
+        std::push_heap(Heap.begin(), Heap.end(), Better);
+        return true;
+    }
+    if (!Better(candidate, Heap.front()))
+        return false;
+    std::pop_heap(Heap.begin(), Heap.end(), Better);
+    Heap.back() = candidate;
+    std::push_heap(Heap.begin(), Heap.end(), Better);
+    return true;
+}
+
+void CandidateHeap::Merge(const CandidateHeap& other) noexcept
+{
+    for (const KeyCandidate& candidate : other.Heap)
+        Push(candidate);
+}
+
+double CandidateHeap::getThreshold() const noexcept
+{
+    if (Heap.size() < Capacity)
+        return std::numeric_limits<double>::lowest();
+    return Heap.front().Score;
+}
+
+std::vector<KeyCandidate> CandidateHeap::Sorted() const noexcept
+{
+    std::vector<KeyCandidate> res = Heap;
+    std::sort(res.begin(), res.end(), Better);
+    return res;
+}
@@ -0,0 +1,109 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "CompiledKey.h"
+
+#include <array>
+#include <vector>
+#include <cstddef>
+
+namespace Enigma
+{
+    /* Key found by a search engine, plugboard is empty. */
+    struct KeyCandidate
+    {
+        /* Score given by the engine, higher is better. */
+        double Score;
+
+        /* ID of the reflector. */
+        ReflectorID Reflector;
+
+        /* Rotors from left to right. */
+        std::array<RotorID, 3> Rotors;
+
+        /* Ring settings from left to right (0 - 25). */
+        std::array<int, 3> Rings;
+
+        /* Start position from left to right (0 - 25). */
+        RotorPositions Positions;
+
+        /**
+         * Converts the candidate to settings.
+         *
+         * Returns:
+         * UserSettings - settings with empty plugboard.
+         */
+        UserSettings ToUserSettings() const noexcept;
+    };
+
+    /**
+     * Keeps K candidates with the highest score.
+     *
+     * Not thread-safe, engines keep one heap per thread and merge them at the end.
+     */
+    class CandidateHeap
+    {
+    public:
+        /**
+         * Constructor.
+         *
+         * Params:
+         * size_t Capacity - max number of kept candidates (K), at least 1.
+         */
+        explicit CandidateHeap(size_t Capacity) noexcept : Capacity(Capacity ? Capacity : 1) {}
+
+        /**
+         * Offers a candidate.
+         *
+         * Params:
+         * const KeyCandidate& candidate - candidate.
+         *
+         * Returns:
+         * bool - true if the candidate was kept.
+         */
+        bool Push(const KeyCandidate& candidate) noexcept;
+
+        /**
+         * Offers all candidates of other heap.
+         *
+         * Params:
+         * const CandidateHeap& other - heap to be merged.
+         */
+        void Merge(const CandidateHeap& other) noexcept;
+
+        /**
+         * Returns the lowest score a candidate must beat to be kept.
+         *
+         * Returns:
+         * double - lowest kept score, or the lowest double while the heap is not full.
+         */
+        double getThreshold() const noexcept;
+
+        /**
+         * Returns true if the heap holds K candidates.
+         *
+         * Returns:
+         * bool - true if full.
+         */
+        bool isFull() const noexcept { return Heap.size() == Capacity; }
+
+        /**
+         * Returns kept candidates from the best one.
+         *
+         * Returns:
+         * std::vector<KeyCandidate> - sorted candidates.
+         */
+        std::vector<KeyCandidate> Sorted() const noexcept;
+
+    private:
+        /* Max number of kept candidates. */
+        size_t Capacity;
+
+        /* Min-heap by score. */
+        std::vector<KeyCandidate> Heap;
+    };
+}
@@ -0,0 +1,152 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "CompiledKey.h"
+#include "SettingsConversion.h"
+
+#include <cctype>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace Enigma;
+
+const uint8_t CompiledKey::ModTable[3 * alphabetLength] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25};
+
+CompiledKey::CompiledKey(const UserSettings& USettings)
+{
+    // Validation and wiring tables are taken from SettingsConversion, so both paths always agree.
+    EnigmaSettings converted = SettingsConversion::ConvertToEnigmaSettings(USettings);
+
+    std::vector<EnigmaRotor> rotors = converted.getRotors();
+    for (int i = 0; i < 3; i++)
+    {
+        std::string alphabet = rotors[i].getAlphabet();
+        for (int j = 0; j < alphabetLength; j++)
+        {
+            Forward[i][j] = (uint8_t)(alphabet[j] - 'A');
+            Backward[i][alphabet[j] - 'A'] = (uint8_t)j;
+        }
+        Notches[i] = rotors[i].getNotch();
+        Rings[i] = rotors[i].getRingS();
+    }
+
+    std::string reflector = converted.getRefAlp();
+    for (int j = 0; j < alphabetLength; j++)
+        Reflector[j] = (uint8_t)(reflector[j] - 'A');
+
+    std::unordered_map<char, char> connections = converted.getConnections();
+    for (int j = 0; j < alphabetLength; j++)
+        Plugboard[j] = (uint8_t)(connections['A' + j] - 'A');
+}
+
+CompiledKey::CompiledKey(ReflectorID ReflectorName, const std::array<RotorID, 3>& Rotors, const std::array<int, 3>& RingSettings, const uint8_t* PlugboardWiring) noexcept
+{
+    for (int i = 0; i < 3; i++)
+    {
+        const std::pair<std::string, int>& info = SettingsConversion::RotorInfo.find(Rotors[i])->second;
+        for (int j = 0; j < alphabetLength; j++)
+        {
+            Forward[i][j] = (uint8_t)(info.first[j] - 'A');
+            Backward[i][info.first[j] - 'A'] = (uint8_t)j;
+        }
+        Notches[i] = info.second;
+        Rings[i] = RingSettings[i];
+    }
+
+    const std::string& reflector = SettingsConversion::ReflectorInfo.find(ReflectorName)->second;
+    for (int j = 0; j < alphabetLength; j++)
+    {
+        Reflector[j] = (uint8_t)(reflector[j] - 'A');
+        Plugboard[j] = PlugboardWiring[j];
+    }
+}
+
+RotorPositions CompiledKey::PositionsOf(const UserSettings& USettings)
+{
+    const std::vector<UserRotor>& rotors = USettings.getRotors();
+    if (rotors.size() != 3)
+        throw std::runtime_error("The number of rotors is not equal 3");
+    RotorPositions positions;
+    for (int i = 0; i < 3; i++)
+    {
+        char pos = rotors[i].getPosition();
+        if (pos < 'A' || pos > 'Z')
+            throw std::runtime_error("Invalid rotor position.");
+        positions[i] = pos - 'A';
+    }
+    return positions;
+}
+
+std::string CompiledKey::CanonicalForm(const UserSettings& USettings)
+{
+    const std::vector<UserRotor>& rotors = USettings.getRotors();
+    const std::vector<std::string>& connections = USettings.getPlugboardConnections();
+    if (connections.size() > alphabetLength / 2)
+        throw std::runtime_error("Invalid connection.");
+
+    // Connections as pairs of letters in one number, sorted without copying the strings.
+    uint16_t pairs[alphabetLength / 2];
+    size_t count = 0;
+    for (const std::string& con : connections)
+    {
+        // Otherwise a malformed connection, e.g. "AB CD", could share the form of valid ones.
+        if (con.size() != 2 || con[0] == con[1] || con[0] < 'A' || con[0] > 'Z' || con[1] < 'A' || con[1] > 'Z')
+            throw std::runtime_error("Invalid connection.");
+        pairs[count++] = (uint16_t)(std::min(con[0], con[1]) << 8 | std::max(con[0], con[1]));
+    }
+    std::sort(pairs, pairs + count);
+
+    std::string form;
+    form.reserve(2 + 2 * rotors.size() + 3 * count);
+    form += (char)('0' + USettings.getReflectorID());
+    for (const UserRotor& rotor : rotors)
+    {
+        form += (char)('0' + rotor.getID());
+        form += rotor.getRing();
+    }
+    form += '|';
+    for (size_t i = 0; i < count; i++)
+    {
+        form += (char)(pairs[i] >> 8);
+        form += (char)(pairs[i] & 0xFF);
+        form += ' ';
+    }
+    return form;
+}
+
+void CompiledKey::EncryptIndices(const uint8_t* in, uint8_t* out, size_t length, RotorPositions& positions) const noexcept
+{
+    for (size_t i = 0; i < length; i++)
+        out[i] = (uint8_t)EncryptIndex(in[i], positions);
+}
+
+std::string CompiledKey::EncryptString(const std::string& originalText, RotorPositions& positions) const noexcept
+{
+    std::string encryptedText;
+    encryptedText.reserve(originalText.size());
+    for (char c : originalText)
+    {
+        char letter = std::toupper(c);
+        if (letter >= 'A' && letter <= 'Z')
+            encryptedText += (char)('A' + EncryptIndex(letter - 'A', positions));
+    }
+    return encryptedText;
+}
+
+std::vector<uint8_t> CompiledKey::ToIndices(const std::string& text) noexcept
+{
+    std::vector<uint8_t> indices;
+    indices.reserve(text.size());
+    for (char c : text)
+    {
+        char letter = std::toupper(c);
+        if (letter >= 'A' && letter <= 'Z')
+            indices.push_back((uint8_t)(letter - 'A'));
+    }
+    return indices;
+}
@@ -0,0 +1,160 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "CribDrag.h"
+#include "CompiledKey.h"
+
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace Enigma;
+
+namespace
+{
+#if defined(__AVX512BW__)
+    typedef int8_t Bytes __attribute__((vector_size(64)));
+#elif defined(__AVX2__)
+    typedef int8_t Bytes __attribute__((vector_size(32)));
+#else
+    typedef int8_t Bytes __attribute__((vector_size(16)));
+#endif
+
+    const int width = sizeof(Bytes);
+    const uint64_t allOffsets = width == 64 ? ~(uint64_t)0 : ((uint64_t)1 << width) - 1;
+
+    /* Crib letters compared before checking if every offset of a vector already has a conflict. */
+    const size_t abortInterval = 8;
+
+    /* Bit i is set if byte i of @v is set (0xFF). */
+    inline uint64_t Mask(const Bytes& v) noexcept
+    {
+#if defined(__AVX512BW__)
+        return _mm512_movepi8_mask((__m512i)v);
+#elif defined(__AVX2__)
+        return (uint32_t)_mm256_movemask_epi8((__m256i)v);
+#elif defined(__SSE2__)
+        return (uint16_t)_mm_movemask_epi8((__m128i)v);
+#else
+        uint64_t mask = 0;
+        for (int i = 0; i < width; i++)
+            mask |= (uint64_t)(v[i] != 0) << i;
+        return mask;
+#endif
+    }
+
+    inline Bytes Load(const uint8_t* p) noexcept
+    {
+        Bytes v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    /* True if no crib letter equals the ciphertext letter below it. */
+    inline bool Fits(const uint8_t* text, const uint8_t* crib, size_t cribLength) noexcept
+    {
+        for (size_t j = 0; j < cribLength; j++)
+            if (text[j] == crib[j])
+                return false;
+        return true;
+    }
+}
+
+int CribDrag::getVectorWidth() noexcept
+{
+    return width;
+}
+
+std::vector<size_t> CribDragResult::getOffsets(size_t crib, size_t limit) const noexcept
+{
+    std::vector<size_t> offsets;
+    const std::vector<uint64_t>& bitmap = Possible[crib];
+    for (size_t w = 0; w < bitmap.size() && offsets.size() < limit; w++)
+        for (uint64_t bits = bitmap[w]; bits && offsets.size() < limit; bits &= bits - 1)
+            offsets.push_back(w * 64 + __builtin_ctzll(bits));
+    return offsets;
+}
+
+uint64_t CribDrag::Drag(const uint8_t* text, size_t length, const uint8_t* crib, size_t cribLength,
+                        size_t first, size_t last, uint64_t* possible) noexcept
+{
+    const size_t end = cribLength && cribLength <= length ? std::min(last, length - cribLength + 1) : first;
+    uint64_t count = 0;
+
+    size_t offset = first;
+    for (; offset + 64 <= end; offset += 64)
+    {
+        uint64_t word = 0;
+        for (int chunk = 0; chunk < 64; chunk += width)
+        {
+            // Byte i of @conflicts is set if offset + chunk + i is impossible.
+            Bytes conflicts = {};
+            const uint8_t* window = text + offset + chunk;
+            for (size_t j = 0; j < cribLength; j++)
+            {
+                conflicts |= Load(window + j) == (Bytes{} + (int8_t)crib[j]);
+                if ((j + 1) % abortInterval == 0 && Mask(conflicts) == allOffsets)
+                    break;
+            }
+            word |= (~Mask(conflicts) & allOffsets) << chunk;
+        }
+        possible[offset / 64] = word;
+        count += __builtin_popcountll(word);
+    }
+    for (; offset < last; offset += 64)
+    {
+        uint64_t word = 0;
+        for (size_t i = offset; i < std::min(offset + 64, end); i++)
+            word |= (uint64_t)Fits(text + i, crib, cribLength) << (i - offset);
+        possible[offset / 64] = word;
+        count += __builtin_popcountll(word);
+    }
+    return count;
+}
+
+CribDragResult CribDrag::Run(const std::string& cipherText, const std::vector<std::string>& cribs, ThreadPool& pool)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    std::vector<uint8_t> text = CompiledKey::ToIndices(cipherText);
+    std::vector<std::vector<uint8_t>> cribIndices;
+    for (const std::string& crib : cribs)
+    {
+        cribIndices.push_back(CompiledKey::ToIndices(crib));
+        if (cribIndices.back().empty())
+            throw std::runtime_error("Crib has no letters.");
+    }
+
+    CribDragResult res;
+    res.Possible.assign(cribs.size(), std::vector<uint64_t>((text.size() + 63) / 64));
+    res.Counts.assign(cribs.size(), 0);
+    res.OffsetsTested = 0;
+    res.Length = text.size();
+
+    // Every block is dragged by all cribs while it is in cache, blocks write disjoint words of the bitmaps.
+    const size_t blocks = (text.size() + blockLength - 1) / blockLength;
+    std::vector<uint64_t> counts(blocks * cribs.size());
+    pool.ParallelFor(blocks, [&](size_t b) {
+        size_t first = b * blockLength, last = std::min(first + blockLength, text.size());
+        for (size_t c = 0; c < cribIndices.size(); c++)
+            counts[b * cribs.size() + c] = Drag(text.data(), text.size(), cribIndices[c].data(), cribIndices[c].size(),
+                                                first, last, res.Possible[c].data());
+    });
+
+    for (size_t c = 0; c < cribIndices.size(); c++)
+    {
+        for (size_t b = 0; b < blocks; b++)
+            res.Counts[c] += counts[b * cribs.size() + c];
+        if (cribIndices[c].size() <= text.size())
+            res.OffsetsTested += text.size() - cribIndices[c].size() + 1;
+    }
+    res.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return res;
+}
@@ -0,0 +1,108 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Enigma
+{
+    /* Result of CribDrag::Run. */
+    struct CribDragResult
+    {
+        /* For every crib, bitmap of possible offsets (in letters of the ciphertext): bit o % 64 of word o / 64. */
+        std::vector<std::vector<uint64_t>> Possible;
+
+        /* For every crib, number of possible offsets. */
+        std::vector<uint64_t> Counts;
+
+        /* Number of tested (crib, offset) pairs. */
+        uint64_t OffsetsTested;
+
+        /* Number of letters of the ciphertext. */
+        size_t Length;
+
+        /* Wall time of the search in seconds. */
+        double Seconds;
+
+        /**
+         * Lists possible offsets of a crib.
+         *
+         * Params:
+         * size_t crib - index of the crib.
+         * size_t limit - max number of listed offsets.
+         *
+         * Returns:
+         * std::vector<size_t> - ascending offsets.
+         */
+        std::vector<size_t> getOffsets(size_t crib, size_t limit = SIZE_MAX) const noexcept;
+    };
+
+    /**
+     * Crib dragging: finds offsets of the ciphertext a crib can be placed at.
+     *
+     * The reflector is an involution without fixed points, so Enigma never encrypts a letter to itself
+     * and an offset where any crib letter equals the ciphertext letter below it is impossible.
+     * A vector of offsets is tested at once: crib letter j is broadcast and compared with the ciphertext
+     * loaded at offset + j, the conflicts are OR-ed and their byte mask is stored to a bitmap of offsets.
+     * Output is one bit per offset, so the drag is not slowed down by the many survivors of short cribs.
+     * The ciphertext is split into blocks which are dragged by all cribs while in cache,
+     * blocks are spread across the threads of the pool.
+     */
+    class CribDrag
+    {
+    public:
+        /* Number of offsets of a block (a task of the pool). */
+        static const size_t blockLength = 1 << 16;
+
+        /**
+         * Drags every crib over the ciphertext.
+         *
+         * Params:
+         * const std::string& cipherText - ciphertext, characters out of the alphabet are ignored.
+         * const std::vector<std::string>& cribs - cribs, characters out of the alphabet are ignored.
+         * ThreadPool& pool - threads used for the search.
+         *
+         * Exceptions:
+         * If a crib has no letters, an exception will be thrown.
+         *
+         * Returns:
+         * CribDragResult - offsets of every crib and statistics.
+         */
+        static CribDragResult Run(const std::string& cipherText, const std::vector<std::string>& cribs, ThreadPool& pool) noexcept(false);
+
+        /**
+         * Drags a crib over offsets [first, last) of a ciphertext, single thread.
+         *
+         * Params:
+         * const uint8_t* text - ciphertext as alphabet indices.
+         * size_t length - number of letters of the ciphertext.
+         * const uint8_t* crib - crib as alphabet indices.
+         * size_t cribLength - number of letters of the crib, at least 1.
+         * size_t first - first tested offset, multiple of 64.
+         * size_t last - end of tested offsets.
+         * uint64_t* possible - bitmap of offsets, words covering [first, last) are overwritten.
+         *   Offsets past length - cribLength are cleared.
+         *
+         * Returns:
+         * uint64_t - number of possible offsets in [first, last).
+         */
+        static uint64_t Drag(const uint8_t* text, size_t length, const uint8_t* crib, size_t cribLength,
+                             size_t first, size_t last, uint64_t* possible) noexcept;
+
+        /**
+         * Returns number of offsets tested by a single vector compare.
+         *
+         * Returns:
+         * int - 16, 32 with AVX2, 64 with AVX-512BW.
+         */
+        static int getVectorWidth() noexcept;
+    };
+}
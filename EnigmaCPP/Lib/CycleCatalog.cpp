@@ -0,0 +1,321 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "CycleCatalog.h"
+#include "IocSearch.h"
+#include "KeystreamTable.h"
+#include "SettingsConversion.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <unistd.h>
+
+using namespace Enigma;
+
+namespace
+{
+    const int alphabetLength = CompiledKey::alphabetLength;
+
+    /* Half of the alphabet, cycles of a product come in pairs. */
+    const int halfLength = alphabetLength / 2;
+
+    /* Magic of the file format. */
+    const char catalogMagic[4] = {'E', 'N', 'G', 'C'};
+
+    /* Offset of the entries in the file, keeps them page-aligned. */
+    const uint64_t entriesOffset = 4096;
+
+    /* Header of the file. */
+    struct FileHeader
+    {
+        char Magic[4];
+        uint32_t FormatVersion;
+        uint32_t WiringVersion;
+        int32_t Rings[3];
+        uint64_t EntriesOffset;
+        uint64_t NumberOfEntries;
+        uint64_t NumberOfSignatures;
+    };
+
+    static_assert(sizeof(FileHeader) <= entriesOffset, "Header must fit before the entries.");
+    static_assert(sizeof(CycleCatalogEntry) == 8, "Entries are stored as they are in memory.");
+
+    /**
+     * Partition of 13 as a key: 4 bits per part length (1 - 13) holding the number of parts of that length.
+     * Partitions are numbered by the position of their key in the sorted table.
+     */
+    typedef uint64_t PartitionKey;
+
+    void Partitions(int left, int maxPart, PartitionKey key, std::vector<PartitionKey>& keys) noexcept
+    {
+        if (left == 0)
+        {
+            keys.push_back(key);
+            return;
+        }
+        for (int part = std::min(left, maxPart); part >= 1; part--)
+            Partitions(left - part, part, key + ((PartitionKey)1 << (4 * (part - 1))), keys);
+    }
+
+    const std::vector<PartitionKey>& PartitionTable() noexcept
+    {
+        static const std::vector<PartitionKey> table = [] {
+            std::vector<PartitionKey> keys;
+            Partitions(halfLength, halfLength, 0, keys);
+            std::sort(keys.begin(), keys.end());
+            return keys;
+        }();
+        return table;
+    }
+
+    /* Index of the cycle structure of a product, -1 if its cycles are not in pairs. */
+    int PartitionOf(const uint8_t* product) noexcept
+    {
+        int counts[alphabetLength + 1] = {0};
+        uint32_t visited = 0;
+        for (int start = 0; start < alphabetLength; start++)
+        {
+            if (visited >> start & 1)
+                continue;
+            int length = 0;
+            for (int letter = start; !(visited >> letter & 1); letter = product[letter])
+            {
+                visited |= 1u << letter;
+                length++;
+            }
+            counts[length]++;
+        }
+
+        PartitionKey key = 0;
+        for (int length = 1; length <= alphabetLength; length++)
+        {
+            if (counts[length] % 2 != 0)
+                return -1;
+            if (counts[length])
+                key += (PartitionKey)(counts[length] / 2) << (4 * (length - 1));
+        }
+        const std::vector<PartitionKey>& table = PartitionTable();
+        auto it = std::lower_bound(table.begin(), table.end(), key);
+        return it != table.end() && *it == key ? (int)(it - table.begin()) : -1;
+    }
+
+    /* Sort key of an entry: characteristic, then reflector, wheel order and Grundstellung. */
+    inline uint64_t SortKey(const CycleCatalogEntry& entry) noexcept
+    {
+        return (uint64_t)entry.Signature << 32 | (uint64_t)entry.Reflector << 24 | (uint64_t)entry.WheelOrder << 16 | entry.State;
+    }
+}
+
+uint32_t CycleCatalog::SignatureOf(const uint8_t* const* permutations) noexcept
+{
+    uint32_t signature = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        uint8_t product[alphabetLength];
+        for (int letter = 0; letter < alphabetLength; letter++)
+            product[letter] = permutations[i + 3][permutations[i][letter]];
+        int partition = PartitionOf(product);
+        if (partition < 0)
+            return UINT32_MAX;
+        signature = signature * numberOfPartitions + partition;
+    }
+    return signature;
+}
+
+uint32_t CycleCatalog::SignatureOf(const std::vector<std::string>& indicators)
+{
+    // Letter i of an indicator is mapped to letter i + 3 by the product of permutations i and i + 3.
+    int products[3][alphabetLength];
+    std::memset(products, -1, sizeof(products));
+    for (const std::string& indicator : indicators)
+    {
+        std::vector<uint8_t> letters = CompiledKey::ToIndices(indicator);
+        if (letters.size() < 6)
+            throw std::runtime_error("Indicator must have 6 letters.");
+        for (int i = 0; i < 3; i++)
+        {
+            int& image = products[i][letters[i]];
+            if (image >= 0 && image != letters[i + 3])
+                throw std::runtime_error("Indicators contradict each other.");
+            image = letters[i + 3];
+        }
+    }
+
+    uint32_t signature = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        // A product is a permutation, so a single missing letter maps to the only unused image.
+        int missing = -1, unused = alphabetLength * (alphabetLength - 1) / 2;
+        for (int letter = 0; letter < alphabetLength; letter++)
+        {
+            if (products[i][letter] < 0)
+            {
+                if (missing >= 0)
+                    throw std::runtime_error("Indicators do not determine the whole characteristic.");
+                missing = letter;
+            }
+            else
+                unused -= products[i][letter];
+        }
+        if (missing >= 0)
+            products[i][missing] = unused;
+
+        uint8_t product[alphabetLength];
+        for (int letter = 0; letter < alphabetLength; letter++)
+            product[letter] = (uint8_t)products[i][letter];
+        int partition = PartitionOf(product);
+        if (partition < 0)
+            throw std::runtime_error("Indicators do not come from a doubled message key.");
+        signature = signature * numberOfPartitions + partition;
+    }
+    return signature;
+}
+
+std::string CycleCatalog::ToString(uint32_t signature) noexcept
+{
+    if (signature >= (uint32_t)numberOfPartitions * numberOfPartitions * numberOfPartitions)
+        return "invalid";
+    const std::vector<PartitionKey>& table = PartitionTable();
+    int partitions[3] = {(int)(signature / (numberOfPartitions * numberOfPartitions)),
+                         (int)(signature / numberOfPartitions % numberOfPartitions), (int)(signature % numberOfPartitions)};
+    std::string res;
+    for (int i = 0; i < 3; i++)
+    {
+        if (i)
+            res += " |";
+        for (int length = halfLength; length >= 1; length--)
+            for (int n = (int)(table[partitions[i]] >> (4 * (length - 1)) & 15); n > 0; n--)
+                res += " " + std::to_string(length) + " " + std::to_string(length);
+    }
+    return res.substr(1);
+}
+
+CycleCatalog CycleCatalog::Build(const CycleCatalogOptions& options, ThreadPool& pool) noexcept
+{
+    std::vector<std::array<RotorID, 3>> orders = IocSearch::WheelOrders();
+    const size_t tasks = options.Reflectors.size() * orders.size();
+
+    CycleCatalog catalog;
+    catalog.Rings = options.Rings;
+    catalog.Owned.resize(tasks * KeystreamTable::numberOfStates);
+
+    pool.ParallelFor(tasks, [&](size_t t) {
+        ReflectorID reflector = options.Reflectors[t / orders.size()];
+        uint8_t plugboard[alphabetLength];
+        for (int i = 0; i < alphabetLength; i++)
+            plugboard[i] = (uint8_t)i;
+        KeystreamTable table{CompiledKey(reflector, orders[t % orders.size()], options.Rings, plugboard)};
+        std::vector<uint16_t> next = table.NextStates();
+
+        CycleCatalogEntry* entries = &catalog.Owned[t * KeystreamTable::numberOfStates];
+        for (int start = 0; start < KeystreamTable::numberOfStates; start++)
+        {
+            const uint8_t* permutations[6];
+            int state = start;
+            for (int i = 0; i < 6; i++)
+            {
+                state = next[state];
+                permutations[i] = table.getPermutation(state);
+            }
+            entries[start].Signature = SignatureOf(permutations);
+            entries[start].State = (uint16_t)start;
+            entries[start].WheelOrder = (uint8_t)(t % orders.size());
+            entries[start].Reflector = (uint8_t)reflector;
+        }
+    });
+
+    std::sort(catalog.Owned.begin(), catalog.Owned.end(),
+              [](const CycleCatalogEntry& a, const CycleCatalogEntry& b) { return SortKey(a) < SortKey(b); });
+    catalog.Entries = catalog.Owned.data();
+    catalog.Size = catalog.Owned.size();
+    for (size_t i = 0; i < catalog.Size; i++)
+        catalog.NumberOfSignatures += i == 0 || catalog.Entries[i].Signature != catalog.Entries[i - 1].Signature;
+    return catalog;
+}
+
+CycleCatalog CycleCatalog::Load(const std::string& FilePath)
+{
+    std::unique_ptr<MappedFile> mapping(new MappedFile(FilePath));
+    FileHeader header;
+    if (mapping->getSize() < entriesOffset)
+        throw std::runtime_error("Invalid cycle catalog file.");
+    std::memcpy(&header, mapping->getData(), sizeof(header));
+    if (std::memcmp(header.Magic, catalogMagic, sizeof(catalogMagic)) != 0)
+        throw std::runtime_error("Invalid cycle catalog file.");
+    if (header.FormatVersion != formatVersion || header.WiringVersion != SettingsConversion::WiringTableVersion)
+        throw std::runtime_error("Cycle catalog was built by other version, rebuild it.");
+    if (header.EntriesOffset != entriesOffset ||
+        mapping->getSize() != entriesOffset + header.NumberOfEntries * sizeof(CycleCatalogEntry))
+        throw std::runtime_error("Invalid cycle catalog file.");
+
+    CycleCatalog catalog;
+    catalog.Entries = reinterpret_cast<const CycleCatalogEntry*>(mapping->getData() + entriesOffset);
+    catalog.Size = header.NumberOfEntries;
+    catalog.NumberOfSignatures = header.NumberOfSignatures;
+    catalog.Rings = {{header.Rings[0], header.Rings[1], header.Rings[2]}};
+    catalog.Mapping = std::move(mapping);
+    return catalog;
+}
+
+void CycleCatalog::Save(const std::string& FilePath) const
+{
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.Magic, catalogMagic, sizeof(catalogMagic));
+    header.FormatVersion = formatVersion;
+    header.WiringVersion = SettingsConversion::WiringTableVersion;
+    for (int i = 0; i < 3; i++)
+        header.Rings[i] = Rings[i];
+    header.EntriesOffset = entriesOffset;
+    header.NumberOfEntries = Size;
+    header.NumberOfSignatures = NumberOfSignatures;
+
+    std::vector<char> page(entriesOffset, 0);
+    std::memcpy(page.data(), &header, sizeof(header));
+
+    std::string tmpPath = FilePath + '.' + std::to_string(getpid()) + ".tmp";
+    std::ofstream out(tmpPath, std::ios::binary);
+    if (!out.good())
+        throw std::runtime_error("Error while writing to a file.");
+    out.write(page.data(), page.size());
+    out.write(reinterpret_cast<const char*>(Entries), Size * sizeof(CycleCatalogEntry));
+    out.close();
+    PublishFile(tmpPath, FilePath, !out.fail());
+}
+
+size_t CycleCatalog::Lookup(uint32_t signature, const CycleCatalogEntry*& first) const noexcept
+{
+    auto range = std::equal_range(Entries, Entries + Size, CycleCatalogEntry{signature, 0, 0, 0},
+                                  [](const CycleCatalogEntry& a, const CycleCatalogEntry& b) { return a.Signature < b.Signature; });
+    first = range.first;
+    return range.second - range.first;
+}
+
+KeyCandidate CycleCatalog::ToCandidate(const CycleCatalogEntry& entry) const noexcept
+{
+    static const std::vector<std::array<RotorID, 3>> orders = IocSearch::WheelOrders();
+    KeyCandidate candidate;
+    candidate.Score = 0;
+    candidate.Reflector = (ReflectorID)entry.Reflector;
+    candidate.Rotors = orders[entry.WheelOrder];
+    candidate.Rings = Rings;
+    candidate.Positions = {{entry.State / 676, entry.State / 26 % 26, entry.State % 26}};
+    return candidate;
+}
+
+std::vector<KeyCandidate> CycleCatalog::Find(uint32_t signature) const noexcept
+{
+    const CycleCatalogEntry* first;
+    size_t count = Lookup(signature, first);
+    std::vector<KeyCandidate> res;
+    res.reserve(count);
+    for (size_t i = 0; i < count; i++)
+        res.push_back(ToCandidate(first[i]));
+    return res;
+}
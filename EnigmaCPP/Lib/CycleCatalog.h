@@ -0,0 +1,217 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "CandidateHeap.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Enigma
+{
+    /* Options of CycleCatalog::Build. */
+    struct CycleCatalogOptions
+    {
+        /* Reflectors to be catalogued. */
+        std::vector<ReflectorID> Reflectors = {B, C};
+
+        /* Ring settings used for every wheel order (0 - 25). */
+        std::array<int, 3> Rings = {{0, 0, 0}};
+    };
+
+    /* Entry of the catalog, 8 bytes. */
+    struct CycleCatalogEntry
+    {
+        /* Characteristic, see CycleCatalog::SignatureOf(). */
+        uint32_t Signature;
+
+        /* Grundstellung as KeystreamTable::StateIndex. */
+        uint16_t State;
+
+        /* Index in IocSearch::WheelOrders(). */
+        uint8_t WheelOrder;
+
+        /* ReflectorID. */
+        uint8_t Reflector;
+    };
+
+    /**
+     * Rejewski's catalog of the characteristic of doubled indicators.
+     *
+     * The 6 letters of a doubled indicator are encrypted by permutations A - F at successive key presses
+     * from the Grundstellung. The products AD, BE and CF are known from a day of traffic without knowing the key,
+     * and the lengths of their cycles (the characteristic) do not depend on the plugboard, which only conjugates them.
+     * Cycles of such a product come in pairs of equal length, so a product is a partition of 13 (one of 101)
+     * and the characteristic packs into a single number.
+     *
+     * The catalog holds the characteristic of every reflector, wheel order and Grundstellung at fixed rings,
+     * sorted by characteristic. It is saved to a page-aligned, versioned file which is mapped by Load(),
+     * so a lookup is a binary search over the mapping.
+     */
+    class CycleCatalog
+    {
+    public:
+        /* Version of the file format. */
+        static const uint32_t formatVersion = 1;
+
+        /* Number of partitions of 13, different cycle structures of a single product. */
+        static const int numberOfPartitions = 101;
+
+        /**
+         * Builds the catalog in memory, one (reflector, wheel order) per task of the pool.
+         *
+         * Params:
+         * const CycleCatalogOptions& options - options.
+         * ThreadPool& pool - threads used for building.
+         *
+         * Returns:
+         * CycleCatalog - sorted catalog.
+         */
+        static CycleCatalog Build(const CycleCatalogOptions& options, ThreadPool& pool) noexcept;
+
+        /**
+         * Maps a catalog saved by Save().
+         *
+         * Params:
+         * const std::string& FilePath - path of the file.
+         *
+         * Exceptions:
+         * If the file cannot be mapped, is damaged, or was built with other format or wiring tables version,
+         * an exception will be thrown.
+         *
+         * Returns:
+         * CycleCatalog - mapped catalog.
+         */
+        static CycleCatalog Load(const std::string& FilePath) noexcept(false);
+
+        /**
+         * Saves the catalog. The file is written under a temporary name and renamed,
+         * so readers never see a partial file.
+         *
+         * Params:
+         * const std::string& FilePath - path of the file.
+         *
+         * Exceptions:
+         * If the file cannot be written, an exception will be thrown.
+         */
+        void Save(const std::string& FilePath) const noexcept(false);
+
+        /**
+         * Finds entries with given characteristic, a binary search over the sorted entries.
+         *
+         * Params:
+         * uint32_t signature - characteristic, see SignatureOf().
+         * const CycleCatalogEntry*& first - first found entry.
+         *
+         * Returns:
+         * size_t - number of found entries, they follow @first.
+         */
+        size_t Lookup(uint32_t signature, const CycleCatalogEntry*& first) const noexcept;
+
+        /**
+         * Converts an entry to settings.
+         *
+         * Params:
+         * const CycleCatalogEntry& entry - entry of this catalog.
+         *
+         * Returns:
+         * KeyCandidate - settings with the Grundstellung as start position, Score is 0.
+         */
+        KeyCandidate ToCandidate(const CycleCatalogEntry& entry) const noexcept;
+
+        /**
+         * Finds all settings with given characteristic.
+         *
+         * Params:
+         * uint32_t signature - characteristic, see SignatureOf().
+         *
+         * Returns:
+         * std::vector<KeyCandidate> - settings with the Grundstellung as start position, Score is 0.
+         */
+        std::vector<KeyCandidate> Find(uint32_t signature) const noexcept;
+
+        /**
+         * Computes the characteristic of permutations A - F.
+         *
+         * Params:
+         * const uint8_t* const* permutations - 6 permutations of 26 alphabet indices, the first one used
+         *   for the first letter of the indicator.
+         *
+         * Returns:
+         * uint32_t - characteristic, (AD * 101 + BE) * 101 + CF where a product is the index of its partition of 13.
+         *   UINT32_MAX if a product does not have its cycles in pairs (A - F are not reciprocal).
+         */
+        static uint32_t SignatureOf(const uint8_t* const* permutations) noexcept;
+
+        /**
+         * Computes the characteristic from doubled indicators of a day.
+         *
+         * Params:
+         * const std::vector<std::string>& indicators - encrypted indicators, first 6 letters of each are used.
+         *
+         * Exceptions:
+         * If an indicator is shorter than 6 letters, indicators contradict each other,
+         * or they do not determine all letters of the three products, an exception will be thrown.
+         *
+         * Returns:
+         * uint32_t - characteristic.
+         */
+        static uint32_t SignatureOf(const std::vector<std::string>& indicators) noexcept(false);
+
+        /**
+         * Formats a characteristic as cycle lengths of AD, BE and CF, e.g. "13 13 | 10 10 3 3 | 12 12 1 1".
+         *
+         * Params:
+         * uint32_t signature - characteristic.
+         *
+         * Returns:
+         * std::string - formatted characteristic.
+         */
+        static std::string ToString(uint32_t signature) noexcept;
+
+        /* Number of entries. */
+        size_t size() const noexcept { return Size; }
+
+        /* Number of different characteristics. */
+        size_t getNumberOfSignatures() const noexcept { return NumberOfSignatures; }
+
+        /* Ring settings the catalog was built with. */
+        const std::array<int, 3>& getRings() const noexcept { return Rings; }
+
+        /* Entries sorted by characteristic. */
+        const CycleCatalogEntry* getEntries() const noexcept { return Entries; }
+
+        /* Returns true if the catalog is mapped from a file. */
+        bool isMapped() const noexcept { return Mapping != nullptr; }
+
+    private:
+        /* Constructor, used by Build() and Load(). */
+        CycleCatalog() noexcept : Entries(nullptr), Size(0), NumberOfSignatures(0), Rings({{0, 0, 0}}) {}
+
+        /* Entries of a built catalog, empty if mapped. */
+        std::vector<CycleCatalogEntry> Owned;
+
+        /* Mapping of the file, nullptr if built in memory. */
+        std::unique_ptr<MappedFile> Mapping;
+
+        /* Entries, either in @Owned or in @Mapping. */
+        const CycleCatalogEntry* Entries;
+
+        /* Number of entries. */
+        size_t Size;
+
+        /* Number of different characteristics. */
+        size_t NumberOfSignatures;
+
+        /* Ring settings used for every wheel order. */
+        std::array<int, 3> Rings;
+    };
+}
@@ -0,0 +1,231 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "DepthSearch.h"
+#include "CompiledKey.h"
+
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace Enigma;
+
+namespace
+{
+#if defined(__AVX512BW__)
+    typedef int8_t Bytes __attribute__((vector_size(64)));
+#elif defined(__AVX2__)
+    typedef int8_t Bytes __attribute__((vector_size(32)));
+#else
+    typedef int8_t Bytes __attribute__((vector_size(16)));
+#endif
+
+    const int width = sizeof(Bytes);
+
+    /* Probability of a coincidence of unrelated texts. */
+    const double randomRate = 1.0 / CompiledKey::alphabetLength;
+
+    /* Bit i is set if byte i of @v is set (0xFF). */
+    inline uint64_t Mask(const Bytes& v) noexcept
+    {
+#if defined(__AVX512BW__)
+        return _mm512_movepi8_mask((__m512i)v);
+#elif defined(__AVX2__)
+        return (uint32_t)_mm256_movemask_epi8((__m256i)v);
+#elif defined(__SSE2__)
+        return (uint16_t)_mm_movemask_epi8((__m128i)v);
+#else
+        uint64_t mask = 0;
+        for (int i = 0; i < width; i++)
+            mask |= (uint64_t)(v[i] != 0) << i;
+        return mask;
+#endif
+    }
+
+    inline Bytes Load(const uint8_t* p) noexcept
+    {
+        Bytes v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    /* Counts equal letters, reads up to a vector past @length, which must be padding. */
+    inline size_t CountPadded(const uint8_t* a, const uint8_t* b, size_t length) noexcept
+    {
+        size_t count = 0, i = 0;
+        for (; i + width <= length; i += width)
+            count += __builtin_popcountll(Mask(Load(a + i) == Load(b + i)));
+        if (i < length)
+            count += __builtin_popcountll(Mask(Load(a + i) == Load(b + i)) & (((uint64_t)1 << (length - i)) - 1));
+        return count;
+    }
+
+    /* Natural logarithm of the probability of @equal coincidences out of @overlap for unrelated texts. */
+    inline double LogProbability(size_t overlap, size_t equal) noexcept
+    {
+        return std::lgamma(overlap + 1.0) - std::lgamma(equal + 1.0) - std::lgamma(overlap - equal + 1.0) +
+               equal * std::log(randomRate) + (overlap - equal) * std::log(1 - randomRate);
+    }
+
+    /* -log10 of the probability of at least @equal coincidences out of @overlap for unrelated texts (binomial tail). */
+    double TailScore(size_t overlap, size_t equal) noexcept
+    {
+        double first = LogProbability(overlap, equal), sum = 1;
+        for (size_t k = equal + 1; k <= overlap; k++)
+        {
+            double term = std::exp(LogProbability(overlap, k) - first);
+            sum += term;
+            if (term < 1e-12 * sum)
+                break;
+        }
+        return -(first + std::log(sum)) / std::log(10.0);
+    }
+
+    /* Orders candidates so that the worst one is on the top of std heap functions, ties by the pair. */
+    bool Better(const DepthCandidate& a, const DepthCandidate& b) noexcept
+    {
+        if (a.Score != b.Score)
+            return a.Score > b.Score;
+        if (a.First != b.First)
+            return a.First < b.First;
+        if (a.Second != b.Second)
+            return a.Second < b.Second;
+        return a.Offset < b.Offset;
+    }
+
+    /* Top-K of a task. */
+    struct TaskResult
+    {
+        std::vector<DepthCandidate> Heap;
+        uint64_t Pairs = 0;
+        uint64_t Offsets = 0;
+        uint64_t Letters = 0;
+
+        void Push(const DepthCandidate& candidate, size_t capacity) noexcept
+        {
+            if (Heap.size() < capacity)
+            {
+                Heap.push_back(candidate);
+                std::push_heap(Heap.begin(), Heap.end(), Better);
+            }
+            else if (Better(candidate, Heap.front()))
+            {
+                std::pop_heap(Heap.begin(), Heap.end(), Better);
+                Heap.back() = candidate;
+                std::push_heap(Heap.begin(), Heap.end(), Better);
+            }
+        }
+    };
+}
+
+size_t DepthSearch::Coincidences(const uint8_t* a, const uint8_t* b, size_t length) noexcept
+{
+    size_t count = 0, i = 0;
+    for (; i + width <= length; i += width)
+        count += __builtin_popcountll(Mask(Load(a + i) == Load(b + i)));
+    for (; i < length; i++)
+        count += a[i] == b[i];
+    return count;
+}
+
+DepthSearchResult DepthSearch::Run(const std::vector<std::string>& messages, const DepthSearchOptions& options, ThreadPool& pool) noexcept
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    // All messages in one buffer, each followed by a vector of padding read by the last compare.
+    std::vector<size_t> starts, lengths;
+    std::vector<uint8_t> letters;
+    size_t maxLength = 0;
+    for (const std::string& message : messages)
+    {
+        std::vector<uint8_t> indices = CompiledKey::ToIndices(message);
+        starts.push_back(letters.size());
+        lengths.push_back(indices.size());
+        maxLength = std::max(maxLength, indices.size());
+        letters.insert(letters.end(), indices.begin(), indices.end());
+        letters.insert(letters.end(), width, 0);
+    }
+
+    // Lowest number of coincidences reaching MinScore, for every overlap. The tail only grows as the count goes down,
+    // so the search starts above the mean.
+    std::vector<size_t> minCount(maxLength + 1);
+    for (size_t overlap = 1; overlap <= maxLength; overlap++)
+    {
+        size_t equal = (size_t)std::ceil(overlap * randomRate);
+        while (equal <= overlap && TailScore(overlap, equal) < options.MinScore)
+            equal++;
+        minCount[overlap] = equal;
+    }
+
+    const size_t count = messages.size();
+    const size_t blocks = (count + blockSize - 1) / blockSize;
+    const size_t tasks = (blocks + 1) / 2;
+    const int maxOffset = std::max(options.MaxOffset, 0);
+    const size_t minOverlap = std::max(options.MinOverlap, (size_t)1);
+    std::vector<TaskResult> results(tasks);
+
+    // Task t takes block rows t and blocks - 1 - t, so all tasks compare about the same number of pairs.
+    pool.ParallelFor(tasks, [&](size_t t) {
+        TaskResult& res = results[t];
+        size_t rows[2] = {t, blocks - 1 - t};
+        for (int r = 0; r < (rows[0] == rows[1] ? 1 : 2); r++)
+        {
+            size_t firstEnd = std::min((rows[r] + 1) * blockSize, count);
+            for (size_t column = rows[r]; column < blocks; column++)
+            {
+                size_t secondEnd = std::min((column + 1) * blockSize, count);
+                for (size_t i = rows[r] * blockSize; i < firstEnd; i++)
+                    for (size_t j = std::max(column * blockSize, i + 1); j < secondEnd; j++)
+                    {
+                        res.Pairs++;
+                        for (int offset = -maxOffset; offset <= maxOffset; offset++)
+                        {
+                            size_t skipFirst = offset < 0 ? -offset : 0, skipSecond = offset > 0 ? offset : 0;
+                            if (skipFirst >= lengths[i] || skipSecond >= lengths[j])
+                                continue;
+                            size_t overlap = std::min(lengths[i] - skipFirst, lengths[j] - skipSecond);
+                            if (overlap < minOverlap)
+                                continue;
+                            size_t equal = CountPadded(&letters[starts[i] + skipFirst], &letters[starts[j] + skipSecond], overlap);
+                            res.Offsets++;
+                            res.Letters += overlap;
+                            if (equal < minCount[overlap])
+                                continue;
+
+                            DepthCandidate candidate;
+                            candidate.Score = TailScore(overlap, equal);
+                            candidate.First = i;
+                            candidate.Second = j;
+                            candidate.Offset = offset;
+                            candidate.Overlap = overlap;
+                            candidate.Coincidences = equal;
+                            res.Push(candidate, std::max(options.TopK, (size_t)1));
+                        }
+                    }
+            }
+        }
+    });
+
+    DepthSearchResult res;
+    res.PairsCompared = res.OffsetsCompared = res.LettersCompared = 0;
+    TaskResult best;
+    for (const TaskResult& result : results)
+    {
+        for (const DepthCandidate& candidate : result.Heap)
+            best.Push(candidate, std::max(options.TopK, (size_t)1));
+        res.PairsCompared += result.Pairs;
+        res.OffsetsCompared += result.Offsets;
+        res.LettersCompared += result.Letters;
+    }
+    res.Candidates = best.Heap;
+    std::sort(res.Candidates.begin(), res.Candidates.end(), Better);
+    res.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return res;
+}
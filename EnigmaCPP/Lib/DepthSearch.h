@@ -0,0 +1,114 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Enigma
+{
+    /* Options of DepthSearch. */
+    struct DepthSearchOptions
+    {
+        /* Relative offsets -MaxOffset ... MaxOffset are tested for every pair, 0 tests aligned messages only. */
+        int MaxOffset = 10;
+
+        /* Offsets where the messages overlap by fewer letters are skipped. */
+        size_t MinOverlap = 20;
+
+        /* Lowest reported score, -log10 of the chance of unrelated texts having as many coincidences. */
+        double MinScore = 6.0;
+
+        /* Number of kept candidates (K). */
+        size_t TopK = 100;
+    };
+
+    /* Pair of messages found in depth. */
+    struct DepthCandidate
+    {
+        /* -log10 of the probability that unrelated texts (coincidence rate 1/26) have as many coincidences. */
+        double Score;
+
+        /* Indices of the messages, First < Second. */
+        size_t First;
+        size_t Second;
+
+        /* Letter k of the first message lines up with letter k + Offset of the second one. */
+        int Offset;
+
+        /* Number of compared letters. */
+        size_t Overlap;
+
+        /* Number of equal letters. */
+        size_t Coincidences;
+    };
+
+    /* Result of DepthSearch::Run. */
+    struct DepthSearchResult
+    {
+        /* Best candidates, from the best one. */
+        std::vector<DepthCandidate> Candidates;
+
+        /* Number of compared pairs of messages. */
+        uint64_t PairsCompared;
+
+        /* Number of compared (pair, offset). */
+        uint64_t OffsetsCompared;
+
+        /* Number of compared letters. */
+        uint64_t LettersCompared;
+
+        /* Wall time of the search in seconds. */
+        double Seconds;
+    };
+
+    /**
+     * Finds messages in depth: encrypted with the same or an overlapping keystream.
+     *
+     * Letters of two texts under the same keystream coincide as often as the plaintexts do (about 1/15 in German)
+     * instead of 1/26, so every pair is compared at all offsets up to MaxOffset and scored by the binomial tail
+     * of its coincidences under the rate of unrelated texts.
+     * Letters are compared 16 at a time (32 with AVX2, 64 with AVX-512BW) and counted with popcount of the byte mask.
+     * Messages are cut into blocks of blockSize, a task compares one block with all following blocks,
+     * so the first block stays in cache. Tasks are spread across the threads of the pool, each keeping its own top-K.
+     */
+    class DepthSearch
+    {
+    public:
+        /* Number of messages in a block. */
+        static const size_t blockSize = 64;
+
+        /**
+         * Runs the search.
+         *
+         * Params:
+         * const std::vector<std::string>& messages - ciphertexts, characters out of the alphabet are ignored.
+         * const DepthSearchOptions& options - options.
+         * ThreadPool& pool - threads used for the search.
+         *
+         * Returns:
+         * DepthSearchResult - best candidates and statistics.
+         */
+        static DepthSearchResult Run(const std::vector<std::string>& messages, const DepthSearchOptions& options, ThreadPool& pool) noexcept;
+
+        /**
+         * Counts equal letters of two buffers.
+         *
+         * Params:
+         * const uint8_t* a - letters.
+         * const uint8_t* b - letters.
+         * size_t length - number of compared letters.
+         *
+         * Returns:
+         * size_t - number of positions where @a and @b are equal.
+         */
+        static size_t Coincidences(const uint8_t* a, const uint8_t* b, size_t length) noexcept;
+    };
+}
@@ -5,21 +5,27 @@
 
 #include "EnigmaCPP.h"
 #include "SettingsConversion.h"
+#include "Instrumentation.h"
 
 using namespace Enigma;
 
 Encoder::Encoder(const UserSettings& USettings)
 {
+    ENIGMA_COUNT(ReKeys, 1);
+    ENIGMA_SCOPED_TIMER(PhaseReKey);
     this->Settings = SettingsConversion::ConvertToEnigmaSettings(USettings);
 }
 
 void Encoder::setNewSettings(const UserSettings& nSettings)
 {
+    ENIGMA_COUNT(ReKeys, 1);
+    ENIGMA_SCOPED_TIMER(PhaseReKey);
     this->Settings = SettingsConversion::ConvertToEnigmaSettings(nSettings);
 }
 
 std::string Encoder::EncryptString(const std::string& origninalText) noexcept
 {
+    ENIGMA_SCOPED_TIMER(PhaseEncryptString);
     std::string encryptedText = "";
     for (int i = 0; i < origninalText.length(); i++)
     {
@@ -27,6 +33,7 @@ std::string Encoder::EncryptString(const std::string& origninalText) noexcept
         if (letter >= 'A' && letter <= 'Z')
             encryptedText += EncryptChar(letter);
     }
+    ENIGMA_COUNT(NonLettersDropped, origninalText.length() - encryptedText.length());
     return encryptedText;
 }
 
@@ -42,21 +49,35 @@ std::vector<char> Encoder::ReturnRotorsPosition() const noexcept
 
 char Encoder::EncryptChar(char letter) noexcept
 {
-    StepRotors();
+    ENIGMA_COUNT(LettersProcessed, 1);
+    {
+        ENIGMA_SCOPED_TIMER(PhaseStepping);
+        StepRotors();
+    }
 
-    letter = Settings.PlugboardConnections[letter];
+    {
+        ENIGMA_SCOPED_TIMER(PhasePlugboard);
+        letter = Settings.PlugboardConnections[letter];
+    }
 
-    // Pre-reflector encoding
-    for (int i = Settings.Rotors.size() - 1; i >= 0; i--)
-        letter = EnigmaPreRefEncoding(letter, i);
+    {
+        ENIGMA_SCOPED_TIMER(PhaseRotors);
 
-    letter = Settings.ReflectorAlphabet[letter - 'A'];
+        // Pre-reflector encoding
+        for (int i = Settings.Rotors.size() - 1; i >= 0; i--)
+            letter = EnigmaPreRefEncoding(letter, i);
 
-    // Post-reflector encoding
-    for (int i = 0; i < Settings.Rotors.size(); i++)
-        letter = EnigmaPostRefEncoding(letter, i);
+        letter = Settings.ReflectorAlphabet[letter - 'A'];
 
-    letter = Settings.PlugboardConnections[letter];
+        // Post-reflector encoding
+        for (int i = 0; i < Settings.Rotors.size(); i++)
+            letter = EnigmaPostRefEncoding(letter, i);
+    }
+
+    {
+        ENIGMA_SCOPED_TIMER(PhasePlugboard);
+        letter = Settings.PlugboardConnections[letter];
+    }
 
     return letter;
 }
@@ -90,6 +111,7 @@ void Encoder::StepRotors() noexcept
         // Double step sequence, ex.:
         // ADV -> step -> AEW -> step -> BFX
 
+        ENIGMA_COUNT(DoubleSteps, 1);
         Settings.Rotors[1].Position = (Settings.Rotors[1].Position + 1) % alphabetLength;
         Settings.Rotors[0].Position = (Settings.Rotors[0].Position + 1) % alphabetLength;
     }
@@ -146,17 +146,17 @@ namespace Enigma
          * Returns rotors.
          *
          * Returns:
-         * std::vector<UserRotor> - rotors.
+         * const std::vector<UserRotor>& - rotors.
          */
-        std::vector<UserRotor> getRotors() const noexcept { return Rotors; }
+        const std::vector<UserRotor>& getRotors() const noexcept { return Rotors; }
 
         /**
          * Returns plugboard connections.
          *
          * Returns:
-         * std::vector<std::string> - plugboard connections.
+         * const std::vector<std::string>& - plugboard connections.
          */
-        std::vector<std::string> getPlugboardConnections() const noexcept { return PlugboardConnections; }
+        const std::vector<std::string>& getPlugboardConnections() const noexcept { return PlugboardConnections; }
 
         /**
          * Sets reflector id.
@@ -0,0 +1,83 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "IndicatorProcedure.h"
+
+using namespace Enigma;
+
+IndicatorProcedure::IndicatorProcedure(const UserSettings& DailyKey, bool Doubled) :
+DailyKey(DailyKey), Grundstellung(CompiledKey::PositionsOf(DailyKey)), Doubled(Doubled) {}
+
+bool IndicatorProcedure::ToPositions(const std::string& letters, RotorPositions& positions) noexcept
+{
+    if (letters.size() != 3)
+        return false;
+    for (int i = 0; i < 3; i++)
+    {
+        if (letters[i] < 'A' || letters[i] > 'Z')
+            return false;
+        positions[i] = letters[i] - 'A';
+    }
+    return true;
+}
+
+IndicatorResult IndicatorProcedure::Encrypt(const std::string& messageKey, const std::string& plainText) const noexcept
+{
+    IndicatorResult res = {"", messageKey, "", nullptr};
+    RotorPositions messagePos;
+    if (!ToPositions(messageKey, messagePos))
+    {
+        res.Error = "Message key must be 3 uppercase letters.";
+        return res;
+    }
+
+    RotorPositions positions = Grundstellung;
+    std::string typed = Doubled ? messageKey + messageKey : messageKey;
+    res.Indicator = DailyKey.EncryptString(typed, positions);
+    res.Body = DailyKey.EncryptString(plainText, messagePos);
+    return res;
+}
+
+IndicatorResult IndicatorProcedure::Decrypt(const std::string& indicator, const std::string& cipherText) const noexcept
+{
+    IndicatorResult res = {indicator, "", "", nullptr};
+    if (indicator.size() != (Doubled ? 6u : 3u))
+    {
+        res.Error = Doubled ? "Indicator must be 6 letters." : "Indicator must be 3 letters.";
+        return res;
+    }
+    for (char c : indicator)
+        if (c < 'A' || c > 'Z')
+        {
+            res.Error = "Indicator must be uppercase letters.";
+            return res;
+        }
+
+    RotorPositions positions = Grundstellung;
+    std::string key = DailyKey.EncryptString(indicator, positions);
+    if (Doubled && key.compare(0, 3, key, 3, 3) != 0)
+    {
+        res.Error = "Halves of the doubled indicator do not match.";
+        return res;
+    }
+    res.MessageKey = key.substr(0, 3);
+
+    RotorPositions messagePos;
+    ToPositions(res.MessageKey, messagePos);
+    res.Body = DailyKey.EncryptString(cipherText, messagePos);
+    return res;
+}
+
+std::vector<IndicatorResult> IndicatorProcedure::ProcessBatch(const std::vector<IndicatorMessage>& messages, bool encrypt, ThreadPool& pool) const noexcept
+{
+    std::vector<IndicatorResult> results(messages.size());
+    size_t tasks = (messages.size() + messagesPerTask - 1) / messagesPerTask;
+    pool.ParallelFor(tasks, [&](size_t t) {
+        size_t last = (t + 1) * messagesPerTask < messages.size() ? (t + 1) * messagesPerTask : messages.size();
+        for (size_t i = t * messagesPerTask; i < last; i++)
+            results[i] = encrypt ? Encrypt(messages[i].Key, messages[i].Body) : Decrypt(messages[i].Key, messages[i].Body);
+    });
+    return results;
+}
@@ -0,0 +1,127 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "CompiledKey.h"
+#include "ThreadPool.h"
+
+#include <string>
+#include <vector>
+
+namespace Enigma
+{
+    /* Single message of a batch. */
+    struct IndicatorMessage
+    {
+        /* Message key in clear (encryption) or indicator as received (decryption). */
+        std::string Key;
+
+        /* Message body. */
+        std::string Body;
+    };
+
+    /* Result of processing a single message. */
+    struct IndicatorResult
+    {
+        /* Encrypted message key, as transmitted. */
+        std::string Indicator;
+
+        /* Message key in clear. */
+        std::string MessageKey;
+
+        /* Encrypted/decrypted body. */
+        std::string Body;
+
+        /* Reason of failure, nullptr on success. */
+        const char* Error;
+    };
+
+    /**
+     * Indicator procedure.
+     *
+     * The message key chosen by the operator is encrypted at the daily Grundstellung
+     * (rotors position of the daily key) and the body is encrypted with the message key as rotors position.
+     * The daily key is compiled once and shared by all messages, so batches run in parallel without copies.
+     */
+    class IndicatorProcedure
+    {
+    public:
+        /**
+         * Constructor.
+         *
+         * Params:
+         * const UserSettings& DailyKey - daily key, rotors position is used as Grundstellung.
+         * bool Doubled - if true, the message key is typed twice before encryption (6 letter indicators).
+         *
+         * Exceptions:
+         * If @DailyKey is invalid an exception will be thrown.
+         */
+        IndicatorProcedure(const UserSettings& DailyKey, bool Doubled = false) noexcept(false);
+
+        /**
+         * Encrypts a message.
+         *
+         * Params:
+         * const std::string& messageKey - 3 uppercase letters.
+         * const std::string& plainText - body, same rules as Encoder::EncryptString.
+         *
+         * Returns:
+         * IndicatorResult - indicator and encrypted body, or an error.
+         */
+        IndicatorResult Encrypt(const std::string& messageKey, const std::string& plainText) const noexcept;
+
+        /**
+         * Decrypts a message.
+         *
+         * Params:
+         * const std::string& indicator - 3 uppercase letters, 6 if message keys are doubled.
+         * const std::string& cipherText - body.
+         *
+         * Returns:
+         * IndicatorResult - message key and decrypted body, or an error
+         * (e.g. both halves of a doubled indicator do not match).
+         */
+        IndicatorResult Decrypt(const std::string& indicator, const std::string& cipherText) const noexcept;
+
+        /**
+         * Encrypts or decrypts a batch of messages in parallel.
+         *
+         * Params:
+         * const std::vector<IndicatorMessage>& messages - messages.
+         * bool encrypt - true for encryption, false for decryption.
+         * ThreadPool& pool - threads used for processing.
+         *
+         * Returns:
+         * std::vector<IndicatorResult> - results in the order of @messages.
+         */
+        std::vector<IndicatorResult> ProcessBatch(const std::vector<IndicatorMessage>& messages, bool encrypt, ThreadPool& pool) const noexcept;
+
+    private:
+        /* Daily key. */
+        CompiledKey DailyKey;
+
+        /* Grundstellung, rotors position of the daily key. */
+        RotorPositions Grundstellung;
+
+        /* True if message keys are doubled. */
+        bool Doubled;
+
+        /* Number of messages processed by a single task of a batch. */
+        static const size_t messagesPerTask = 64;
+
+        /**
+         * Converts 3 letters to rotors position.
+         *
+         * Params:
+         * const std::string& letters - letters.
+         * RotorPositions& positions - converted position.
+         *
+         * Returns:
+         * bool - false if @letters are not 3 uppercase letters.
+         */
+        static bool ToPositions(const std::string& letters, RotorPositions& positions) noexcept;
+    };
+}
@@ -0,0 +1,256 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "Instrumentation.h"
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+#ifdef ENIGMA_INSTRUMENTATION
+#include <unistd.h>
+#include <sys/syscall.h>
+#if defined(__linux__) && defined(SYS_perf_event_open)
+#include <linux/perf_event.h>
+#define ENIGMA_PERF_EVENTS
+#endif
+#endif
+
+using namespace Enigma;
+using namespace Enigma::Instrumentation;
+
+const char* const Instrumentation::counterNames[numberOfCounters] = {
+    "lettersProcessed", "nonLettersDropped", "doubleSteps", "reKeys", "bytesRead", "bytesWritten"};
+
+const char* const Instrumentation::phaseNames[numberOfPhases] = {
+    "stepping", "plugboard", "rotors", "encryptString", "reKey", "fileRead", "fileWrite"};
+
+std::string Snapshot::ToJson() const noexcept
+{
+    std::string json = "{\"enabled\": ";
+    json += Enabled ? "true" : "false";
+    json += ", \"hardwareCounters\": ";
+    json += HardwareCounters ? "true" : "false";
+    json += ", \"threads\": " + std::to_string(Threads) + ", \"counters\": {";
+    for (int c = 0; c < numberOfCounters; c++)
+        json += std::string(c ? ", " : "") + '"' + counterNames[c] + "\": " + std::to_string(Counters[c]);
+    json += "}, \"phases\": {";
+    for (int p = 0; p < numberOfPhases; p++)
+    {
+        const PhaseStats& phase = Phases[p];
+        char line[384];
+        std::snprintf(line, sizeof(line),
+                      "%s\"%s\": {\"calls\": %llu, \"timedCalls\": %llu, \"nanoseconds\": %llu, \"estimatedNanoseconds\": %.0f, "
+                      "\"cycles\": %llu, \"instructions\": %llu, \"cacheMisses\": %llu}",
+                      p ? ", " : "", phaseNames[p], (unsigned long long)phase.Calls, (unsigned long long)phase.TimedCalls,
+                      (unsigned long long)phase.Nanoseconds, phase.EstimatedNanoseconds(), (unsigned long long)phase.Cycles,
+                      (unsigned long long)phase.Instructions, (unsigned long long)phase.CacheMisses);
+        json += line;
+    }
+    json += "}}";
+    return json;
+}
+
+#ifndef ENIGMA_INSTRUMENTATION
+
+Snapshot Instrumentation::Collect() noexcept
+{
+    return Snapshot();
+}
+
+void Instrumentation::Reset() noexcept
+{
+}
+
+#else
+
+namespace
+{
+    /* Per-letter phases are timed once per this many calls. */
+    const uint64_t sampleMask = 63;
+
+    /* Adds to a counter written only by its thread; readers may see a slightly old value. */
+    inline void Bump(std::atomic<uint64_t>& value, uint64_t n) noexcept
+    {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+}
+
+struct Instrumentation::ThreadBlock
+{
+    struct Phase
+    {
+        std::atomic<uint64_t> Calls, TimedCalls, Nanoseconds, Cycles, Instructions, CacheMisses;
+    };
+
+    std::atomic<uint64_t> Counters[numberOfCounters];
+    Phase Phases[numberOfPhases];
+
+    /* Group of cycles, instructions and cache misses counters of the thread, -1 if unavailable. */
+    int PerfFds[3];
+
+    ThreadBlock() noexcept
+    {
+        for (std::atomic<uint64_t>& counter : Counters)
+            counter.store(0, std::memory_order_relaxed);
+        for (Phase& phase : Phases)
+            for (std::atomic<uint64_t>* value : {&phase.Calls, &phase.TimedCalls, &phase.Nanoseconds, &phase.Cycles, &phase.Instructions, &phase.CacheMisses})
+                value->store(0, std::memory_order_relaxed);
+        PerfFds[0] = PerfFds[1] = PerfFds[2] = -1;
+        OpenPerfEvents();
+    }
+
+    ~ThreadBlock() noexcept
+    {
+        ClosePerfEvents();
+    }
+
+    void OpenPerfEvents() noexcept
+    {
+#ifdef ENIGMA_PERF_EVENTS
+        const uint64_t configs[3] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES};
+        for (int i = 0; i < 3; i++)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            PerfFds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, i ? PerfFds[0] : -1, 0);
+            if (PerfFds[i] < 0)
+            {
+                ClosePerfEvents();
+                return;
+            }
+        }
+#endif
+    }
+
+    void ClosePerfEvents() noexcept
+    {
+        for (int& fd : PerfFds)
+        {
+            if (fd >= 0)
+                close(fd);
+            fd = -1;
+        }
+    }
+
+    /* Reads the hardware counters, false if unavailable. */
+    bool ReadPerfEvents(uint64_t* values) const noexcept
+    {
+        if (PerfFds[0] < 0)
+            return false;
+        uint64_t buffer[4];
+        if (read(PerfFds[0], buffer, sizeof(buffer)) != (ssize_t)sizeof(buffer) || buffer[0] != 3)
+            return false;
+        std::memcpy(values, buffer + 1, 3 * sizeof(uint64_t));
+        return true;
+    }
+};
+
+namespace
+{
+    /* Blocks of all threads, kept after a thread ends so its counts are not lost. */
+    std::mutex registryLock;
+    std::vector<std::unique_ptr<ThreadBlock>>& Registry() noexcept
+    {
+        static std::vector<std::unique_ptr<ThreadBlock>>* blocks = new std::vector<std::unique_ptr<ThreadBlock>>();
+        return *blocks;
+    }
+}
+
+ThreadBlock& Instrumentation::LocalBlock() noexcept
+{
+    thread_local ThreadBlock* block = nullptr;
+    if (block == nullptr)
+    {
+        std::unique_ptr<ThreadBlock> created(new ThreadBlock());
+        block = created.get();
+        std::lock_guard<std::mutex> guard(registryLock);
+        Registry().push_back(std::move(created));
+    }
+    return *block;
+}
+
+void Instrumentation::Add(Counter counter, uint64_t n) noexcept
+{
+    Bump(LocalBlock().Counters[counter], n);
+}
+
+ScopedTimer::ScopedTimer(Phase phase) noexcept : Block(LocalBlock()), TimedPhase(phase)
+{
+    uint64_t calls = Block.Phases[phase].Calls.load(std::memory_order_relaxed);
+    Block.Phases[phase].Calls.store(calls + 1, std::memory_order_relaxed);
+    Timed = phase >= PhaseEncryptString || (calls & sampleMask) == 0;
+    if (!Timed)
+        return;
+    if (phase < PhaseEncryptString || !Block.ReadPerfEvents(StartCounters))
+        StartCounters[0] = StartCounters[1] = StartCounters[2] = UINT64_MAX;
+    Start = std::chrono::steady_clock::now();
+}
+
+ScopedTimer::~ScopedTimer() noexcept
+{
+    if (!Timed)
+        return;
+    uint64_t elapsed = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count();
+    ThreadBlock::Phase& phase = Block.Phases[TimedPhase];
+    Bump(phase.TimedCalls, 1);
+    Bump(phase.Nanoseconds, elapsed);
+    uint64_t end[3];
+    if (StartCounters[0] != UINT64_MAX && Block.ReadPerfEvents(end))
+    {
+        Bump(phase.Cycles, end[0] - StartCounters[0]);
+        Bump(phase.Instructions, end[1] - StartCounters[1]);
+        Bump(phase.CacheMisses, end[2] - StartCounters[2]);
+    }
+}
+
+Snapshot Instrumentation::Collect() noexcept
+{
+    Snapshot snapshot;
+    std::lock_guard<std::mutex> guard(registryLock);
+    for (const std::unique_ptr<ThreadBlock>& block : Registry())
+    {
+        snapshot.Threads++;
+        snapshot.HardwareCounters = snapshot.HardwareCounters || block->PerfFds[0] >= 0;
+        for (int c = 0; c < numberOfCounters; c++)
+            snapshot.Counters[c] += block->Counters[c].load(std::memory_order_relaxed);
+        for (int p = 0; p < numberOfPhases; p++)
+        {
+            const ThreadBlock::Phase& from = block->Phases[p];
+            PhaseStats& to = snapshot.Phases[p];
+            to.Calls += from.Calls.load(std::memory_order_relaxed);
+            to.TimedCalls += from.TimedCalls.load(std::memory_order_relaxed);
+            to.Nanoseconds += from.Nanoseconds.load(std::memory_order_relaxed);
+            to.Cycles += from.Cycles.load(std::memory_order_relaxed);
+            to.Instructions += from.Instructions.load(std::memory_order_relaxed);
+            to.CacheMisses += from.CacheMisses.load(std::memory_order_relaxed);
+        }
+    }
+    return snapshot;
+}
+
+void Instrumentation::Reset() noexcept
+{
+    std::lock_guard<std::mutex> guard(registryLock);
+    for (const std::unique_ptr<ThreadBlock>& block : Registry())
+    {
+        for (std::atomic<uint64_t>& counter : block->Counters)
+            counter.store(0, std::memory_order_relaxed);
+        for (ThreadBlock::Phase& phase : block->Phases)
+            for (std::atomic<uint64_t>* value : {&phase.Calls, &phase.TimedCalls, &phase.Nanoseconds, &phase.Cycles, &phase.Instructions, &phase.CacheMisses})
+                value->store(0, std::memory_order_relaxed);
+    }
+}
+
+#endif
@@ -0,0 +1,192 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "IocSearch.h"
+#include "KeystreamTable.h"
+#include "RingClasses.h"
+
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+using namespace Enigma;
+
+namespace
+{
+    /* Sum of n * (n - 1) over letter counts. */
+    inline uint64_t CoincidenceSum(const uint32_t* counts) noexcept
+    {
+        uint64_t sum = 0;
+        for (int i = 0; i < CompiledKey::alphabetLength; i++)
+            sum += (uint64_t)counts[i] * ((uint64_t)counts[i] - 1);
+        return sum;
+    }
+
+    /**
+     * True if the index of coincidence of @n letters with @counts is more than @deviations standard errors below @threshold.
+     * The index is a U-statistic of the letter frequencies p, its variance is
+     * (4 (n - 2) (sum p^3 - (sum p^2)^2) + 2 sum p^2 (1 - sum p^2)) / (n (n - 1)), with sums estimated from the counts.
+     */
+    inline bool BelowThreshold(const uint32_t* counts, size_t n, double threshold, double deviations) noexcept
+    {
+        const double pairs = (double)n * (n - 1);
+        const double p2 = (double)CoincidenceSum(counts) / pairs;
+        const double margin = threshold - p2, limit = deviations * deviations / pairs;
+        // The second term alone is a lower bound of the variance, most keys are kept or dropped without the third moment.
+        if (margin <= 0 || margin * margin <= limit * 2.0 * p2 * (1 - p2))
+            return false;
+        uint64_t triples = 0;
+        for (int i = 0; i < CompiledKey::alphabetLength; i++)
+            triples += (uint64_t)counts[i] * ((uint64_t)counts[i] - 1) * ((uint64_t)counts[i] - 2);
+        const double p3 = n > 2 ? (double)triples / (pairs * (n - 2)) : 0;
+        return margin * margin > limit * (4.0 * (n - 2) * std::max(0.0, p3 - p2 * p2) + 2.0 * p2 * (1 - p2));
+    }
+
+    /**
+     * Decrypts the text from state @start and computes its index of coincidence.
+     * States are stepped through @next and mapped through @remap to the state of the permutation if given.
+     * Returns false if the key was dropped at @checkpoint because its partial index was clearly below @threshold.
+     */
+    template <bool Remapped>
+    inline bool Score(const KeystreamTable& table, const uint16_t* next, const uint16_t* remap, const uint8_t* text, size_t length,
+                      size_t checkpoint, double threshold, double deviations, int start, double& ioc) noexcept
+    {
+        uint32_t counts[CompiledKey::alphabetLength] = {0};
+        int state = start;
+        size_t i = 0;
+        if (checkpoint)
+        {
+            for (; i < checkpoint; i++)
+            {
+                state = next[state];
+                counts[table.getPermutation(Remapped ? remap[state] : state)[text[i]]]++;
+            }
+            if (BelowThreshold(counts, checkpoint, threshold, deviations))
+                return false;
+        }
+        for (; i < length; i++)
+        {
+            state = next[state];
+            counts[table.getPermutation(Remapped ? remap[state] : state)[text[i]]]++;
+        }
+        ioc = length < 2 ? 0 : (double)CoincidenceSum(counts) / ((double)length * (length - 1));
+        return true;
+    }
+}
+
+std::vector<std::array<RotorID, 3>> IocSearch::WheelOrders() noexcept
+{
+    std::vector<std::array<RotorID, 3>> orders;
+    for (int l = I; l <= V; l++)
+        for (int m = I; m <= V; m++)
+            for (int r = I; r <= V; r++)
+                if (l != m && m != r && l != r)
+                    orders.push_back({{(RotorID)l, (RotorID)m, (RotorID)r}});
+    return orders;
+}
+
+double IocSearch::IndexOfCoincidence(const uint8_t* text, size_t length) noexcept
+{
+    if (length < 2)
+        return 0;
+    uint32_t counts[CompiledKey::alphabetLength] = {0};
+    for (size_t i = 0; i < length; i++)
+        counts[text[i]]++;
+    return (double)CoincidenceSum(counts) / ((double)length * (length - 1));
+}
+
+IocSearchResult IocSearch::Run(const std::string& cipherText, const IocSearchOptions& options, ThreadPool& pool) noexcept
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    std::vector<uint8_t> text = CompiledKey::ToIndices(cipherText);
+    const size_t length = text.size();
+    const size_t checkpoint = (size_t)(length * options.AbortFraction);
+    const bool abortEnabled = options.AbortDeviations > 0 && checkpoint >= 2 && checkpoint < length;
+
+    RingClasses classes(length);
+    const uint64_t keysPerTask = options.SearchRings ? (uint64_t)KeystreamTable::numberOfStates * classes.size() : KeystreamTable::numberOfStates;
+
+    std::vector<std::array<RotorID, 3>> orders = options.WheelOrders.empty() ? WheelOrders() : options.WheelOrders;
+    const size_t tasks = options.Reflectors.size() * orders.size();
+
+    // One heap per task keeps the result independent of scheduling.
+    std::vector<CandidateHeap> heaps(tasks, CandidateHeap(options.TopK));
+    std::atomic<uint64_t> aborted(0);
+
+    pool.ParallelFor(tasks, [&](size_t t) {
+        ReflectorID reflector = options.Reflectors[t / orders.size()];
+        const std::array<RotorID, 3>& order = orders[t % orders.size()];
+
+        uint8_t plugboard[CompiledKey::alphabetLength];
+        for (int i = 0; i < CompiledKey::alphabetLength; i++)
+            plugboard[i] = (uint8_t)i;
+        std::array<int, 3> rings = options.SearchRings ? std::array<int, 3>{{0, 0, 0}} : options.Rings;
+        CompiledKey key(reflector, order, rings, plugboard);
+        KeystreamTable table{key};
+        std::vector<uint16_t> next = table.NextStates();
+
+        CandidateHeap& heap = heaps[t];
+        uint64_t localAborted = 0;
+        auto test = [&](const uint16_t* remap, const RotorPositions& positions, const std::array<int, 3>& keyRings) {
+            size_t used = abortEnabled && heap.isFull() ? checkpoint : 0;
+            double threshold = heap.getThreshold(), ioc = 0;
+            int start = KeystreamTable::StateIndex(positions);
+            bool scored = remap ? Score<true>(table, next.data(), remap, text.data(), length, used, threshold, options.AbortDeviations, start, ioc)
+                                : Score<false>(table, next.data(), nullptr, text.data(), length, used, threshold, options.AbortDeviations, start, ioc);
+            if (!scored)
+                localAborted++;
+            else if (!heap.isFull() || ioc >= heap.getThreshold())
+            {
+                KeyCandidate candidate;
+                candidate.Score = ioc;
+                candidate.Reflector = reflector;
+                candidate.Rotors = order;
+                candidate.Rings = keyRings;
+                candidate.Positions = positions;
+                heap.Push(candidate);
+            }
+        };
+
+        if (!options.SearchRings)
+        {
+            for (int start = 0; start < KeystreamTable::numberOfStates; start++)
+                test(nullptr, {{start / 676, start / 26 % 26, start % 26}}, rings);
+        }
+        else
+        {
+            // The table is built with rings AAA, so its states are core offsets and its stepping is that of the windows.
+            // Left ring is always A, every middle and right ring is paired with the representative windows.
+            const int* notches = key.getNotches();
+            std::vector<uint16_t> remap(KeystreamTable::numberOfStates);
+            for (int ringMiddle = 0; ringMiddle < CompiledKey::alphabetLength; ringMiddle++)
+                for (int ringRight = 0; ringRight < CompiledKey::alphabetLength; ringRight++)
+                {
+                    for (int state = 0; state < KeystreamTable::numberOfStates; state++)
+                        remap[state] = (uint16_t)KeystreamTable::StateIndex({{state / 676, (state / 26 % 26 + 26 - ringMiddle) % 26, (state % 26 + 26 - ringRight) % 26}});
+                    std::array<int, 3> keyRings = {{0, ringMiddle, ringRight}};
+                    for (const std::array<int, 2>& rep : classes.getRepresentatives())
+                    {
+                        int middle = (notches[1] - rep[1] + 26) % 26, right = (notches[2] - rep[0] + 26) % 26;
+                        for (int left = 0; left < CompiledKey::alphabetLength; left++)
+                            test(remap.data(), {{left, middle, right}}, keyRings);
+                    }
+                }
+        }
+        aborted += localAborted;
+    });
+
+    CandidateHeap best(options.TopK);
+    for (const CandidateHeap& heap : heaps)
+        best.Merge(heap);
+
+    IocSearchResult res;
+    res.Candidates = best.Sorted();
+    res.KeysTested = (uint64_t)tasks * keysPerTask;
+    res.KeysCovered = (uint64_t)tasks * KeystreamTable::numberOfStates * (options.SearchRings ? RingClasses::settingsPerOffset : 1);
+    res.KeysAborted = aborted;
+    res.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return res;
+}
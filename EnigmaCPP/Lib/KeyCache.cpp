@@ -0,0 +1,111 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "KeyCache.h"
+
+#include <functional>
+
+using namespace Enigma;
+
+namespace
+{
+    /* Heap bytes of a string, 0 if it is stored inside the object (short string optimization). */
+    size_t HeapBytes(const std::string& text) noexcept
+    {
+        const char* object = reinterpret_cast<const char*>(&text);
+        return text.data() >= object && text.data() < object + sizeof(text) ? 0 : text.capacity() + 1;
+    }
+}
+
+KeyCache::KeyCache(size_t MemoryBudget, int NumberOfShards) noexcept : Hits(0), Misses(0), Evictions(0)
+{
+    if (NumberOfShards < 1)
+        NumberOfShards = 1;
+    ShardBudget = MemoryBudget / NumberOfShards;
+    for (int i = 0; i < NumberOfShards; i++)
+        Shards.emplace_back(new Shard());
+}
+
+std::shared_ptr<const CompiledKey> KeyCache::Get(const UserSettings& USettings)
+{
+    std::string form = CompiledKey::CanonicalForm(USettings);
+    Shard& shard = *Shards[std::hash<std::string>()(form) % Shards.size()];
+
+    {
+        std::lock_guard<std::mutex> guard(shard.Lock);
+        auto it = shard.Index.find(form);
+        if (it != shard.Index.end())
+        {
+            // Rotors position is not part of the canonical form, but still has to be valid.
+            CompiledKey::PositionsOf(USettings);
+            shard.Lru.splice(shard.Lru.begin(), shard.Lru, it->second);
+            Hits++;
+            return it->second->second;
+        }
+    }
+
+    // Compilation happens outside of the lock, other threads can use the shard meanwhile.
+    std::shared_ptr<const CompiledKey> key = std::make_shared<const CompiledKey>(USettings);
+    Misses++;
+
+    std::lock_guard<std::mutex> guard(shard.Lock);
+    auto it = shard.Index.find(form);
+    if (it != shard.Index.end())
+    {
+        // Another thread compiled the same key in the meantime.
+        shard.Lru.splice(shard.Lru.begin(), shard.Lru, it->second);
+        return it->second->second;
+    }
+
+    shard.Lru.emplace_front(form, key);
+    auto indexed = shard.Index.emplace(form, shard.Lru.begin()).first;
+    shard.Bytes += EntryBytes(shard.Lru.front().first, indexed->first, *key);
+
+    // The most recent key always stays, even if it alone exceeds the budget.
+    while (shard.Bytes > ShardBudget && shard.Lru.size() > 1)
+    {
+        auto& victim = shard.Lru.back();
+        auto indexed = shard.Index.find(victim.first);
+        shard.Bytes -= EntryBytes(victim.first, indexed->first, *victim.second);
+        shard.Index.erase(indexed);
+        shard.Lru.pop_back();
+        Evictions++;
+    }
+    return key;
+}
+
+size_t KeyCache::EntryBytes(const std::string& listForm, const std::string& indexForm, const CompiledKey& key) noexcept
+{
+    typedef decltype(Shard::Lru)::value_type ListEntry;
+    typedef decltype(Shard::Index)::value_type IndexEntry;
+    // make_shared puts the key and the control block (vtable pointer, two counts) in one allocation.
+    const size_t keyBytes = key.MemoryFootprint() + sizeof(void*) + 2 * sizeof(int);
+    // A list node links both ways, an index node links forward and caches the hash; one bucket per entry at load factor 1.
+    const size_t nodeBytes = sizeof(ListEntry) + 2 * sizeof(void*) + sizeof(IndexEntry) + sizeof(void*) + sizeof(size_t) + sizeof(void*);
+    return keyBytes + nodeBytes + HeapBytes(listForm) + HeapBytes(indexForm);
+}
+
+KeyCacheStats KeyCache::getStats() const noexcept
+{
+    KeyCacheStats stats = {Hits.load(), Misses.load(), Evictions.load(), 0, 0};
+    for (const auto& shard : Shards)
+    {
+        std::lock_guard<std::mutex> guard(shard->Lock);
+        stats.Entries += shard->Lru.size();
+        stats.Bytes += shard->Bytes;
+    }
+    return stats;
+}
+
+void KeyCache::Clear() noexcept
+{
+    for (auto& shard : Shards)
+    {
+        std::lock_guard<std::mutex> guard(shard->Lock);
+        shard->Index.clear();
+        shard->Lru.clear();
+        shard->Bytes = 0;
+    }
+}
@@ -0,0 +1,320 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "KeySheet.h"
+#include "MappedFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using namespace Enigma;
+
+namespace
+{
+    /* Magic of the binary format. */
+    const char binaryMagic[4] = {'E', 'K', 'S', 'B'};
+
+    /* Header of the binary format. */
+    struct BinaryHeader
+    {
+        char Magic[4];
+        uint32_t Version;
+        uint64_t Count;
+    };
+
+    /* Minimal amount of text parsed by a single task. */
+    const size_t minChunkSize = 64 * 1024;
+
+    /* Skips spaces and tabs. */
+    inline const char* SkipBlanks(const char* it, const char* end) noexcept
+    {
+        while (it != end && (*it == ' ' || *it == '\t' || *it == '\r'))
+            it++;
+        return it;
+    }
+
+    /* Returns end of the token starting at @it. */
+    inline const char* TokenEnd(const char* it, const char* end) noexcept
+    {
+        while (it != end && *it != ' ' && *it != '\t' && *it != '\r')
+            it++;
+        return it;
+    }
+
+    /* Converts a token to RotorID, returns -1 if it is not "I" - "V". */
+    inline int ParseRotor(const char* tok, size_t len) noexcept
+    {
+        static const char* names[5] = {"I", "II", "III", "IV", "V"};
+        for (int i = 0; i < 5; i++)
+            if (std::strlen(names[i]) == len && std::memcmp(names[i], tok, len) == 0)
+                return i;
+        return -1;
+    }
+
+    /* Converts a token to ReflectorID, returns -1 if it is not "ETW", "B" or "C". */
+    inline int ParseReflector(const char* tok, size_t len) noexcept
+    {
+        if (len == 3 && std::memcmp(tok, "ETW", 3) == 0)
+            return ETW;
+        if (len == 1 && tok[0] == 'B')
+            return B;
+        if (len == 1 && tok[0] == 'C')
+            return C;
+        return -1;
+    }
+
+    /* Converts a letter to an alphabet index, returns 255 if it is not an uppercase letter. */
+    inline uint8_t ParseLetter(char c) noexcept
+    {
+        return (c >= 'A' && c <= 'Z') ? (uint8_t)(c - 'A') : 255;
+    }
+}
+
+const char* KeySheet::Validate(const KeySheetRecord& Record) noexcept
+{
+    if (Record.Reflector > C)
+        return "Invalid reflector.";
+
+    unsigned rotorsMask = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        if (Record.Rotors[i] > V)
+            return "Invalid rotor.";
+        if (rotorsMask & (1u << Record.Rotors[i]))
+            return "Rotor used more than once.";
+        rotorsMask |= 1u << Record.Rotors[i];
+        if (Record.Positions[i] >= CompiledKey::alphabetLength || Record.Rings[i] >= CompiledKey::alphabetLength)
+            return "Invalid rotor position or ring setting.";
+    }
+
+    if (Record.NumberOfPlugs > 13)
+        return "Too many connections.";
+    uint32_t plugsMask = 0;
+    for (int i = 0; i < Record.NumberOfPlugs; i++)
+    {
+        uint8_t a = Record.Plugs[2 * i], b = Record.Plugs[2 * i + 1];
+        if (a >= CompiledKey::alphabetLength || b >= CompiledKey::alphabetLength)
+            return "Invalid connection.";
+        if (a == b)
+            return "Letter connected to itself.";
+        uint32_t pair = (1u << a) | (1u << b);
+        if (plugsMask & pair)
+            return "Connection already used.";
+        plugsMask |= pair;
+    }
+    return nullptr;
+}
+
+const char* KeySheet::ParseLine(const char* begin, const char* end, KeySheetRecord& record) noexcept
+{
+    std::memset(&record, 0, sizeof(record));
+    int field = 0;
+    const char* it = SkipBlanks(begin, end);
+    while (it != end)
+    {
+        const char* tokEnd = TokenEnd(it, end);
+        size_t len = tokEnd - it;
+        if (field == 0)
+        {
+            int ref = ParseReflector(it, len);
+            if (ref < 0)
+                return "Invalid reflector.";
+            record.Reflector = (uint8_t)ref;
+        }
+        else if (field <= 3)
+        {
+            int rot = ParseRotor(it, len);
+            if (rot < 0)
+                return "Invalid rotor.";
+            record.Rotors[field - 1] = (uint8_t)rot;
+        }
+        else if (field <= 9)
+        {
+            uint8_t letter = ParseLetter(*it);
+            if (len != 1 || letter == 255)
+                return "Invalid rotor position or ring setting.";
+            if (field <= 6)
+                record.Positions[field - 4] = letter;
+            else
+                record.Rings[field - 7] = letter;
+        }
+        else
+        {
+            if (record.NumberOfPlugs == 13)
+                return "Too many connections.";
+            if (len != 2 || ParseLetter(it[0]) == 255 || ParseLetter(it[1]) == 255)
+                return "Invalid connection.";
+            record.Plugs[2 * record.NumberOfPlugs] = ParseLetter(it[0]);
+            record.Plugs[2 * record.NumberOfPlugs + 1] = ParseLetter(it[1]);
+            record.NumberOfPlugs++;
+        }
+        field++;
+        it = SkipBlanks(tokEnd, end);
+    }
+    if (field < 10)
+        return "Missing fields.";
+    return Validate(record);
+}
+
+void KeySheet::Append(const KeySheetRecord& record, size_t line) noexcept
+{
+    uint8_t plugboard[CompiledKey::alphabetLength];
+    for (int i = 0; i < CompiledKey::alphabetLength; i++)
+        plugboard[i] = (uint8_t)i;
+    for (int i = 0; i < record.NumberOfPlugs; i++)
+    {
+        plugboard[record.Plugs[2 * i]] = record.Plugs[2 * i + 1];
+        plugboard[record.Plugs[2 * i + 1]] = record.Plugs[2 * i];
+    }
+
+    std::array<RotorID, 3> rotors = {(RotorID)record.Rotors[0], (RotorID)record.Rotors[1], (RotorID)record.Rotors[2]};
+    std::array<int, 3> rings = {record.Rings[0], record.Rings[1], record.Rings[2]};
+    Records.push_back(record);
+    Keys.emplace_back((ReflectorID)record.Reflector, rotors, rings, plugboard);
+    Positions.push_back({record.Positions[0], record.Positions[1], record.Positions[2]});
+    Lines.push_back(line);
+}
+
+KeySheet KeySheet::Join(std::vector<KeySheet>& parts, const std::vector<size_t>& lineOffsets) noexcept
+{
+    KeySheet res;
+    size_t valid = 0, invalid = 0;
+    for (const KeySheet& part : parts)
+    {
+        valid += part.Keys.size();
+        invalid += part.Errors.size();
+    }
+    res.Records.reserve(valid);
+    res.Keys.reserve(valid);
+    res.Positions.reserve(valid);
+    res.Lines.reserve(valid);
+    res.Errors.reserve(invalid);
+
+    for (size_t p = 0; p < parts.size(); p++)
+    {
+        KeySheet& part = parts[p];
+        res.Records.insert(res.Records.end(), part.Records.begin(), part.Records.end());
+        res.Keys.insert(res.Keys.end(), part.Keys.begin(), part.Keys.end());
+        res.Positions.insert(res.Positions.end(), part.Positions.begin(), part.Positions.end());
+        for (size_t line : part.Lines)
+            res.Lines.push_back(line + lineOffsets[p]);
+        for (const KeySheetError& err : part.Errors)
+            res.Errors.push_back({err.Line + lineOffsets[p], err.Reason});
+        part = KeySheet();
+    }
+    return res;
+}
+
+KeySheet KeySheet::ParseText(const char* Data, size_t Length, ThreadPool& Pool) noexcept
+{
+    // Text is split into chunks ending right after a new line character.
+    size_t numberOfChunks = Length / minChunkSize + 1;
+    size_t maxChunks = (size_t)Pool.getSize() * 8;
+    if (numberOfChunks > maxChunks)
+        numberOfChunks = maxChunks;
+
+    std::vector<size_t> bounds(1, 0);
+    for (size_t i = 1; i < numberOfChunks; i++)
+    {
+        size_t pos = Length / numberOfChunks * i;
+        if (pos < bounds.back())
+            pos = bounds.back();
+        const void* nl = std::memchr(Data + pos, '\n', Length - pos);
+        pos = nl ? (const char*)nl - Data + 1 : Length;
+        bounds.push_back(pos);
+    }
+    bounds.push_back(Length);
+    numberOfChunks = bounds.size() - 1;
+
+    std::vector<KeySheet> parts(numberOfChunks);
+    std::vector<size_t> lineCounts(numberOfChunks, 0);
+    Pool.ParallelFor(numberOfChunks, [&](size_t c) {
+        const char* it = Data + bounds[c];
+        const char* end = Data + bounds[c + 1];
+        size_t line = 0;
+        KeySheetRecord record;
+        while (it < end)
+        {
+            const char* nl = (const char*)std::memchr(it, '\n', end - it);
+            const char* lineEnd = nl ? nl : end;
+            line++;
+            const char* first = SkipBlanks(it, lineEnd);
+            if (first != lineEnd && *first != '#')
+            {
+                const char* reason = ParseLine(first, lineEnd, record);
+                if (reason == nullptr)
+                    parts[c].Append(record, line);
+                else
+                    parts[c].Errors.push_back({line, reason});
+            }
+            it = lineEnd + 1;
+        }
+        lineCounts[c] = line;
+    });
+
+    std::vector<size_t> lineOffsets(numberOfChunks, 0);
+    for (size_t c = 1; c < numberOfChunks; c++)
+        lineOffsets[c] = lineOffsets[c - 1] + lineCounts[c - 1];
+    return Join(parts, lineOffsets);
+}
+
+KeySheet KeySheet::ParseBinary(const KeySheetRecord* Records, size_t Count, ThreadPool& Pool) noexcept
+{
+    size_t recordsPerChunk = minChunkSize / sizeof(KeySheetRecord);
+    size_t numberOfChunks = (Count + recordsPerChunk - 1) / recordsPerChunk;
+    std::vector<KeySheet> parts(numberOfChunks);
+    std::vector<size_t> lineOffsets(numberOfChunks);
+    for (size_t c = 0; c < numberOfChunks; c++)
+        lineOffsets[c] = c * recordsPerChunk;
+
+    Pool.ParallelFor(numberOfChunks, [&](size_t c) {
+        size_t first = c * recordsPerChunk;
+        size_t last = first + recordsPerChunk < Count ? first + recordsPerChunk : Count;
+        for (size_t i = first; i < last; i++)
+        {
+            // Records may be unaligned in the mapping.
+            KeySheetRecord record;
+            std::memcpy(&record, Records + i, sizeof(record));
+            const char* reason = Validate(record);
+            if (reason == nullptr)
+                parts[c].Append(record, i - first + 1);
+            else
+                parts[c].Errors.push_back({i - first + 1, reason});
+        }
+    });
+    return Join(parts, lineOffsets);
+}
+
+KeySheet KeySheet::Load(const std::string& FilePath, ThreadPool& Pool)
+{
+    MappedFile file(FilePath);
+    if (file.getSize() >= sizeof(BinaryHeader) && std::memcmp(file.getData(), binaryMagic, sizeof(binaryMagic)) == 0)
+    {
+        BinaryHeader header;
+        std::memcpy(&header, file.getData(), sizeof(header));
+        if (header.Version != binaryVersion)
+            throw std::runtime_error("Unsupported key sheet version.");
+        if (header.Count > (file.getSize() - sizeof(header)) / sizeof(KeySheetRecord))
+            throw std::runtime_error("Truncated key sheet.");
+        return ParseBinary(reinterpret_cast<const KeySheetRecord*>(file.getData() + sizeof(header)), header.Count, Pool);
+    }
+    return ParseText(file.getData(), file.getSize(), Pool);
+}
+
+void KeySheet::SaveBinary(const std::string& FilePath) const
+{
+    std::ofstream out(FilePath, std::ios::binary);
+    if (!out.good())
+        throw std::runtime_error("Error while writing to a file.");
+    BinaryHeader header;
+    std::memcpy(header.Magic, binaryMagic, sizeof(binaryMagic));
+    header.Version = binaryVersion;
+    header.Count = Records.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(Records.data()), Records.size() * sizeof(KeySheetRecord));
+    if (!out.good())
+        throw std::runtime_error("Error while writing to a file.");
+}
@@ -0,0 +1,237 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "CompiledKey.h"
+#include "ThreadPool.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Enigma
+{
+    /**
+     * Single key sheet entry in compact form. It is also the record of the binary key sheet format.
+     * Letters are stored as alphabet indices (A -> 0 ... Z -> 25).
+     */
+    struct KeySheetRecord
+    {
+        /* ReflectorID. */
+        uint8_t Reflector;
+
+        /* RotorIDs from left to right. */
+        uint8_t Rotors[3];
+
+        /* Initial positions from left to right. */
+        uint8_t Positions[3];
+
+        /* Ring settings from left to right. */
+        uint8_t Rings[3];
+
+        /* Number of used pairs in @Plugs. */
+        uint8_t NumberOfPlugs;
+
+        /* Plugboard connections, two letters per connection. */
+        uint8_t Plugs[26];
+
+        /* Unused, should be zero. */
+        uint8_t Reserved[3];
+    };
+
+    static_assert(sizeof(KeySheetRecord) == 40, "KeySheetRecord must be 40 bytes.");
+
+    /* Invalid key sheet entry. */
+    struct KeySheetError
+    {
+        /* Line number (text) or record number (binary), counted from 1. */
+        size_t Line;
+
+        /* Reason of rejection. */
+        const char* Reason;
+    };
+
+    /**
+     * Key sheet loaded in bulk.
+     *
+     * Text format: one key per line, same order as CLI arguments, e.g. "B I II III C B D F G D AZ BC".
+     * Empty lines and lines starting with '#' are skipped.
+     * Binary format: "EKSB" magic, uint32 version, uint64 number of records, then KeySheetRecords.
+     *
+     * Entries are validated with bitmasks, without exceptions: unknown reflector or rotor,
+     * repeated rotor, invalid letter, more than 13 connections, repeated plug and self-plug are rejected.
+     * Valid entries are compiled to a dense array of keys, in file order.
+     */
+    class KeySheet
+    {
+    public:
+        /* Version of the binary format. */
+        static const uint32_t binaryVersion = 1;
+
+        /**
+         * Maps and parses a key sheet file, text or binary (detected by the magic).
+         *
+         * Params:
+         * const std::string& FilePath - path of the key sheet.
+         * ThreadPool& Pool - threads used for parsing and compilation.
+         *
+         * Exceptions:
+         * If the file cannot be read or binary header is invalid, an exception will be thrown.
+         * Invalid entries do not cause exceptions, see getErrors().
+         *
+         * Returns:
+         * KeySheet - loaded key sheet.
+         */
+        static KeySheet Load(const std::string& FilePath, ThreadPool& Pool) noexcept(false);
+
+        /**
+         * Parses a key sheet in text format.
+         *
+         * Params:
+         * const char* Data - text.
+         * size_t Length - length of the text.
+         * ThreadPool& Pool - threads used for parsing and compilation.
+         *
+         * Returns:
+         * KeySheet - parsed key sheet.
+         */
+        static KeySheet ParseText(const char* Data, size_t Length, ThreadPool& Pool) noexcept;
+
+        /**
+         * Validates and compiles records of a binary key sheet.
+         *
+         * Params:
+         * const KeySheetRecord* Records - records.
+         * size_t Count - number of records.
+         * ThreadPool& Pool - threads used for compilation.
+         *
+         * Returns:
+         * KeySheet - parsed key sheet.
+         */
+        static KeySheet ParseBinary(const KeySheetRecord* Records, size_t Count, ThreadPool& Pool) noexcept;
+
+        /**
+         * Checks a record.
+         *
+         * Params:
+         * const KeySheetRecord& Record - record to be checked.
+         *
+         * Returns:
+         * const char* - reason of rejection, nullptr if the record is valid.
+         */
+        static const char* Validate(const KeySheetRecord& Record) noexcept;
+
+        /**
+         * Writes valid entries in binary format.
+         *
+         * Params:
+         * const std::string& FilePath - output path.
+         *
+         * Exceptions:
+         * If the file cannot be written, an exception will be thrown.
+         */
+        void SaveBinary(const std::string& FilePath) const noexcept(false);
+
+        /**
+         * Returns number of valid entries.
+         *
+         * Returns:
+         * size_t - number of valid entries.
+         */
+        size_t size() const noexcept { return Keys.size(); }
+
+        /**
+         * Returns compiled keys of valid entries.
+         *
+         * Returns:
+         * const std::vector<CompiledKey>& - keys in file order.
+         */
+        const std::vector<CompiledKey>& getKeys() const noexcept { return Keys; }
+
+        /**
+         * Returns initial positions of valid entries.
+         *
+         * Returns:
+         * const std::vector<RotorPositions>& - positions, same order as getKeys().
+         */
+        const std::vector<RotorPositions>& getPositions() const noexcept { return Positions; }
+
+        /**
+         * Returns line (or record) numbers of valid entries.
+         *
+         * Returns:
+         * const std::vector<size_t>& - line numbers, same order as getKeys().
+         */
+        const std::vector<size_t>& getLines() const noexcept { return Lines; }
+
+        /**
+         * Returns valid entries in compact form.
+         *
+         * Returns:
+         * const std::vector<KeySheetRecord>& - records, same order as getKeys().
+         */
+        const std::vector<KeySheetRecord>& getRecords() const noexcept { return Records; }
+
+        /**
+         * Returns rejected entries.
+         *
+         * Returns:
+         * const std::vector<KeySheetError>& - errors ordered by line number.
+         */
+        const std::vector<KeySheetError>& getErrors() const noexcept { return Errors; }
+
+    private:
+        /* Valid entries in compact form. */
+        std::vector<KeySheetRecord> Records;
+
+        /* Compiled keys of valid entries. */
+        std::vector<CompiledKey> Keys;
+
+        /* Initial positions of valid entries. */
+        std::vector<RotorPositions> Positions;
+
+        /* Line numbers of valid entries. */
+        std::vector<size_t> Lines;
+
+        /* Rejected entries. */
+        std::vector<KeySheetError> Errors;
+
+        /**
+         * Parses a single line of text.
+         *
+         * Params:
+         * const char* begin - first character of the line.
+         * const char* end - end of the line (without the new line character).
+         * KeySheetRecord& record - parsed record.
+         *
+         * Returns:
+         * const char* - reason of rejection, nullptr if the line is valid.
+         */
+        static const char* ParseLine(const char* begin, const char* end, KeySheetRecord& record) noexcept;
+
+        /**
+         * Appends a valid record with its compiled key.
+         *
+         * Params:
+         * const KeySheetRecord& record - valid record.
+         * size_t line - line number.
+         */
+        void Append(const KeySheetRecord& record, size_t line) noexcept;
+
+        /**
+         * Concatenates parts in order, shifting their line numbers.
+         *
+         * Params:
+         * std::vector<KeySheet>& parts - parts in order.
+         * const std::vector<size_t>& lineOffsets - number of lines preceding every part.
+         *
+         * Returns:
+         * KeySheet - joined key sheet.
+         */
+        static KeySheet Join(std::vector<KeySheet>& parts, const std::vector<size_t>& lineOffsets) noexcept;
+    };
+}
@@ -0,0 +1,250 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "Keyspace.h"
+#include "IocSearch.h"
+#include "SettingsConversion.h"
+
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace Enigma;
+
+namespace
+{
+    const int alphabetLength = CompiledKey::alphabetLength;
+
+    /* Dimensions in the order of the index, the last one is the fastest. */
+    enum Dimension { DReflector, DWheelOrder, DPlugboard, DRingLeft, DRingMiddle, DRingRight, DPositionLeft, DPositionMiddle, DPositionRight };
+
+    /* Converts plugboard connections to 26 alphabet indices, validated by SettingsConversion. */
+    std::array<uint8_t, alphabetLength> ToWiring(const std::vector<std::string>& connections)
+    {
+        std::vector<UserRotor> rotors = {UserRotor(I, 'A', 'A'), UserRotor(II, 'A', 'A'), UserRotor(III, 'A', 'A')};
+        std::unordered_map<char, char> map = SettingsConversion::ConvertToEnigmaSettings(UserSettings(B, rotors, connections)).getConnections();
+        std::array<uint8_t, alphabetLength> wiring;
+        for (int i = 0; i < alphabetLength; i++)
+            wiring[i] = (uint8_t)(map['A' + i] - 'A');
+        return wiring;
+    }
+}
+
+std::vector<int> KeyspaceOptions::AllLetters() noexcept
+{
+    std::vector<int> letters;
+    for (int i = 0; i < alphabetLength; i++)
+        letters.push_back(i);
+    return letters;
+}
+
+Keyspace::Keyspace(const KeyspaceOptions& Options) : Options(Options)
+{
+    if (this->Options.WheelOrders.empty())
+        this->Options.WheelOrders = IocSearch::WheelOrders();
+
+    for (const std::vector<std::string>& plugboard : this->Options.Plugboards)
+        PlugboardWirings.push_back(ToWiring(plugboard));
+
+    Radices[DReflector] = this->Options.Reflectors.size();
+    Radices[DWheelOrder] = this->Options.WheelOrders.size();
+    Radices[DPlugboard] = this->Options.Plugboards.size();
+    for (int i = 0; i < 3; i++)
+    {
+        Radices[DRingLeft + i] = this->Options.Rings[i].size();
+        Radices[DPositionLeft + i] = this->Options.Positions[i].size();
+    }
+
+    for (int d = 0; d < 6; d++)
+    {
+        const std::vector<int>& values = d < 3 ? this->Options.Rings[d] : this->Options.Positions[d - 3];
+        LetterIndices[d].fill(-1);
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            if (values[i] < 0 || values[i] >= alphabetLength)
+                throw std::runtime_error("Invalid ring setting or position.");
+            if (LetterIndices[d][values[i]] != -1)
+                throw std::runtime_error("Repeated ring setting or position.");
+            LetterIndices[d][values[i]] = (int)i;
+        }
+    }
+    for (size_t i = 0; i < this->Options.WheelOrders.size(); i++)
+    {
+        const std::array<RotorID, 3>& order = this->Options.WheelOrders[i];
+        for (int r = 0; r < 3; r++)
+            if (order[r] < I || order[r] > V || order[r] == order[(r + 1) % 3])
+                throw std::runtime_error("Invalid wheel order.");
+        for (size_t j = 0; j < i; j++)
+            if (this->Options.WheelOrders[i] == this->Options.WheelOrders[j])
+                throw std::runtime_error("Repeated wheel order.");
+    }
+    for (size_t i = 0; i < this->Options.Reflectors.size(); i++)
+        for (size_t j = 0; j < i; j++)
+            if (this->Options.Reflectors[i] == this->Options.Reflectors[j])
+                throw std::runtime_error("Repeated reflector.");
+
+    Size = 1;
+    for (int d = numberOfDimensions - 1; d >= 0; d--)
+    {
+        if (Radices[d] == 0)
+            throw std::runtime_error("Empty keyspace dimension.");
+        Strides[d] = Size;
+        if (Size > UINT64_MAX / Radices[d])
+            throw std::runtime_error("Keyspace too large.");
+        Size *= Radices[d];
+    }
+}
+
+void Keyspace::SetDimension(KeyspaceKey& key, int dimension, uint32_t digit) const noexcept
+{
+    switch (dimension)
+    {
+    case DReflector:
+        key.Reflector = Options.Reflectors[digit];
+        break;
+    case DWheelOrder:
+        key.Rotors = Options.WheelOrders[digit];
+        break;
+    case DPlugboard:
+        key.Plugboard = digit;
+        break;
+    case DRingLeft:
+    case DRingMiddle:
+    case DRingRight:
+        key.Rings[dimension - DRingLeft] = Options.Rings[dimension - DRingLeft][digit];
+        break;
+    default:
+        key.Positions[dimension - DPositionLeft] = Options.Positions[dimension - DPositionLeft][digit];
+        break;
+    }
+}
+
+KeyspaceKey Keyspace::Unrank(uint64_t index) const noexcept
+{
+    KeyspaceKey key;
+    for (int d = 0; d < numberOfDimensions; d++)
+        SetDimension(key, d, (uint32_t)(index / Strides[d] % Radices[d]));
+    return key;
+}
+
+uint64_t Keyspace::Rank(const KeyspaceKey& key) const
+{
+    std::array<uint64_t, numberOfDimensions> digits;
+    digits[DReflector] = Radices[DReflector];
+    for (size_t i = 0; i < Options.Reflectors.size(); i++)
+        if (Options.Reflectors[i] == key.Reflector)
+            digits[DReflector] = i;
+    digits[DWheelOrder] = Radices[DWheelOrder];
+    for (size_t i = 0; i < Options.WheelOrders.size(); i++)
+        if (Options.WheelOrders[i] == key.Rotors)
+            digits[DWheelOrder] = i;
+    digits[DPlugboard] = key.Plugboard;
+    for (int i = 0; i < 3; i++)
+    {
+        int ring = key.Rings[i], position = key.Positions[i];
+        digits[DRingLeft + i] = ring >= 0 && ring < alphabetLength && LetterIndices[i][ring] >= 0 ? LetterIndices[i][ring] : Radices[DRingLeft + i];
+        digits[DPositionLeft + i] = position >= 0 && position < alphabetLength && LetterIndices[3 + i][position] >= 0 ? LetterIndices[3 + i][position] : Radices[DPositionLeft + i];
+    }
+
+    uint64_t index = 0;
+    for (int d = 0; d < numberOfDimensions; d++)
+    {
+        if (digits[d] >= Radices[d])
+            throw std::runtime_error("Key out of the keyspace.");
+        index += digits[d] * Strides[d];
+    }
+    return index;
+}
+
+uint64_t Keyspace::Rank(const UserSettings& settings) const
+{
+    std::vector<UserRotor> rotors = settings.getRotors();
+    if (rotors.size() != 3)
+        throw std::runtime_error("Key out of the keyspace.");
+    std::array<uint8_t, alphabetLength> wiring = ToWiring(settings.getPlugboardConnections());
+
+    KeyspaceKey key;
+    key.Reflector = settings.getReflectorID();
+    key.Plugboard = PlugboardWirings.size();
+    for (size_t i = 0; i < PlugboardWirings.size(); i++)
+        if (PlugboardWirings[i] == wiring)
+            key.Plugboard = i;
+    for (int i = 0; i < 3; i++)
+    {
+        key.Rotors[i] = rotors[i].getID();
+        key.Rings[i] = rotors[i].getRing() - 'A';
+        key.Positions[i] = rotors[i].getPosition() - 'A';
+    }
+    return Rank(key);
+}
+
+UserSettings Keyspace::ToUserSettings(const KeyspaceKey& key) const noexcept
+{
+    std::vector<UserRotor> rotors;
+    for (int i = 0; i < 3; i++)
+        rotors.push_back(UserRotor(key.Rotors[i], (char)('A' + key.Positions[i]), (char)('A' + key.Rings[i])));
+    return UserSettings(key.Reflector, rotors, Options.Plugboards[key.Plugboard]);
+}
+
+std::vector<KeyspaceShard> Keyspace::Split(size_t count, uint64_t granularity) const noexcept
+{
+    if (granularity == 0)
+        granularity = 1;
+    const uint64_t units = Size / granularity + (Size % granularity != 0);
+    if (count == 0)
+        count = 1;
+    if (count > units)
+        count = (size_t)units;
+
+    // Shard i gets units [i * units / count, (i + 1) * units / count), the product may not fit in 64 bits.
+    std::vector<KeyspaceShard> shards;
+    uint64_t first = 0;
+    for (size_t i = 1; i <= count; i++)
+    {
+        uint64_t unit = (uint64_t)((unsigned __int128)i * units / count);
+        uint64_t last = unit >= units ? Size : unit * granularity;
+        shards.push_back({first, last});
+        first = last;
+    }
+    return shards;
+}
+
+Keyspace::Iterator Keyspace::At(uint64_t index) const noexcept
+{
+    Iterator it;
+    it.Space = this;
+    it.Index = index;
+    it.Changed = 0;
+    if (index >= Size)
+    {
+        it.Index = Size;
+        return it;
+    }
+    for (int d = 0; d < numberOfDimensions; d++)
+    {
+        it.Digits[d] = (uint32_t)(index / Strides[d] % Radices[d]);
+        SetDimension(it.Key, d, it.Digits[d]);
+    }
+    return it;
+}
+
+Keyspace::Iterator& Keyspace::Iterator::operator++() noexcept
+{
+    if (++Index >= Space->Size)
+    {
+        Index = Space->Size;
+        Changed = 0;
+        return *this;
+    }
+    int d = numberOfDimensions - 1;
+    while (++Digits[d] == Space->Radices[d])
+    {
+        Digits[d] = 0;
+        Space->SetDimension(Key, d, 0);
+        d--;
+    }
+    Space->SetDimension(Key, d, Digits[d]);
+    Changed = d;
+    return *this;
+}
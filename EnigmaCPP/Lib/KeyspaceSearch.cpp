@@ -0,0 +1,447 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "KeyspaceSearch.h"
+#include "KeystreamTable.h"
+#include "MappedFile.h"
+#include "SettingsConversion.h"
+
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace Enigma;
+
+namespace
+{
+    const char checkpointMagic[4] = {'E', 'N', 'K', 'C'};
+
+    /* Header of a checkpoint file, followed by cursors, random states and candidates. */
+    struct FileHeader
+    {
+        char Magic[4];
+        uint32_t FormatVersion;
+        uint32_t WiringVersion;
+        uint32_t Reserved;
+        uint64_t Fingerprint;
+        uint64_t NumberOfShards;
+        uint64_t NumberOfCandidates;
+    };
+
+    /* Keys (or draws) of a shard done between two merges. */
+    const uint64_t chunkKeys = 4096;
+
+    /* FNV-1a. */
+    inline void Hash(uint64_t& hash, const void* data, size_t size) noexcept
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001B3ULL;
+        }
+    }
+
+    inline void Hash(uint64_t& hash, uint64_t value) noexcept
+    {
+        Hash(hash, &value, sizeof(value));
+    }
+
+    /* SplitMix64, a counter-based generator whose state is a single word. */
+    inline uint64_t NextRandom(uint64_t& state) noexcept
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    /* Orders candidates so that the worst one is on the top of std heap functions, ties by the index. */
+    bool Better(const KeyspaceCandidate& a, const KeyspaceCandidate& b) noexcept
+    {
+        if (a.Score != b.Score)
+            return a.Score > b.Score;
+        return a.Index < b.Index;
+    }
+
+    /* Top-K ordered by Better(). */
+    struct TopK
+    {
+        std::vector<KeyspaceCandidate> Heap;
+        size_t Capacity;
+
+        explicit TopK(size_t capacity) noexcept : Capacity(std::max(capacity, (size_t)1)) {}
+
+        void Push(const KeyspaceCandidate& candidate) noexcept
+        {
+            if (Heap.size() == Capacity && !Better(candidate, Heap.front()))
+                return;
+            // Random draws may repeat a key.
+            for (const KeyspaceCandidate& kept : Heap)
+                if (kept.Index == candidate.Index)
+                    return;
+            if (Heap.size() == Capacity)
+            {
+                std::pop_heap(Heap.begin(), Heap.end(), Better);
+                Heap.pop_back();
+            }
+            Heap.push_back(candidate);
+            std::push_heap(Heap.begin(), Heap.end(), Better);
+        }
+
+        std::vector<KeyspaceCandidate> Sorted() const noexcept
+        {
+            std::vector<KeyspaceCandidate> sorted = Heap;
+            std::sort(sorted.begin(), sorted.end(), Better);
+            return sorted;
+        }
+    };
+
+    /* Index of coincidence of letter counts. */
+    inline double IndexOf(const uint32_t* counts, size_t length) noexcept
+    {
+        if (length < 2)
+            return 0;
+        uint64_t sum = 0;
+        for (int i = 0; i < CompiledKey::alphabetLength; i++)
+            sum += (uint64_t)counts[i] * ((uint64_t)counts[i] - 1);
+        return (double)sum / ((double)length * (length - 1));
+    }
+
+    /* Table of the block of keys sharing reflector, wheel order, plugboard and rings. */
+    struct BlockTable
+    {
+        uint64_t Block = UINT64_MAX;
+        std::unique_ptr<KeystreamTable> Table;
+        std::vector<uint16_t> Next;
+    };
+
+    /* Scores keys [first, last), rebuilding @block whenever a key of other table block comes. */
+    void ScoreRange(const Keyspace& space, const uint8_t* text, size_t length, uint64_t first, uint64_t last, BlockTable& block, TopK& top) noexcept
+    {
+        const uint64_t tableSize = space.getTableSize();
+        Keyspace::Iterator it = space.At(first);
+        for (uint64_t index = first; index < last; index++, ++it)
+        {
+            if (block.Block != index / tableSize)
+            {
+                block.Block = index / tableSize;
+                block.Table.reset(new KeystreamTable(CompiledKey(it->Reflector, it->Rotors, it->Rings, space.getPlugboard(it->Plugboard))));
+                block.Next = block.Table->NextStates();
+            }
+            uint32_t counts[CompiledKey::alphabetLength] = {0};
+            int current = KeystreamTable::StateIndex(it->Positions);
+            for (size_t j = 0; j < length; j++)
+            {
+                current = block.Next[current];
+                counts[block.Table->getPermutation(current)[text[j]]]++;
+            }
+            top.Push({IndexOf(counts, length), index});
+        }
+    }
+}
+
+void KeyspaceCheckpoint::Save(const std::string& FilePath) const
+{
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.Magic, checkpointMagic, sizeof(checkpointMagic));
+    header.FormatVersion = formatVersion;
+    header.WiringVersion = SettingsConversion::WiringTableVersion;
+    header.Fingerprint = Fingerprint;
+    header.NumberOfShards = Cursors.size();
+    header.NumberOfCandidates = Candidates.size();
+
+    std::string tmpPath = FilePath + '.' + std::to_string(getpid()) + ".tmp";
+    std::ofstream out(tmpPath, std::ios::binary);
+    if (!out.good())
+        throw std::runtime_error("Error while writing to a file.");
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(Cursors.data()), Cursors.size() * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(RandomStates.data()), RandomStates.size() * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(Candidates.data()), Candidates.size() * sizeof(KeyspaceCandidate));
+    out.close();
+    PublishFile(tmpPath, FilePath, !out.fail());
+}
+
+KeyspaceCheckpoint KeyspaceCheckpoint::Load(const std::string& FilePath)
+{
+    std::ifstream in(FilePath, std::ios::binary | std::ios::ate);
+    if (!in.good())
+        throw std::runtime_error("Cannot open a checkpoint.");
+    uint64_t fileSize = (uint64_t)in.tellg();
+    in.seekg(0);
+
+    FileHeader header;
+    if (fileSize < sizeof(header) || !in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        throw std::runtime_error("Invalid checkpoint file.");
+    if (std::memcmp(header.Magic, checkpointMagic, sizeof(checkpointMagic)) != 0 || header.FormatVersion != formatVersion ||
+        header.WiringVersion != SettingsConversion::WiringTableVersion || header.NumberOfShards > fileSize || header.NumberOfCandidates > fileSize ||
+        fileSize != sizeof(header) + header.NumberOfShards * 2 * sizeof(uint64_t) + header.NumberOfCandidates * sizeof(KeyspaceCandidate))
+        throw std::runtime_error("Invalid checkpoint file.");
+
+    KeyspaceCheckpoint checkpoint;
+    checkpoint.Fingerprint = header.Fingerprint;
+    checkpoint.Cursors.resize(header.NumberOfShards);
+    checkpoint.RandomStates.resize(header.NumberOfShards);
+    checkpoint.Candidates.resize(header.NumberOfCandidates);
+    in.read(reinterpret_cast<char*>(checkpoint.Cursors.data()), checkpoint.Cursors.size() * sizeof(uint64_t));
+    in.read(reinterpret_cast<char*>(checkpoint.RandomStates.data()), checkpoint.RandomStates.size() * sizeof(uint64_t));
+    in.read(reinterpret_cast<char*>(checkpoint.Candidates.data()), checkpoint.Candidates.size() * sizeof(KeyspaceCandidate));
+    if (!in)
+        throw std::runtime_error("Invalid checkpoint file.");
+    return checkpoint;
+}
+
+void KeyspaceSearch::MergeCandidates(std::vector<KeyspaceCandidate>& best, const std::vector<KeyspaceCandidate>& more, size_t topK) noexcept
+{
+    TopK top(topK);
+    for (const KeyspaceCandidate& candidate : best)
+        top.Push(candidate);
+    for (const KeyspaceCandidate& candidate : more)
+        top.Push(candidate);
+    best = top.Sorted();
+}
+
+std::vector<KeyspaceCandidate> KeyspaceSearch::RunRange(const Keyspace& space, const std::string& cipherText, const KeyspaceShard& range, size_t topK, ThreadPool& pool) noexcept
+{
+    const std::vector<uint8_t> text = CompiledKey::ToIndices(cipherText);
+    const uint64_t tableSize = space.getTableSize();
+    const uint64_t last = std::min(range.Last, space.size());
+    if (range.First >= last)
+        return std::vector<KeyspaceCandidate>();
+
+    // A few pieces per thread, of whole table blocks if there are enough of them, so that a table is built once.
+    // A range of a few blocks is cut evenly instead and a table is built by every thread sharing it.
+    std::vector<KeyspaceShard> pieces;
+    const uint64_t blocks = (last - 1) / tableSize - range.First / tableSize + 1;
+    const uint64_t count = std::min((uint64_t)pool.getSize() * 4, last - range.First);
+    const bool wholeBlocks = blocks >= count;
+    uint64_t first = range.First;
+    for (uint64_t i = 1; i <= count; i++)
+    {
+        uint64_t end = i == count ? last
+                     : wholeBlocks ? (range.First / tableSize + blocks * i / count) * tableSize
+                                   : range.First + (last - range.First) * i / count;
+        pieces.push_back({first, end});
+        first = end;
+    }
+
+    std::vector<TopK> tops(pieces.size(), TopK(topK));
+    pool.ParallelFor(pieces.size(), [&](size_t p) {
+        BlockTable block;
+        ScoreRange(space, text.data(), text.size(), pieces[p].First, pieces[p].Last, block, tops[p]);
+    });
+
+    std::vector<KeyspaceCandidate> best;
+    for (const TopK& top : tops)
+        MergeCandidates(best, top.Heap, topK);
+    return best;
+}
+
+uint64_t KeyspaceSearch::Fingerprint(const Keyspace& space, const std::string& cipherText, const KeyspaceSearchOptions& options) noexcept
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    std::vector<uint8_t> text = CompiledKey::ToIndices(cipherText);
+    Hash(hash, text.size());
+    Hash(hash, text.data(), text.size());
+
+    const KeyspaceOptions& dims = space.getOptions();
+    Hash(hash, dims.Reflectors.size());
+    for (ReflectorID reflector : dims.Reflectors)
+        Hash(hash, (uint64_t)reflector);
+    Hash(hash, dims.WheelOrders.size());
+    for (const std::array<RotorID, 3>& order : dims.WheelOrders)
+        for (RotorID rotor : order)
+            Hash(hash, (uint64_t)rotor);
+    Hash(hash, dims.Plugboards.size());
+    for (size_t i = 0; i < dims.Plugboards.size(); i++)
+        Hash(hash, space.getPlugboard(i), CompiledKey::alphabetLength);
+    for (int i = 0; i < 3; i++)
+        for (const std::vector<int>* values : {&dims.Rings[i], &dims.Positions[i]})
+        {
+            Hash(hash, values->size());
+            for (int value : *values)
+                Hash(hash, (uint64_t)value);
+        }
+
+    Hash(hash, options.TopK);
+    Hash(hash, options.Shards);
+    Hash(hash, options.Samples);
+    Hash(hash, options.Seed);
+    return hash;
+}
+
+KeyspaceSearchResult KeyspaceSearch::Run(const Keyspace& space, const std::string& cipherText, const KeyspaceSearchOptions& options, ThreadPool& pool)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    const std::vector<uint8_t> text = CompiledKey::ToIndices(cipherText);
+    const size_t length = text.size();
+    const bool sampling = options.Samples > 0;
+    const uint64_t tableSize = space.getTableSize();
+
+    // Shard s covers keys [First, Last), or with Samples draws [First, Last) of the whole sequence.
+    std::vector<KeyspaceShard> shards;
+    const size_t count = std::max(options.Shards, (size_t)1);
+    if (!sampling)
+        shards = space.Split(count, 1);
+    else
+        for (size_t s = 0; s < count; s++)
+            shards.push_back({options.Samples * s / count, options.Samples * (s + 1) / count});
+
+    KeyspaceCheckpoint state;
+    state.Fingerprint = Fingerprint(space, cipherText, options);
+    state.Cursors.assign(shards.size(), 0);
+    state.RandomStates.resize(shards.size());
+    for (size_t s = 0; s < shards.size(); s++)
+    {
+        uint64_t seed = options.Seed ^ (0xD1B54A32D192ED03ULL * (s + 1));
+        state.RandomStates[s] = NextRandom(seed);
+    }
+
+    KeyspaceSearchResult res;
+    res.Resumed = false;
+    TopK best(options.TopK);
+    if (!options.CheckpointPath.empty() && std::ifstream(options.CheckpointPath).good())
+    {
+        KeyspaceCheckpoint loaded = KeyspaceCheckpoint::Load(options.CheckpointPath);
+        if (loaded.Fingerprint != state.Fingerprint || loaded.Cursors.size() != shards.size())
+            throw std::runtime_error("Checkpoint belongs to other search.");
+        for (size_t s = 0; s < shards.size(); s++)
+            if (loaded.Cursors[s] > shards[s].size())
+                throw std::runtime_error("Invalid checkpoint file.");
+        state.Cursors = loaded.Cursors;
+        state.RandomStates = loaded.RandomStates;
+        for (const KeyspaceCandidate& candidate : loaded.Candidates)
+            best.Push(candidate);
+        res.Resumed = true;
+    }
+
+    std::mutex lock;
+    bool writing = false;
+    std::atomic<bool> stopping(false);
+    std::atomic<uint64_t> tested(0);
+    std::exception_ptr error;
+    uint64_t checkpoints = 0;
+    double checkpointSeconds = 0;
+    auto lastCheckpoint = std::chrono::steady_clock::now();
+
+    auto save = [&](std::unique_lock<std::mutex>& held) {
+        KeyspaceCheckpoint snapshot = state;
+        snapshot.Candidates = best.Sorted();
+        writing = true;
+        held.unlock();
+        auto start = std::chrono::steady_clock::now();
+        std::exception_ptr failed;
+        try
+        {
+            snapshot.Save(options.CheckpointPath);
+        }
+        catch (...)
+        {
+            failed = std::current_exception();
+        }
+        auto end = std::chrono::steady_clock::now();
+        held.lock();
+        writing = false;
+        lastCheckpoint = end;
+        checkpoints++;
+        checkpointSeconds += std::chrono::duration<double>(end - start).count();
+        if (failed && !error)
+        {
+            error = failed;
+            stopping = true;
+        }
+    };
+
+    pool.ParallelFor(shards.size(), [&](size_t s) {
+        const KeyspaceShard& shard = shards[s];
+        BlockTable block;
+        std::vector<uint8_t> buffer(length);
+        uint64_t cursor, random;
+        {
+            std::lock_guard<std::mutex> held(lock);
+            cursor = state.Cursors[s];
+            random = state.RandomStates[s];
+        }
+
+        while (cursor < shard.size())
+        {
+            if (stopping || (options.Stop && *options.Stop) || (options.MaxKeys && tested >= options.MaxKeys))
+            {
+                stopping = true;
+                return;
+            }
+
+            TopK local(options.TopK);
+            uint64_t end = std::min(shard.size(), cursor + chunkKeys);
+            if (!sampling)
+            {
+                // A chunk never leaves its table block.
+                uint64_t first = shard.First + cursor;
+                end = std::min(end, (first / tableSize + 1) * tableSize - shard.First);
+                ScoreRange(space, text.data(), length, first, shard.First + end, block, local);
+            }
+            else
+            {
+                for (uint64_t i = cursor; i < end; i++)
+                {
+                    uint64_t index = NextRandom(random) % space.size();
+                    KeyspaceKey key = space.Unrank(index);
+                    CompiledKey compiled(key.Reflector, key.Rotors, key.Rings, space.getPlugboard(key.Plugboard));
+                    RotorPositions positions = key.Positions;
+                    compiled.EncryptIndices(text.data(), buffer.data(), length, positions);
+                    uint32_t counts[CompiledKey::alphabetLength] = {0};
+                    for (size_t j = 0; j < length; j++)
+                        counts[buffer[j]]++;
+                    local.Push({IndexOf(counts, length), index});
+                }
+            }
+            tested += end - cursor;
+            cursor = end;
+
+            std::unique_lock<std::mutex> held(lock);
+            for (const KeyspaceCandidate& candidate : local.Heap)
+                best.Push(candidate);
+            state.Cursors[s] = cursor;
+            state.RandomStates[s] = random;
+            if (!options.CheckpointPath.empty() && !writing &&
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - lastCheckpoint).count() >= options.CheckpointSeconds)
+                save(held);
+        }
+    });
+
+    std::unique_lock<std::mutex> held(lock);
+    if (error)
+        std::rethrow_exception(error);
+    if (!options.CheckpointPath.empty())
+    {
+        save(held);
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    res.Candidates = best.Sorted();
+    res.KeysTested = tested;
+    res.KeysDone = 0;
+    res.KeysTotal = sampling ? options.Samples : space.size();
+    res.Complete = true;
+    for (size_t s = 0; s < shards.size(); s++)
+    {
+        res.KeysDone += state.Cursors[s];
+        res.Complete = res.Complete && state.Cursors[s] == shards[s].size();
+    }
+    res.Checkpoints = checkpoints;
+    res.CheckpointSeconds = checkpointSeconds;
+    res.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return res;
+}
@@ -0,0 +1,207 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "Keyspace.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Enigma
+{
+    /* Options of KeyspaceSearch. */
+    struct KeyspaceSearchOptions
+    {
+        /* Number of kept candidates (K). */
+        size_t TopK = 10;
+
+        /* Number of shards, fixed so that a checkpoint does not depend on the number of threads. */
+        size_t Shards = 256;
+
+        /* 0 tests every key, otherwise the number of keys drawn at random from the whole space (stochastic search). */
+        uint64_t Samples = 0;
+
+        /* Seed of random draws, the same seed gives the same result. */
+        uint64_t Seed = 1;
+
+        /* Checkpoint file, the search resumes from it if it exists. Empty disables checkpoints. */
+        std::string CheckpointPath;
+
+        /* Seconds between checkpoints. */
+        double CheckpointSeconds = 5.0;
+
+        /* Stops this run after about this many tested keys, 0 for no limit. A checkpoint is written on stop. */
+        uint64_t MaxKeys = 0;
+
+        /* Stops the run when set (e.g. by a signal handler), may be nullptr. A checkpoint is written on stop. */
+        const std::atomic<bool>* Stop = nullptr;
+    };
+
+    /* Candidate of KeyspaceSearch, 16 bytes. */
+    struct KeyspaceCandidate
+    {
+        /* Index of coincidence of the decryption. */
+        double Score;
+
+        /* Index of the key in the Keyspace. */
+        uint64_t Index;
+    };
+
+    /* Progress of a KeyspaceSearch. */
+    struct KeyspaceCheckpoint
+    {
+        /* Version of the file format. */
+        static const uint32_t formatVersion = 1;
+
+        /* Hash of the ciphertext, keyspace and options which change the result. */
+        uint64_t Fingerprint;
+
+        /* Number of keys (or draws) done in every shard. */
+        std::vector<uint64_t> Cursors;
+
+        /* State of the random generator of every shard. */
+        std::vector<uint64_t> RandomStates;
+
+        /* Best candidates of all done keys, from the best one. */
+        std::vector<KeyspaceCandidate> Candidates;
+
+        /**
+         * Saves the checkpoint. The file is written under a temporary name and renamed,
+         * so a preempted run never leaves a partial file.
+         *
+         * Params:
+         * const std::string& FilePath - path of the file.
+         *
+         * Exceptions:
+         * If the file cannot be written, an exception will be thrown.
+         */
+        void Save(const std::string& FilePath) const noexcept(false);
+
+        /**
+         * Loads a checkpoint saved by Save().
+         *
+         * Params:
+         * const std::string& FilePath - path of the file.
+         *
+         * Exceptions:
+         * If the file cannot be read, is damaged, or was written with other format or wiring tables version,
+         * an exception will be thrown.
+         *
+         * Returns:
+         * KeyspaceCheckpoint - checkpoint.
+         */
+        static KeyspaceCheckpoint Load(const std::string& FilePath) noexcept(false);
+    };
+
+    /* Result of KeyspaceSearch. */
+    struct KeyspaceSearchResult
+    {
+        /* Best candidates, from the best one. */
+        std::vector<KeyspaceCandidate> Candidates;
+
+        /* Number of keys tested by this run. */
+        uint64_t KeysTested;
+
+        /* Number of keys done by this and all resumed runs. */
+        uint64_t KeysDone;
+
+        /* Number of keys of the whole search (size of the space or Samples). */
+        uint64_t KeysTotal;
+
+        /* True if the search is finished, false if it was stopped. */
+        bool Complete;
+
+        /* True if the run started from a checkpoint. */
+        bool Resumed;
+
+        /* Number of checkpoints written by this run. */
+        uint64_t Checkpoints;
+
+        /* Time spent writing checkpoints in seconds. */
+        double CheckpointSeconds;
+
+        /* Wall time of the run in seconds. */
+        double Seconds;
+    };
+
+    /**
+     * Resumable ciphertext-only search over a Keyspace, scored by the index of coincidence.
+     *
+     * The space is split into a fixed number of shards which are spread across the threads of the pool.
+     * A shard is done in chunks, each within one table block: the key is expanded to a KeystreamTable
+     * once per block and every start position costs two lookups per letter. With Samples, keys are drawn
+     * by a counter-based generator whose whole state is one word per shard.
+     *
+     * Every CheckpointSeconds the thread finishing a chunk takes a snapshot (shard cursors, generator states,
+     * merged top-K) and writes it atomically outside of the lock; the snapshot is a few kilobytes,
+     * so writing it every few seconds costs about a millisecond.
+     * Candidates are ordered by score and then by key index, so top-K of any split of the work is the same
+     * and a resumed run gives the same result as an uninterrupted one.
+     */
+    class KeyspaceSearch
+    {
+    public:
+        /**
+         * Runs or resumes the search.
+         *
+         * Params:
+         * const Keyspace& space - keys to be searched.
+         * const std::string& cipherText - ciphertext, characters out of the alphabet are ignored.
+         * const KeyspaceSearchOptions& options - options.
+         * ThreadPool& pool - threads used for the search.
+         *
+         * Exceptions:
+         * If the checkpoint cannot be read or written, or belongs to other search, an exception will be thrown.
+         *
+         * Returns:
+         * KeyspaceSearchResult - best candidates and statistics.
+         */
+        static KeyspaceSearchResult Run(const Keyspace& space, const std::string& cipherText, const KeyspaceSearchOptions& options, ThreadPool& pool) noexcept(false);
+
+        /**
+         * Tests a range of keys without checkpoints, used by workers of a distributed search.
+         * The range is cut into pieces spread across the threads of the pool, of whole table blocks when it has enough of them.
+         *
+         * Params:
+         * const Keyspace& space - keys to be searched.
+         * const std::string& cipherText - ciphertext, characters out of the alphabet are ignored.
+         * const KeyspaceShard& range - indices of tested keys.
+         * size_t topK - number of kept candidates.
+         * ThreadPool& pool - threads used for the search.
+         *
+         * Returns:
+         * std::vector<KeyspaceCandidate> - best candidates of the range, from the best one.
+         */
+        static std::vector<KeyspaceCandidate> RunRange(const Keyspace& space, const std::string& cipherText, const KeyspaceShard& range, size_t topK, ThreadPool& pool) noexcept;
+
+        /**
+         * Merges candidates into top-K, in the order used by the search (score, then key index), repeated keys once.
+         *
+         * Params:
+         * std::vector<KeyspaceCandidate>& best - candidates, replaced by the merged top-K from the best one.
+         * const std::vector<KeyspaceCandidate>& more - candidates to be merged.
+         * size_t topK - number of kept candidates.
+         */
+        static void MergeCandidates(std::vector<KeyspaceCandidate>& best, const std::vector<KeyspaceCandidate>& more, size_t topK) noexcept;
+
+        /**
+         * Computes the fingerprint a checkpoint of given search must have.
+         *
+         * Params:
+         * const Keyspace& space - keys to be searched.
+         * const std::string& cipherText - ciphertext.
+         * const KeyspaceSearchOptions& options - options.
+         *
+         * Returns:
+         * uint64_t - fingerprint.
+         */
+        static uint64_t Fingerprint(const Keyspace& space, const std::string& cipherText, const KeyspaceSearchOptions& options) noexcept;
+    };
+}
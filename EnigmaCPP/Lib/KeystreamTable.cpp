@@ -0,0 +1,201 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "KeystreamTable.h"
+#include "SettingsConversion.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+using namespace Enigma;
+
+namespace
+{
+    /* Magic of the file format. */
+    const char tableMagic[4] = {'E', 'K', 'S', 'T'};
+
+    /* Offset of the table in the file, keeps it page-aligned. */
+    const uint64_t tableOffset = 4096;
+
+    /* Header of the file. */
+    struct FileHeader
+    {
+        char Magic[4];
+        uint32_t FormatVersion;
+        uint32_t WiringVersion;
+        int32_t Notches[3];
+        uint64_t TableOffset;
+        uint64_t TableSize;
+        uint32_t FormLength;
+        char Form[128];
+    };
+
+    static_assert(sizeof(FileHeader) <= tableOffset, "Header must fit before the table.");
+
+    /* Size of the table in bytes. */
+    const uint64_t tableSize = (uint64_t)KeystreamTable::numberOfStates * CompiledKey::alphabetLength;
+
+    /* 64 bit FNV-1a, stable between builds unlike std::hash. */
+    uint64_t Fnv1a(const std::string& text) noexcept
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : text)
+        {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+}
+
+KeystreamTable::KeystreamTable(const CompiledKey& Key) noexcept : Owned(tableSize)
+{
+    RotorPositions positions;
+    uint8_t* out = Owned.data();
+    for (positions[0] = 0; positions[0] < CompiledKey::alphabetLength; positions[0]++)
+        for (positions[1] = 0; positions[1] < CompiledKey::alphabetLength; positions[1]++)
+            for (positions[2] = 0; positions[2] < CompiledKey::alphabetLength; positions[2]++)
+                for (int letter = 0; letter < CompiledKey::alphabetLength; letter++)
+                    *out++ = (uint8_t)Key.PermuteIndex(letter, positions);
+    Table = Owned.data();
+    for (int i = 0; i < 3; i++)
+        Notches[i] = Key.getNotches()[i];
+}
+
+std::unique_ptr<KeystreamTable> KeystreamTable::Open(const std::string& FilePath, const std::string& CanonicalForm) noexcept
+{
+    std::unique_ptr<MappedFile> mapping;
+    try
+    {
+        mapping.reset(new MappedFile(FilePath));
+    }
+    catch (const std::exception&)
+    {
+        return nullptr;
+    }
+    if (mapping->getSize() != tableOffset + tableSize)
+        return nullptr;
+
+    FileHeader header;
+    std::memcpy(&header, mapping->getData(), sizeof(header));
+    if (std::memcmp(header.Magic, tableMagic, sizeof(tableMagic)) != 0 ||
+        header.FormatVersion != formatVersion ||
+        header.WiringVersion != SettingsConversion::WiringTableVersion ||
+        header.TableOffset != tableOffset || header.TableSize != tableSize ||
+        header.FormLength != CanonicalForm.size() ||
+        std::memcmp(header.Form, CanonicalForm.data(), CanonicalForm.size()) != 0)
+        return nullptr;
+
+    std::unique_ptr<KeystreamTable> table(new KeystreamTable());
+    table->Table = reinterpret_cast<const uint8_t*>(mapping->getData() + tableOffset);
+    for (int i = 0; i < 3; i++)
+        table->Notches[i] = header.Notches[i];
+    table->Mapping = std::move(mapping);
+    return table;
+}
+
+void KeystreamTable::Save(const std::string& FilePath, const std::string& CanonicalForm) const
+{
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    if (CanonicalForm.size() > sizeof(header.Form))
+        throw std::runtime_error("Canonical form is too long.");
+    std::memcpy(header.Magic, tableMagic, sizeof(tableMagic));
+    header.FormatVersion = formatVersion;
+    header.WiringVersion = SettingsConversion::WiringTableVersion;
+    for (int i = 0; i < 3; i++)
+        header.Notches[i] = Notches[i];
+    header.TableOffset = tableOffset;
+    header.TableSize = tableSize;
+    header.FormLength = (uint32_t)CanonicalForm.size();
+    std::memcpy(header.Form, CanonicalForm.data(), CanonicalForm.size());
+
+    std::vector<char> page(tableOffset, 0);
+    std::memcpy(page.data(), &header, sizeof(header));
+
+    // Temporary name is unique per process, concurrent writers of the same table do not collide.
+    std::string tmpPath = FilePath + '.' + std::to_string(getpid()) + ".tmp";
+    std::ofstream out(tmpPath, std::ios::binary);
+    if (!out.good())
+        throw std::runtime_error("Error while writing to a file.");
+    out.write(page.data(), page.size());
+    out.write(reinterpret_cast<const char*>(Table), tableSize);
+    out.close();
+    PublishFile(tmpPath, FilePath, !out.fail());
+}
+
+std::vector<uint16_t> KeystreamTable::NextStates() const noexcept
+{
+    std::vector<uint16_t> next(numberOfStates);
+    RotorPositions positions;
+    for (positions[0] = 0; positions[0] < CompiledKey::alphabetLength; positions[0]++)
+        for (positions[1] = 0; positions[1] < CompiledKey::alphabetLength; positions[1]++)
+            for (positions[2] = 0; positions[2] < CompiledKey::alphabetLength; positions[2]++)
+            {
+                RotorPositions stepped = positions;
+                EncryptIndex(0, stepped);
+                next[StateIndex(positions)] = (uint16_t)StateIndex(stepped);
+            }
+    return next;
+}
+
+void KeystreamTable::EncryptIndices(const uint8_t* in, uint8_t* out, size_t length, RotorPositions& positions) const noexcept
+{
+    for (size_t i = 0; i < length; i++)
+        out[i] = (uint8_t)EncryptIndex(in[i], positions);
+}
+
+std::string KeystreamTable::EncryptString(const std::string& originalText, RotorPositions& positions) const noexcept
+{
+    std::string encryptedText;
+    encryptedText.reserve(originalText.size());
+    for (char c : originalText)
+    {
+        char letter = std::toupper(c);
+        if (letter >= 'A' && letter <= 'Z')
+            encryptedText += (char)('A' + EncryptIndex(letter - 'A', positions));
+    }
+    return encryptedText;
+}
+
+std::string KeystreamCache::PathOf(const UserSettings& USettings) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.ekst", (unsigned long long)Fnv1a(CompiledKey::CanonicalForm(USettings)));
+    return Directory + '/' + name;
+}
+
+std::shared_ptr<const KeystreamTable> KeystreamCache::Get(const UserSettings& USettings)
+{
+    // Validates the connections before the lookup, like KeyCache::Get; invalid rotors never reach a table and throw while compiling.
+    std::string form = CompiledKey::CanonicalForm(USettings);
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+        auto it = Loaded.find(form);
+        if (it != Loaded.end())
+            return it->second;
+    }
+
+    std::string path = PathOf(USettings);
+    std::shared_ptr<const KeystreamTable> table = KeystreamTable::Open(path, form);
+    if (table == nullptr)
+    {
+        // Missing or stale, rebuild from the current wiring tables.
+        KeystreamTable built{CompiledKey(USettings)};
+        built.Save(path, form);
+        table = KeystreamTable::Open(path, form);
+        if (table == nullptr)
+            throw std::runtime_error("Error while mapping file.");
+    }
+
+    std::lock_guard<std::mutex> guard(Lock);
+    auto res = Loaded.emplace(form, table);
+    return res.first->second;
+}
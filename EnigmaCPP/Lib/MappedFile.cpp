@@ -0,0 +1,67 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace Enigma;
+
+MappedFile::MappedFile(const std::string& FilePath) : Data(nullptr), Size(0)
+{
+    int fd = open(FilePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error("Error while reading file.");
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("Error while reading file.");
+    }
+    Size = (size_t)info.st_size;
+
+    if (Size != 0)
+    {
+        void* addr = mmap(nullptr, Size, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            close(fd);
+            throw std::runtime_error("Error while mapping file.");
+        }
+        Data = static_cast<const char*>(addr);
+    }
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+}
+
+MappedFile::~MappedFile() noexcept
+{
+    if (Data != nullptr)
+        munmap(const_cast<char*>(Data), Size);
+}
+
+void Enigma::PublishFile(const std::string& TmpPath, const std::string& FilePath, bool Written)
+{
+    bool synced = false;
+    if (Written)
+    {
+        int fd = open(TmpPath.c_str(), O_RDONLY | O_CLOEXEC);
+        synced = fd >= 0 && fsync(fd) == 0;
+        if (fd >= 0)
+            close(fd);
+    }
+    if (!synced || std::rename(TmpPath.c_str(), FilePath.c_str()) != 0)
+    {
+        std::remove(TmpPath.c_str());
+        throw std::runtime_error("Error while writing to a file.");
+    }
+}
@@ -0,0 +1,249 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "NgramModel.h"
+#include "CompiledKey.h"
+
+#include <cmath>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+using namespace Enigma;
+
+namespace
+{
+    /* Magic of the file format. */
+    const char modelMagic[4] = {'E', 'N', 'G', 'M'};
+
+    /* Offset of the table in the file, keeps it page-aligned. */
+    const uint64_t tableOffset = 4096;
+
+    /* Header of the file. */
+    struct FileHeader
+    {
+        char Magic[4];
+        uint32_t FormatVersion;
+        uint32_t Order;
+        uint32_t ValueType;
+        int32_t Scale;
+        uint32_t Reserved;
+        uint64_t TableOffset;
+        uint64_t TableSize;
+        char Language[16];
+    };
+
+    static_assert(sizeof(FileHeader) <= tableOffset, "Header must fit before the table.");
+
+    /* Number of n-grams scored per block. */
+    const size_t blockLength = 256;
+
+    /* Returns 26^order. */
+    size_t NumberOfEntries(int order) noexcept
+    {
+        size_t entries = 1;
+        for (int i = 0; i < order; i++)
+            entries *= CompiledKey::alphabetLength;
+        return entries;
+    }
+
+    /* Size of a value of given type in bytes. */
+    size_t ValueSize(NgramValueType type) noexcept
+    {
+        return type == NgramFloat32 ? sizeof(float) : sizeof(int16_t);
+    }
+
+    /**
+     * Sums table values of all n-grams of a text.
+     * Block indices depend only on the text, not on the previous index, so the first loop vectorizes;
+     * the second one keeps 4 independent sums to hide the latency of lookups.
+     */
+    template <int N, typename T, typename Accumulator>
+    double SumBlocked(const T* table, const uint8_t* text, size_t length) noexcept
+    {
+        const size_t count = length - N + 1;
+        uint32_t indices[blockLength];
+        double total = 0;
+        for (size_t begin = 0; begin < count; begin += blockLength)
+        {
+            const size_t block = count - begin < blockLength ? count - begin : blockLength;
+            const uint8_t* t = text + begin;
+            for (size_t i = 0; i < block; i++)
+            {
+                uint32_t index = 0;
+                for (int k = 0; k < N; k++)
+                    index = index * CompiledKey::alphabetLength + t[i + k];
+                indices[i] = index;
+            }
+
+            Accumulator sums[4] = {0, 0, 0, 0};
+            size_t i = 0;
+            for (; i + 4 <= block; i += 4)
+            {
+                sums[0] += table[indices[i]];
+                sums[1] += table[indices[i + 1]];
+                sums[2] += table[indices[i + 2]];
+                sums[3] += table[indices[i + 3]];
+            }
+            for (; i < block; i++)
+                sums[0] += table[indices[i]];
+            total += (double)((sums[0] + sums[1]) + (sums[2] + sums[3]));
+        }
+        return total;
+    }
+
+    /* Dispatches SumBlocked on order. */
+    template <typename T, typename Accumulator>
+    double SumTable(int order, const T* table, const uint8_t* text, size_t length) noexcept
+    {
+        switch (order)
+        {
+        case 1:
+            return SumBlocked<1, T, Accumulator>(table, text, length);
+        case 2:
+            return SumBlocked<2, T, Accumulator>(table, text, length);
+        case 3:
+            return SumBlocked<3, T, Accumulator>(table, text, length);
+        default:
+            return SumBlocked<4, T, Accumulator>(table, text, length);
+        }
+    }
+}
+
+NgramModel::NgramModel(int Order, NgramValueType Type, const std::string& Language) noexcept
+    : Order(Order), Type(Type), Language(Language), Size(NumberOfEntries(Order)), Floats(nullptr), Int16s(nullptr)
+{
+}
+
+NgramModel NgramModel::Train(const char* Corpus, size_t Length, int Order, const std::string& Language, NgramValueType Type)
+{
+    if (Order < 1 || Order > maxOrder)
+        throw std::runtime_error("Unsupported n-gram order.");
+    if (Language.size() >= sizeof(FileHeader::Language))
+        throw std::runtime_error("Language name is too long.");
+
+    NgramModel model(Order, Type, Language);
+    std::vector<uint64_t> counts(model.Size, 0);
+    size_t index = 0;
+    uint64_t letters = 0;
+    for (size_t i = 0; i < Length; i++)
+    {
+        char letter = (char)std::toupper((unsigned char)Corpus[i]);
+        if (letter < 'A' || letter > 'Z')
+            continue;
+        index = (index * CompiledKey::alphabetLength + (letter - 'A')) % model.Size;
+        if (++letters >= (uint64_t)Order)
+            counts[index]++;
+    }
+    if (letters < (uint64_t)Order)
+        throw std::runtime_error("Corpus is too short.");
+
+    // Unseen n-grams get 1/100 of a single occurrence.
+    double total = (double)(letters - Order + 1);
+    double floor = std::log10(0.01 / total);
+    if (Type == NgramFloat32)
+    {
+        model.OwnedFloats.resize(model.Size);
+        for (size_t i = 0; i < model.Size; i++)
+            model.OwnedFloats[i] = (float)(counts[i] ? std::log10(counts[i] / total) : floor);
+        model.Floats = model.OwnedFloats.data();
+    }
+    else
+    {
+        model.OwnedInt16s.resize(model.Size);
+        for (size_t i = 0; i < model.Size; i++)
+        {
+            double value = std::round((counts[i] ? std::log10(counts[i] / total) : floor) * int16Scale);
+            model.OwnedInt16s[i] = (int16_t)(value < INT16_MIN ? INT16_MIN : value);
+        }
+        model.Int16s = model.OwnedInt16s.data();
+    }
+    return model;
+}
+
+NgramModel NgramModel::Load(const std::string& FilePath)
+{
+    std::unique_ptr<MappedFile> mapping(new MappedFile(FilePath));
+    FileHeader header;
+    if (mapping->getSize() < tableOffset)
+        throw std::runtime_error("Invalid n-gram model file.");
+    std::memcpy(&header, mapping->getData(), sizeof(header));
+    if (std::memcmp(header.Magic, modelMagic, sizeof(modelMagic)) != 0)
+        throw std::runtime_error("Invalid n-gram model file.");
+    if (header.FormatVersion != formatVersion)
+        throw std::runtime_error("Unsupported n-gram model version.");
+    if (header.Order < 1 || header.Order > (uint32_t)maxOrder || header.ValueType > NgramInt16 ||
+        (header.ValueType == NgramInt16 && header.Scale != int16Scale) || header.TableOffset != tableOffset ||
+        header.TableSize != NumberOfEntries(header.Order) * ValueSize((NgramValueType)header.ValueType) ||
+        mapping->getSize() != tableOffset + header.TableSize)
+        throw std::runtime_error("Invalid n-gram model file.");
+
+    header.Language[sizeof(header.Language) - 1] = '\0';
+    NgramModel model((int)header.Order, (NgramValueType)header.ValueType, header.Language);
+    const char* table = mapping->getData() + tableOffset;
+    if (model.Type == NgramFloat32)
+        model.Floats = reinterpret_cast<const float*>(table);
+    else
+        model.Int16s = reinterpret_cast<const int16_t*>(table);
+    model.Mapping = std::move(mapping);
+    return model;
+}
+
+void NgramModel::Save(const std::string& FilePath) const
+{
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.Magic, modelMagic, sizeof(modelMagic));
+    header.FormatVersion = formatVersion;
+    header.Order = (uint32_t)Order;
+    header.ValueType = Type;
+    header.Scale = Type == NgramInt16 ? int16Scale : 1;
+    header.TableOffset = tableOffset;
+    header.TableSize = Size * ValueSize(Type);
+    std::memcpy(header.Language, Language.data(), Language.size());
+
+    std::vector<char> page(tableOffset, 0);
+    std::memcpy(page.data(), &header, sizeof(header));
+
+    std::string tmpPath = FilePath + '.' + std::to_string(getpid()) + ".tmp";
+    std::ofstream out(tmpPath, std::ios::binary);
+    if (!out.good())
+        throw std::runtime_error("Error while writing to a file.");
+    out.write(page.data(), page.size());
+    if (Type == NgramFloat32)
+        out.write(reinterpret_cast<const char*>(Floats), header.TableSize);
+    else
+        out.write(reinterpret_cast<const char*>(Int16s), header.TableSize);
+    out.close();
+    PublishFile(tmpPath, FilePath, !out.fail());
+}
+
+void NgramModel::Replicate(bool HugePages)
+{
+    const NumaTopology& topology = NumaTopology::System();
+    const size_t bytes = Size * (Type == NgramFloat32 ? sizeof(float) : sizeof(int16_t));
+    const void* table = Type == NgramFloat32 ? static_cast<const void*>(Floats) : static_cast<const void*>(Int16s);
+    std::vector<NodeBuffer> replicas;
+    for (int node = 0; node < topology.getNumberOfNodes(); node++)
+    {
+        replicas.push_back(NodeBuffer(bytes, node, HugePages));
+        std::memcpy(replicas.back().data(), table, bytes);
+    }
+    Replicas = std::move(replicas);
+}
+
+double NgramModel::Score(const uint8_t* text, size_t length) const noexcept
+{
+    if (length < (size_t)Order)
+        return 0;
+    const void* replica = Replicas.empty() ? nullptr : Replicas[NumaTopology::System().CurrentNode()].data();
+    if (Type == NgramFloat32)
+        return SumTable<float, float>(Order, replica ? static_cast<const float*>(replica) : Floats, text, length);
+    return SumTable<int16_t, int32_t>(Order, replica ? static_cast<const int16_t*>(replica) : Int16s, text, length) / int16Scale;
+}
@@ -0,0 +1,239 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "NumaTopology.h"
+
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <sched.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+using namespace Enigma;
+
+namespace
+{
+    /* Node the calling thread is pinned to, -1 if not pinned. */
+    thread_local int pinnedNode = -1;
+
+    /* Size of a transparent huge page on x86-64 and most of arm64 kernels. */
+    const size_t hugePageSize = 2 * 1024 * 1024;
+
+    /* Preferred-node memory policy of mbind(2), from linux/mempolicy.h. */
+    const int preferredPolicy = 1;
+
+    /* Parses a CPU list of sysfs, e.g. "0-3,8-11". */
+    std::vector<int> ParseCpuList(const std::string& list)
+    {
+        std::vector<int> cpus;
+        size_t pos = 0;
+        while (pos < list.size())
+        {
+            size_t end = list.find(',', pos);
+            if (end == std::string::npos)
+                end = list.size();
+            std::string range = list.substr(pos, end - pos);
+            size_t dash = range.find('-');
+            try
+            {
+                int first = std::stoi(range.substr(0, dash));
+                int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                for (int cpu = first; cpu <= last; cpu++)
+                    cpus.push_back(cpu);
+            }
+            catch (const std::exception&)
+            {
+            }
+            pos = end + 1;
+        }
+        return cpus;
+    }
+}
+
+NumaTopology::NumaTopology() noexcept
+{
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            CPU_SET(cpu, &allowed);
+    Nodes.assign(CPU_SETSIZE, -1);
+
+    std::vector<int> kernelNodes;
+    if (DIR* dir = opendir("/sys/devices/system/node"))
+    {
+        while (dirent* entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            if (name.compare(0, 4, "node") == 0 && name.size() > 4 && name.find_first_not_of("0123456789", 4) == std::string::npos)
+                kernelNodes.push_back(std::stoi(name.substr(4)));
+        }
+        closedir(dir);
+    }
+    std::sort(kernelNodes.begin(), kernelNodes.end());
+
+    for (int kernelNode : kernelNodes)
+    {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(kernelNode) + "/cpulist");
+        std::string list;
+        std::getline(file, list);
+        std::vector<int> cpus;
+        for (int cpu : ParseCpuList(list))
+            if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed) && Nodes[cpu] < 0)
+            {
+                Nodes[cpu] = (int)Cpus.size();
+                cpus.push_back(cpu);
+            }
+        if (cpus.empty())
+            continue;
+        Cpus.push_back(cpus);
+        KernelNodes.push_back(kernelNode);
+    }
+
+    // No NUMA information (or no usable CPU in it): one node of all allowed CPUs.
+    if (Cpus.empty())
+    {
+        std::vector<int> cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            if (CPU_ISSET(cpu, &allowed))
+            {
+                Nodes[cpu] = 0;
+                cpus.push_back(cpu);
+            }
+        Cpus.push_back(cpus);
+        KernelNodes.push_back(-1);
+    }
+}
+
+const NumaTopology& NumaTopology::System() noexcept
+{
+    static const NumaTopology topology;
+    return topology;
+}
+
+int NumaTopology::NodeOf(int cpu) const noexcept
+{
+    if (cpu < 0 || cpu >= (int)Nodes.size() || Nodes[cpu] < 0)
+        return 0;
+    return Nodes[cpu];
+}
+
+std::vector<int> NumaTopology::Place(int count, ThreadPlacement placement) const noexcept
+{
+    std::vector<int> cpus;
+    if (placement == PlacementNone || count < 1)
+        return cpus;
+
+    // Order of CPUs in which threads take them.
+    std::vector<int> order;
+    if (placement == PlacementCompact)
+    {
+        for (const std::vector<int>& node : Cpus)
+            order.insert(order.end(), node.begin(), node.end());
+    }
+    else
+    {
+        for (size_t i = 0;; i++)
+        {
+            bool any = false;
+            for (const std::vector<int>& node : Cpus)
+                if (i < node.size())
+                {
+                    order.push_back(node[i]);
+                    any = true;
+                }
+            if (!any)
+                break;
+        }
+    }
+
+    for (int i = 0; i < count && !order.empty(); i++)
+        cpus.push_back(order[i % order.size()]);
+    return cpus;
+}
+
+bool NumaTopology::PinCurrentThread(int cpu) const noexcept
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+        return false;
+    pinnedNode = NodeOf(cpu);
+    return true;
+}
+
+int NumaTopology::CurrentNode() const noexcept
+{
+    if (pinnedNode >= 0)
+        return pinnedNode;
+    if (Cpus.size() == 1)
+        return 0;
+    return NodeOf(sched_getcpu());
+}
+
+NodeBuffer::NodeBuffer(size_t size, int node, bool hugePages) : Data(nullptr), Size(size), Mapped(0)
+{
+    if (size == 0)
+        return;
+    const size_t granule = hugePages ? hugePageSize : (size_t)sysconf(_SC_PAGESIZE);
+    Mapped = (size + granule - 1) / granule * granule;
+    void* addr = mmap(nullptr, Mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED)
+        throw std::runtime_error("Error while mapping memory.");
+    Data = addr;
+
+#ifdef MADV_HUGEPAGE
+    if (hugePages)
+        madvise(Data, Mapped, MADV_HUGEPAGE);
+#endif
+
+    // Policy must be set before the first touch, which allocates the pages; it is only a preference,
+    // so a full node falls back to others instead of failing.
+    const NumaTopology& topology = NumaTopology::System();
+    int kernelNode = node >= 0 && node < topology.getNumberOfNodes() ? topology.KernelNodes[node] : -1;
+#ifdef SYS_mbind
+    if (topology.getNumberOfNodes() > 1 && kernelNode >= 0 && kernelNode < 63)
+    {
+        unsigned long mask = 1UL << kernelNode;
+        syscall(SYS_mbind, Data, Mapped, preferredPolicy, &mask, 64UL, 0U);
+    }
+#else
+    (void)kernelNode;
+#endif
+}
+
+NodeBuffer::~NodeBuffer() noexcept
+{
+    if (Data != nullptr)
+        munmap(Data, Mapped);
+}
+
+NodeBuffer::NodeBuffer(NodeBuffer&& other) noexcept : Data(other.Data), Size(other.Size), Mapped(other.Mapped)
+{
+    other.Data = nullptr;
+    other.Size = other.Mapped = 0;
+}
+
+NodeBuffer& NodeBuffer::operator=(NodeBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (Data != nullptr)
+            munmap(Data, Mapped);
+        Data = other.Data;
+        Size = other.Size;
+        Mapped = other.Mapped;
+        other.Data = nullptr;
+        other.Size = other.Mapped = 0;
+    }
+    return *this;
+}
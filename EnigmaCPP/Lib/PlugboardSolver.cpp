@@ -0,0 +1,177 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "PlugboardSolver.h"
+#include "IocSearch.h"
+
+#include <random>
+#include <algorithm>
+
+using namespace Enigma;
+
+namespace
+{
+    /* Returns number of cables of a wiring. */
+    int CountCables(const PlugboardWiring& plugboard) noexcept
+    {
+        int cables = 0;
+        for (int i = 0; i < CompiledKey::alphabetLength; i++)
+            if (plugboard[i] > i)
+                cables++;
+        return cables;
+    }
+
+    /* Returns empty wiring. */
+    PlugboardWiring Identity() noexcept
+    {
+        PlugboardWiring plugboard;
+        for (int i = 0; i < CompiledKey::alphabetLength; i++)
+            plugboard[i] = (uint8_t)i;
+        return plugboard;
+    }
+}
+
+std::vector<std::string> PlugboardSolution::getConnections() const noexcept
+{
+    std::vector<std::string> connections;
+    for (int i = 0; i < CompiledKey::alphabetLength; i++)
+        if (Plugboard[i] > i)
+            connections.push_back(std::string{(char)('A' + i), (char)('A' + Plugboard[i])});
+    return connections;
+}
+
+PlugboardSolver::PlugboardSolver(const UserSettings& RotorSettings, const std::string& CipherText)
+    : Text(CompiledKey::ToIndices(CipherText))
+{
+    UserSettings core = RotorSettings;
+    core.setPlugboard(std::vector<std::string>());
+    CompiledKey key(core);
+    RotorPositions positions = CompiledKey::PositionsOf(core);
+
+    Core.resize(Text.size() * CompiledKey::alphabetLength);
+    for (size_t i = 0; i < Text.size(); i++)
+    {
+        key.Step(positions);
+        for (int letter = 0; letter < CompiledKey::alphabetLength; letter++)
+            Core[i * CompiledKey::alphabetLength + letter] = (uint8_t)key.PermuteIndex(letter, positions);
+    }
+}
+
+void PlugboardSolver::Decrypt(const PlugboardWiring& plugboard, uint8_t* out) const noexcept
+{
+    const uint8_t* core = Core.data();
+    for (size_t i = 0; i < Text.size(); i++, core += CompiledKey::alphabetLength)
+        out[i] = plugboard[core[plugboard[Text[i]]]];
+}
+
+double PlugboardSolver::Evaluate(const PlugboardWiring& plugboard, const NgramModel* model, uint8_t* buffer) const noexcept
+{
+    Decrypt(plugboard, buffer);
+    if (model == nullptr)
+        return IocSearch::IndexOfCoincidence(buffer, Text.size());
+    return model->Score(buffer, Text.size());
+}
+
+PlugboardSolution PlugboardSolver::Climb(PlugboardWiring start, const std::vector<const NgramModel*>& Models, const PlugboardSolverOptions& options) const noexcept
+{
+    std::vector<const NgramModel*> stages;
+    if (options.IocStage || Models.empty())
+        stages.push_back(nullptr);
+    stages.insert(stages.end(), Models.begin(), Models.end());
+
+    std::vector<uint8_t> buffer(Text.size());
+    PlugboardWiring current = start;
+    double score = 0;
+    for (const NgramModel* model : stages)
+    {
+        score = Evaluate(current, model, buffer.data());
+        bool improved = true;
+        while (improved)
+        {
+            improved = false;
+            for (int i = 0; i < CompiledKey::alphabetLength; i++)
+                for (int j = i + 1; j < CompiledKey::alphabetLength; j++)
+                {
+                    // Candidates: remove cable i-j, or plug i-j leaving their partners free, or plug i-j and the partners together.
+                    PlugboardWiring candidates[2];
+                    int count = 0;
+                    const int pi = current[i], pj = current[j];
+                    if (pi == j)
+                    {
+                        candidates[0] = current;
+                        candidates[0][i] = (uint8_t)i;
+                        candidates[0][j] = (uint8_t)j;
+                        count = 1;
+                    }
+                    else
+                    {
+                        PlugboardWiring swapped = current;
+                        swapped[pi] = (uint8_t)pi;
+                        swapped[pj] = (uint8_t)pj;
+                        swapped[i] = (uint8_t)j;
+                        swapped[j] = (uint8_t)i;
+                        if (CountCables(swapped) <= options.MaxCables)
+                            candidates[count++] = swapped;
+                        if (pi != i && pj != j)
+                        {
+                            swapped[pi] = (uint8_t)pj;
+                            swapped[pj] = (uint8_t)pi;
+                            candidates[count++] = swapped;
+                        }
+                    }
+
+                    for (int c = 0; c < count; c++)
+                    {
+                        double candidateScore = Evaluate(candidates[c], model, buffer.data());
+                        if (candidateScore > score)
+                        {
+                            score = candidateScore;
+                            current = candidates[c];
+                            improved = true;
+                            break;
+                        }
+                    }
+                }
+        }
+    }
+
+    PlugboardSolution res;
+    res.Score = score;
+    res.Plugboard = current;
+    res.Restart = 0;
+    return res;
+}
+
+PlugboardSolution PlugboardSolver::Solve(const std::vector<const NgramModel*>& Models, const PlugboardSolverOptions& options, ThreadPool& pool) const noexcept
+{
+    const int restarts = std::max(options.Restarts, 1);
+    std::vector<PlugboardSolution> results(restarts);
+
+    pool.ParallelFor(restarts, [&](size_t r) {
+        PlugboardWiring start = Identity();
+        if (r > 0)
+        {
+            // Every run has its own generator, so the result does not depend on scheduling.
+            std::mt19937_64 random(options.Seed + r);
+            std::array<uint8_t, 26> letters = Identity();
+            std::shuffle(letters.begin(), letters.end(), random);
+            int maxCables = std::min(std::max(options.MaxCables, 0), CompiledKey::alphabetLength / 2);
+            int cables = (int)(random() % (maxCables + 1));
+            for (int c = 0; c < cables; c++)
+            {
+                start[letters[2 * c]] = letters[2 * c + 1];
+                start[letters[2 * c + 1]] = letters[2 * c];
+            }
+        }
+        results[r] = Climb(start, Models, options);
+        results[r].Restart = (int)r;
+    });
+
+    PlugboardSolution best = results[0];
+    for (const PlugboardSolution& res : results)
+        if (res.Score > best.Score)
+            best = res;
+    return best;
+}
@@ -0,0 +1,69 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "RingClasses.h"
+
+#include <map>
+
+using namespace Enigma;
+
+namespace
+{
+    const int alphabetLength = CompiledKey::alphabetLength;
+
+    /**
+     * Steps the rotors through @length presses from given distances to the notches, same rules as CompiledKey::Step.
+     * Returns presses where the middle rotor steps, times 2, plus 1 if the left rotor steps with it.
+     */
+    std::vector<uint32_t> Turnovers(int rightDistance, int middleDistance, size_t length) noexcept
+    {
+        std::vector<uint32_t> turnovers;
+        for (size_t press = 0; press < length; press++)
+        {
+            if (middleDistance == 0)
+            {
+                turnovers.push_back((uint32_t)press * 2 + 1);
+                middleDistance = alphabetLength - 1;
+            }
+            else if (rightDistance == 0)
+            {
+                turnovers.push_back((uint32_t)press * 2);
+                middleDistance--;
+            }
+            rightDistance = rightDistance == 0 ? alphabetLength - 1 : rightDistance - 1;
+        }
+        return turnovers;
+    }
+
+    inline int Mod(int i) noexcept
+    {
+        return ((i % alphabetLength) + alphabetLength) % alphabetLength;
+    }
+}
+
+RingClasses::RingClasses(size_t MessageLength) noexcept : MessageLength(MessageLength)
+{
+    std::map<std::vector<uint32_t>, int> known;
+    for (int right = 0; right < alphabetLength; right++)
+        for (int middle = 0; middle < alphabetLength; middle++)
+        {
+            auto it = known.insert(std::make_pair(Turnovers(right, middle, MessageLength), (int)Representatives.size())).first;
+            if (it->second == (int)Representatives.size())
+                Representatives.push_back({{right, middle}});
+            Classes[right * alphabetLength + middle] = it->second;
+        }
+}
+
+void RingClasses::Canonicalize(const int* notches, RotorPositions& positions, std::array<int, 3>& rings) const noexcept
+{
+    const std::array<int, 2>& rep = Representatives[ClassOf(Distance(notches[2], positions[2]), Distance(notches[1], positions[1]))];
+    RotorPositions offsets;
+    for (int i = 0; i < 3; i++)
+        offsets[i] = Mod(positions[i] - rings[i]);
+
+    positions = {{offsets[0], Mod(notches[1] - rep[1]), Mod(notches[2] - rep[0])}};
+    for (int i = 0; i < 3; i++)
+        rings[i] = Mod(positions[i] - offsets[i]);
+}
@@ -0,0 +1,116 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include "CompiledKey.h"
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Enigma
+{
+    /**
+     * Equivalence classes of ring settings over a message of given length.
+     *
+     * The permutation of a key press depends only on the core offset (position - ring setting) of every rotor,
+     * ring settings matter only through the presses where the middle and the left rotors step.
+     * Those presses are fixed by the distances of the right and the middle rotor windows to their notches
+     * at the start, and two distances behave the same if they differ only past the end of the message.
+     * The left ring setting never matters.
+     *
+     * So a search over all positions and rings needs one key per core offset and class: the representative class
+     * distances give the start windows of the middle and the right rotors, the left ring setting is always 0
+     * and the ring settings are the windows minus the offsets. Up to 26 x 26 times fewer keys than the raw product.
+     */
+    class RingClasses
+    {
+    public:
+        /* Number of (position, ring setting) combinations of all three rotors giving the same core offset. */
+        static const uint64_t settingsPerOffset = (uint64_t)CompiledKey::alphabetLength * CompiledKey::alphabetLength * CompiledKey::alphabetLength;
+
+        /**
+         * Constructor, computes the classes by stepping all 26 x 26 distances through the message.
+         *
+         * Params:
+         * size_t MessageLength - number of letters of the message.
+         */
+        explicit RingClasses(size_t MessageLength) noexcept;
+
+        /**
+         * Returns distance of a window to the notch, the number of steps before the rotor is at its notch.
+         *
+         * Params:
+         * int notch - turnover position of the rotor (CompiledKey::getNotches()).
+         * int window - position of the rotor.
+         *
+         * Returns:
+         * int - distance (0 - 25).
+         */
+        static inline int Distance(int notch, int window) noexcept
+        {
+            return ((notch - window) % CompiledKey::alphabetLength + CompiledKey::alphabetLength) % CompiledKey::alphabetLength;
+        }
+
+        /**
+         * Returns the class of start windows.
+         *
+         * Params:
+         * int rightDistance - distance of the right rotor window to its notch.
+         * int middleDistance - distance of the middle rotor window to its notch.
+         *
+         * Returns:
+         * int - index of the class in [0, size()).
+         */
+        int ClassOf(int rightDistance, int middleDistance) const noexcept { return Classes[rightDistance * CompiledKey::alphabetLength + middleDistance]; }
+
+        /**
+         * Checks if given distances are the representative of their class.
+         *
+         * Params:
+         * int rightDistance - distance of the right rotor window to its notch.
+         * int middleDistance - distance of the middle rotor window to its notch.
+         *
+         * Returns:
+         * bool - true for exactly one pair of distances per class.
+         */
+        bool isRepresentative(int rightDistance, int middleDistance) const noexcept
+        {
+            const std::array<int, 2>& rep = Representatives[ClassOf(rightDistance, middleDistance)];
+            return rep[0] == rightDistance && rep[1] == middleDistance;
+        }
+
+        /**
+         * Replaces settings with the representative of their class, which encrypts the message the same way.
+         *
+         * Params:
+         * const int* notches - turnover positions of the rotors from left to right (CompiledKey::getNotches()).
+         * RotorPositions& positions - start position, will be replaced.
+         * std::array<int, 3>& rings - ring settings, will be replaced.
+         */
+        void Canonicalize(const int* notches, RotorPositions& positions, std::array<int, 3>& rings) const noexcept;
+
+        /* Number of classes per core offset. */
+        size_t size() const noexcept { return Representatives.size(); }
+
+        /* Number of letters the classes were computed for. */
+        size_t getMessageLength() const noexcept { return MessageLength; }
+
+        /* Representative (right, middle) distances of every class. */
+        const std::vector<std::array<int, 2>>& getRepresentatives() const noexcept { return Representatives; }
+
+    private:
+        /* Number of letters of the message. */
+        size_t MessageLength;
+
+        /* Class of every (right, middle) distance. */
+        std::array<int, CompiledKey::alphabetLength * CompiledKey::alphabetLength> Classes;
+
+        /* First (right, middle) distance of every class. */
+        std::vector<std::array<int, 2>> Representatives;
+    };
+}
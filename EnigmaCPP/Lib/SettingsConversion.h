@@ -26,7 +26,16 @@ namespace Enigma
         /* Map from ReflectorID of the reflector to a corresponding alphabet. Defined in the cpp file. */
         static std::unordered_map<ReflectorID, std::string> ReflectorInfo;
 
+        friend class CompiledKey;
+
     public:
+        /**
+         * Version of the wiring tables (RotorInfo and ReflectorInfo).
+         * Must be increased whenever any alphabet or notch changes,
+         * data derived from the tables and stored on disk is invalidated by it.
+        */
+        const static unsigned WiringTableVersion = 1;
+
         /**
          * Converts UserSettings to EnigmaSetttings.
          * 
@@ -0,0 +1,193 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "TextStatistics.h"
+
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace Enigma;
+
+namespace
+{
+#if defined(__AVX512BW__)
+    typedef uint8_t Bytes __attribute__((vector_size(64)));
+#elif defined(__AVX2__)
+    typedef uint8_t Bytes __attribute__((vector_size(32)));
+#else
+    typedef uint8_t Bytes __attribute__((vector_size(16)));
+#endif
+
+    const size_t width = sizeof(Bytes);
+
+    /* Vectors counted in byte lanes before the lanes are added to the totals, so they cannot overflow. */
+    const size_t flushInterval = 255;
+
+    /* Letters counted in one sweep over a block, so the lane counters stay in registers. */
+    const int lettersPerSweep = 13;
+
+    /* Folds lower case letters to upper case; no other byte becomes a letter. */
+    const uint8_t upperCaseMask = 0xDF;
+
+    /* Sum of the byte lanes of @v. */
+    inline uint64_t Sum(const Bytes& v) noexcept
+    {
+#if defined(__AVX512BW__)
+        return _mm512_reduce_add_epi64(_mm512_sad_epu8((__m512i)v, _mm512_setzero_si512()));
+#elif defined(__AVX2__)
+        __m256i sums = _mm256_sad_epu8((__m256i)v, _mm256_setzero_si256());
+        return _mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1) + _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3);
+#elif defined(__SSE2__)
+        __m128i sums = _mm_sad_epu8((__m128i)v, _mm_setzero_si128());
+        return (uint64_t)_mm_cvtsi128_si64(sums) + (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums));
+#else
+        uint64_t sum = 0;
+        for (size_t i = 0; i < width; i++)
+            sum += v[i];
+        return sum;
+#endif
+    }
+
+    inline Bytes Load(const char* p) noexcept
+    {
+        Bytes v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+}
+
+TextStatistics::TextStatistics() noexcept : NumberOfBytes(0)
+{
+    std::fill(Counts, Counts + alphabetLength, 0);
+}
+
+int TextStatistics::getVectorWidth() noexcept
+{
+    return width;
+}
+
+void TextStatistics::Add(const char* data, size_t size) noexcept
+{
+    NumberOfBytes += size;
+    const size_t vectors = size / width;
+
+    for (size_t first = 0; first < vectors; first += flushInterval)
+    {
+        const size_t block = std::min(flushInterval, vectors - first);
+        const char* begin = data + first * width;
+        // The block (at most 255 vectors) stays in L1 between the sweeps.
+        for (int sweep = 0; sweep < alphabetLength; sweep += lettersPerSweep)
+        {
+            Bytes lanes[lettersPerSweep];
+            for (Bytes& lane : lanes)
+                lane = Bytes{};
+            for (size_t v = 0; v < block; v++)
+            {
+                Bytes upper = Load(begin + v * width) & upperCaseMask;
+                for (int letter = 0; letter < lettersPerSweep; letter++)
+                    lanes[letter] -= (Bytes)(upper == (uint8_t)('A' + sweep + letter));
+            }
+            for (int letter = 0; letter < lettersPerSweep; letter++)
+                Counts[sweep + letter] += Sum(lanes[letter]);
+        }
+    }
+
+    for (size_t i = vectors * width; i < size; i++)
+    {
+        uint8_t upper = (uint8_t)data[i] & upperCaseMask;
+        if (upper >= 'A' && upper <= 'Z')
+            Counts[upper - 'A']++;
+    }
+}
+
+void TextStatistics::Merge(const TextStatistics& other) noexcept
+{
+    NumberOfBytes += other.NumberOfBytes;
+    for (int letter = 0; letter < alphabetLength; letter++)
+        Counts[letter] += other.Counts[letter];
+}
+
+uint64_t TextStatistics::getLetters() const noexcept
+{
+    uint64_t letters = 0;
+    for (int letter = 0; letter < alphabetLength; letter++)
+        letters += Counts[letter];
+    return letters;
+}
+
+double TextStatistics::IndexOfCoincidence() const noexcept
+{
+    const uint64_t letters = getLetters();
+    if (letters < 2)
+        return 0;
+    double sum = 0;
+    for (int letter = 0; letter < alphabetLength; letter++)
+        sum += (double)Counts[letter] * (Counts[letter] - 1);
+    return sum / ((double)letters * (letters - 1));
+}
+
+RepeatStatistics::RepeatStatistics() : Letters(0), Code(0), Repeats(0), Last(1 << (3 * letterBits), 0), Spacings(maxSpacing + 2, 0)
+{
+}
+
+void RepeatStatistics::Add(const char* data, size_t size) noexcept
+{
+    const uint32_t codeMask = (1 << (3 * letterBits)) - 1;
+    // Members in locals, so they stay in registers while the tables are written.
+    uint64_t letters = Letters, repeats = Repeats;
+    uint32_t code = Code;
+    uint64_t* last = Last.data();
+    uint64_t* spacings = Spacings.data();
+    for (size_t i = 0; i < size; i++)
+    {
+        uint8_t upper = (uint8_t)data[i] & upperCaseMask;
+        if (upper < 'A' || upper > 'Z')
+            continue;
+        code = ((code << letterBits) | (upper - 'A')) & codeMask;
+        if (++letters < 3)
+            continue;
+        // Without branches on the spacing, which is random in a ciphertext: a first occurrence adds 0, long spacings go to the last counter.
+        uint64_t spacing = letters - last[code];
+        spacings[spacing <= maxSpacing ? spacing : maxSpacing + 1] += last[code] != 0;
+        repeats += last[code] != 0;
+        last[code] = letters;
+    }
+    Letters = letters;
+    Repeats = repeats;
+    Code = code;
+}
+
+std::vector<std::pair<uint32_t, uint64_t>> RepeatStatistics::TopSpacings(size_t count) const
+{
+    std::vector<std::pair<uint32_t, uint64_t>> res;
+    for (uint32_t spacing = 1; spacing <= maxSpacing; spacing++)
+        if (Spacings[spacing])
+            res.push_back(std::make_pair(spacing, Spacings[spacing]));
+    auto before = [](const std::pair<uint32_t, uint64_t>& a, const std::pair<uint32_t, uint64_t>& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    };
+    if (res.size() > count)
+    {
+        std::partial_sort(res.begin(), res.begin() + count, res.end(), before);
+        res.resize(count);
+    }
+    else
+        std::sort(res.begin(), res.end(), before);
+    return res;
+}
+
+uint64_t RepeatStatistics::getPeriodCount(int period) const noexcept
+{
+    if (period < 2 || period > maxPeriod)
+        return 0;
+    uint64_t res = 0;
+    for (uint32_t spacing = period; spacing <= maxSpacing; spacing += period)
+        res += Spacings[spacing];
+    return res;
+}
@@ -0,0 +1,179 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <utility>
+
+namespace Enigma
+{
+    /**
+     * Letter frequencies and index of coincidence of a text, accumulated block by block in one pass.
+     *
+     * Letters are counted case-insensitively, like Encoder::EncryptString reads them; other bytes are skipped.
+     * A vector of bytes is folded to upper case with one AND and compared with every letter broadcast;
+     * matches are subtracted (-1 per matching lane) from per-lane byte counters, which are added
+     * to the 64-bit totals before they can overflow. Blocks of any size and alignment can be added,
+     * and statistics of pieces of a text can be merged.
+     */
+    class TextStatistics
+    {
+    public:
+        /* Number of counted letters, A - Z. */
+        static const int alphabetLength = 26;
+
+        /* Constructor, empty statistics. */
+        TextStatistics() noexcept;
+
+        /**
+         * Adds a block of text.
+         *
+         * Params:
+         * const char* data - bytes.
+         * size_t size - number of bytes.
+         */
+        void Add(const char* data, size_t size) noexcept;
+
+        /**
+         * Adds statistics of another piece of text.
+         *
+         * Params:
+         * const TextStatistics& other - statistics.
+         */
+        void Merge(const TextStatistics& other) noexcept;
+
+        /**
+         * Returns number of added bytes.
+         *
+         * Returns:
+         * uint64_t - bytes.
+         */
+        uint64_t getBytes() const noexcept { return NumberOfBytes; }
+
+        /**
+         * Returns number of letters.
+         *
+         * Returns:
+         * uint64_t - letters.
+         */
+        uint64_t getLetters() const noexcept;
+
+        /**
+         * Returns number of occurrences of a letter.
+         *
+         * Params:
+         * int letter - letter, 0 - 25 for A - Z.
+         *
+         * Returns:
+         * uint64_t - occurrences.
+         */
+        uint64_t getCount(int letter) const noexcept { return Counts[letter]; }
+
+        /**
+         * Computes index of coincidence of the letters, same as IocSearch::IndexOfCoincidence.
+         *
+         * Returns:
+         * double - index of coincidence, 0 for less than 2 letters.
+         */
+        double IndexOfCoincidence() const noexcept;
+
+        /**
+         * Returns number of bytes compared at once.
+         *
+         * Returns:
+         * int - 64 with AVX-512BW, 32 with AVX2, otherwise 16.
+         */
+        static int getVectorWidth() noexcept;
+
+    private:
+        /* Number of added bytes. */
+        uint64_t NumberOfBytes;
+
+        /* Occurrences of every letter. */
+        uint64_t Counts[alphabetLength];
+    };
+
+    /**
+     * Kasiski examination of a text: spacings between repeated trigrams and the periods they suggest.
+     *
+     * Letters are read like in TextStatistics, other bytes are skipped, so trigrams span them.
+     * Every trigram is compared with its previous occurrence only, one table lookup per letter and no branch on the spacing.
+     * Spacings up to maxSpacing are counted one by one; a period counts the spacings it divides.
+     * Blocks of any size can be added, a trigram may span two blocks.
+     */
+    class RepeatStatistics
+    {
+    public:
+        /* Longest spacing counted, the period of the rotors without double steps (26 * 25 * 26). */
+        static const uint32_t maxSpacing = 16900;
+
+        /* Longest period counted. */
+        static const int maxPeriod = 26;
+
+        /* Constructor, empty statistics. */
+        RepeatStatistics() noexcept(false);
+
+        /**
+         * Adds a block of text.
+         *
+         * Params:
+         * const char* data - bytes.
+         * size_t size - number of bytes.
+         */
+        void Add(const char* data, size_t size) noexcept;
+
+        /**
+         * Returns number of repeated trigrams, including ones further than maxSpacing apart.
+         *
+         * Returns:
+         * uint64_t - repeats.
+         */
+        uint64_t getRepeats() const noexcept { return Repeats; }
+
+        /**
+         * Returns the most frequent spacings.
+         *
+         * Params:
+         * size_t count - maximal number of spacings.
+         *
+         * Returns:
+         * std::vector<std::pair<uint32_t, uint64_t>> - spacing and number of repeats, most frequent (then shortest) first.
+         */
+        std::vector<std::pair<uint32_t, uint64_t>> TopSpacings(size_t count) const noexcept(false);
+
+        /**
+         * Returns number of counted spacings divisible by a period.
+         *
+         * Params:
+         * int period - 2 - maxPeriod.
+         *
+         * Returns:
+         * uint64_t - spacings.
+         */
+        uint64_t getPeriodCount(int period) const noexcept;
+
+    private:
+        /* Bits of a letter in the code of a trigram. */
+        static const int letterBits = 5;
+
+        /* Number of letters read. */
+        uint64_t Letters;
+
+        /* Code of the last three letters, letterBits each. */
+        uint32_t Code;
+
+        /* Number of repeated trigrams. */
+        uint64_t Repeats;
+
+        /* Position of the last occurrence of every trigram plus 1, 0 if not seen. */
+        std::vector<uint64_t> Last;
+
+        /* Repeats with every spacing up to maxSpacing, then repeats with longer spacings. */
+        std::vector<uint64_t> Spacings;
+    };
+}
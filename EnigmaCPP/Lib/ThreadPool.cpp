@@ -0,0 +1,109 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "ThreadPool.h"
+
+using namespace Enigma;
+
+namespace
+{
+    ThreadPoolOptions OptionsOf(int NumberOfThreads) noexcept
+    {
+        ThreadPoolOptions options;
+        options.NumberOfThreads = NumberOfThreads;
+        return options;
+    }
+}
+
+ThreadPool::ThreadPool(int NumberOfThreads) : ThreadPool(OptionsOf(NumberOfThreads))
+{
+}
+
+ThreadPool::ThreadPool(const ThreadPoolOptions& options)
+    : Task(nullptr), Count(0), Next(0), Busy(0), Placement(options.Placement), Generation(0), Stopping(false)
+{
+    int NumberOfThreads = options.NumberOfThreads;
+    if (NumberOfThreads < 1)
+        NumberOfThreads = (int)std::thread::hardware_concurrency();
+    if (NumberOfThreads < 1)
+        NumberOfThreads = 1;
+    // Slot 0 is the caller's.
+    std::vector<int> cpus = NumaTopology::System().Place(NumberOfThreads, Placement);
+    for (int i = 1; i < NumberOfThreads; i++)
+        Workers.emplace_back(&ThreadPool::WorkerLoop, this, cpus.empty() ? -1 : cpus[i]);
+}
+
+ThreadPool::~ThreadPool() noexcept
+{
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+        Stopping = true;
+    }
+    WakeUp.notify_all();
+    for (std::thread& worker : Workers)
+        worker.join();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& task) noexcept
+{
+    if (count == 0)
+        return;
+    if (Workers.empty() || count == 1)
+    {
+        for (size_t i = 0; i < count; i++)
+            task(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+        Task = &task;
+        Count = count;
+        Next = 0;
+        Busy = (int)Workers.size();
+        Generation++;
+    }
+    WakeUp.notify_all();
+
+    Drain(task, count);
+
+    std::unique_lock<std::mutex> guard(Lock);
+    Finished.wait(guard, [this] { return Busy == 0; });
+    Task = nullptr;
+}
+
+void ThreadPool::Drain(const std::function<void(size_t)>& task, size_t count) noexcept
+{
+    for (size_t i = Next++; i < count; i = Next++)
+        task(i);
+}
+
+void ThreadPool::WorkerLoop(int cpu) noexcept
+{
+    if (cpu >= 0)
+        NumaTopology::System().PinCurrentThread(cpu);
+
+    unsigned long seen = 0;
+    while (true)
+    {
+        const std::function<void(size_t)>* task;
+        size_t count;
+        {
+            std::unique_lock<std::mutex> guard(Lock);
+            WakeUp.wait(guard, [this, seen] { return Stopping || Generation != seen; });
+            if (Stopping)
+                return;
+            seen = Generation;
+            task = Task;
+            count = Count;
+        }
+
+        Drain(*task, count);
+
+        std::lock_guard<std::mutex> guard(Lock);
+        if (--Busy == 0)
+            Finished.notify_one();
+    }
+}
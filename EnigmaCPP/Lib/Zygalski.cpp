@@ -0,0 +1,250 @@
+/**
+ * LibEnigmaCPP
+ * Wojciech Kieloch 2023
+*/
+
+#include "Zygalski.h"
+#include "EnigmaCPP.h"
+#include "IocSearch.h"
+#include "KeystreamTable.h"
+
+#include <chrono>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace Enigma;
+
+namespace
+{
+#if defined(__AVX2__)
+    typedef uint32_t Rows __attribute__((vector_size(32)));
+#else
+    typedef uint32_t Rows __attribute__((vector_size(16)));
+#endif
+
+    const int alphabetLength = CompiledKey::alphabetLength;
+    const int rowsPerVector = sizeof(Rows) / sizeof(uint32_t);
+    const uint32_t rowMask = (1u << alphabetLength) - 1;
+
+    /* Rows of a left offset, 26 used and padded to whole vectors. */
+    const int rowStride = 32;
+
+    /* Rows of a left offset in a sheet: the 26 middle offsets twice, so a shifted window is contiguous, and padding. */
+    const int sheetStride = 64;
+
+    static_assert(rowStride % rowsPerVector == 0 && alphabetLength - 1 + rowStride <= sheetStride, "Invalid strides.");
+
+    /**
+     * Sheet of a female pair, stored negated: row (a, b) bit c is set if a female can occur at core offset (-a, -b, -c).
+     * A message with Grundstellung G then allows rings R if row (R_l - G_l, R_m - G_m) rotated by G_r has bit R_r set.
+     */
+    struct Sheet
+    {
+        uint32_t Rows[alphabetLength * sheetStride];
+    };
+
+    /* Bitmap of ring settings: row (left, middle) bit right. */
+    struct RingBitmap
+    {
+        uint32_t Rows[alphabetLength * rowStride];
+    };
+
+    /* Female of an indicator, with the Grundstellung as alphabet indices. */
+    struct Female
+    {
+        RotorPositions Grundstellung;
+        int Pair;
+        size_t Message;
+    };
+
+    inline int Mod(int i) noexcept
+    {
+        return ((i % alphabetLength) + alphabetLength) % alphabetLength;
+    }
+
+    inline Rows Load(const uint32_t* p) noexcept
+    {
+        Rows v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    /* Builds the sheet of female pair @pair out of a table built with rings AAA (state = core offset). */
+    void BuildSheet(const KeystreamTable& table, int pair, Sheet& sheet) noexcept
+    {
+        std::memset(sheet.Rows, 0, sizeof(sheet.Rows));
+        for (int l = 0; l < alphabetLength; l++)
+            for (int m = 0; m < alphabetLength; m++)
+            {
+                uint32_t row = 0;
+                for (int r = 0; r < alphabetLength; r++)
+                {
+                    const uint8_t* first = table.getPermutation({{l, m, (r + 1 + pair) % alphabetLength}});
+                    const uint8_t* second = table.getPermutation({{l, m, (r + 4 + pair) % alphabetLength}});
+                    bool possible = false;
+                    for (int x = 0; x < alphabetLength && !possible; x++)
+                        possible = first[x] == second[x];
+                    row |= (uint32_t)possible << Mod(-r);
+                }
+                uint32_t* rows = sheet.Rows + Mod(-l) * sheetStride;
+                rows[Mod(-m)] = rows[Mod(-m) + alphabetLength] = row;
+            }
+    }
+
+    /* ANDs the sheet shifted by @grundstellung into @rings, returns false if no ring setting is left. */
+    bool Apply(const Sheet& sheet, const RotorPositions& grundstellung, RingBitmap& rings) noexcept
+    {
+        const int rotation = grundstellung[2];
+        Rows any = {};
+        for (int l = 0; l < alphabetLength; l++)
+        {
+            const uint32_t* source = sheet.Rows + Mod(l - grundstellung[0]) * sheetStride + Mod(-grundstellung[1]);
+            uint32_t* target = rings.Rows + l * rowStride;
+            for (int i = 0; i < rowStride; i += rowsPerVector)
+            {
+                Rows v = Load(source + i);
+                v = ((v << rotation) | (v >> (alphabetLength - rotation))) & rowMask;
+                Rows acc;
+                std::memcpy(&acc, target + i, sizeof(acc));
+                acc &= v;
+                std::memcpy(target + i, &acc, sizeof(acc));
+                any |= acc;
+            }
+        }
+        for (int i = 0; i < rowsPerVector; i++)
+            if (any[i])
+                return true;
+        return false;
+    }
+
+    bool SurvivorBefore(const ZygalskiSurvivor& a, const ZygalskiSurvivor& b) noexcept
+    {
+        if (a.Verified != b.Verified)
+            return a.Verified;
+        if (a.Reflector != b.Reflector)
+            return a.Reflector < b.Reflector;
+        if (a.Rotors != b.Rotors)
+            return a.Rotors < b.Rotors;
+        return a.Rings < b.Rings;
+    }
+}
+
+bool ZygalskiSheets::AllowsFemale(const ZygalskiSurvivor& settings, const std::string& grundstellung, int pair)
+{
+    std::vector<UserRotor> rotors;
+    for (int i = 0; i < 3; i++)
+        rotors.push_back(UserRotor(settings.Rotors[i], grundstellung[i], (char)('A' + settings.Rings[i])));
+    UserSettings user(settings.Reflector, rotors, std::vector<std::string>());
+    for (char letter = 'A'; letter <= 'Z'; letter++)
+    {
+        Encoder encoder(user);
+        std::string indicator = encoder.EncryptString(std::string(6, letter));
+        if (indicator[pair] == indicator[pair + 3])
+            return true;
+    }
+    return false;
+}
+
+ZygalskiResult ZygalskiSheets::Run(const std::vector<ZygalskiIndicator>& indicators, const ZygalskiOptions& options, ThreadPool& pool)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    // Grundstellung of every message upper-cased, so the verification inside the pool gets only valid positions.
+    std::vector<std::string> grundstellungen(indicators.size());
+    std::vector<Female> females;
+    for (size_t m = 0; m < indicators.size(); m++)
+    {
+        std::vector<uint8_t> position = CompiledKey::ToIndices(indicators[m].Grundstellung);
+        std::vector<uint8_t> letters = CompiledKey::ToIndices(indicators[m].Indicator);
+        if (position.size() != 3 || indicators[m].Grundstellung.size() != 3)
+            throw std::runtime_error("Grundstellung must be 3 letters.");
+        if (letters.size() != 6 || indicators[m].Indicator.size() != 6)
+            throw std::runtime_error("Indicator must be 6 letters.");
+        for (uint8_t letter : position)
+            grundstellungen[m] += (char)('A' + letter);
+        for (int pair = 0; pair < 3; pair++)
+            if (letters[pair] == letters[pair + 3])
+                females.push_back({{{position[0], position[1], position[2]}}, pair, m});
+    }
+
+    std::vector<std::array<RotorID, 3>> orders = IocSearch::WheelOrders();
+    const size_t tasks = options.Reflectors.size() * orders.size();
+    std::vector<std::vector<ZygalskiSurvivor>> survivors(tasks);
+    std::vector<uint64_t> counts(tasks, 0), applied(tasks, 0);
+
+    pool.ParallelFor(tasks, [&](size_t t) {
+        ReflectorID reflector = options.Reflectors[t / orders.size()];
+        const std::array<RotorID, 3>& order = orders[t % orders.size()];
+        uint8_t plugboard[alphabetLength];
+        for (int i = 0; i < alphabetLength; i++)
+            plugboard[i] = (uint8_t)i;
+        std::array<int, 3> noRings = {{0, 0, 0}};
+        KeystreamTable table{CompiledKey(reflector, order, noRings, plugboard)};
+        std::vector<uint16_t> next = table.NextStates();
+
+        // Females of this wheel order: the right rotor alone steps during the indicator.
+        std::vector<const Female*> used;
+        for (const Female& female : females)
+        {
+            int start = KeystreamTable::StateIndex(female.Grundstellung), state = start;
+            for (int i = 0; i < 6; i++)
+                state = next[state];
+            if (state / alphabetLength == start / alphabetLength)
+                used.push_back(&female);
+        }
+
+        std::unique_ptr<Sheet[]> sheets(new Sheet[3]);
+        bool built[3] = {false, false, false};
+        std::unique_ptr<RingBitmap> rings(new RingBitmap);
+        for (int i = 0; i < alphabetLength * rowStride; i++)
+            rings->Rows[i] = i % rowStride < alphabetLength ? rowMask : 0;
+
+        bool left = true;
+        for (size_t f = 0; f < used.size() && left; f++)
+        {
+            int pair = used[f]->Pair;
+            if (!built[pair])
+            {
+                BuildSheet(table, pair, sheets[pair]);
+                built[pair] = true;
+            }
+            left = Apply(sheets[pair], used[f]->Grundstellung, *rings);
+            applied[t]++;
+        }
+        if (!left)
+            return;
+
+        for (int l = 0; l < alphabetLength; l++)
+            for (int m = 0; m < alphabetLength; m++)
+                for (uint32_t bits = rings->Rows[l * rowStride + m] & rowMask; bits; bits &= bits - 1)
+                {
+                    if (++counts[t] > options.MaxSurvivors)
+                        continue;
+                    ZygalskiSurvivor survivor;
+                    survivor.Reflector = reflector;
+                    survivor.Rotors = order;
+                    survivor.Rings = {{l, m, __builtin_ctz(bits)}};
+                    // Every used female, with real stepping and ring settings.
+                    survivor.Verified = true;
+                    for (size_t f = 0; f < used.size() && survivor.Verified; f++)
+                        survivor.Verified = AllowsFemale(survivor, grundstellungen[used[f]->Message], used[f]->Pair);
+                    survivors[t].push_back(survivor);
+                }
+    });
+
+    ZygalskiResult res;
+    res.NumberOfSurvivors = 0;
+    res.SheetsApplied = 0;
+    res.Females = females.size();
+    for (size_t t = 0; t < tasks; t++)
+    {
+        res.Survivors.insert(res.Survivors.end(), survivors[t].begin(), survivors[t].end());
+        res.NumberOfSurvivors += counts[t];
+        res.SheetsApplied += applied[t];
+    }
+    std::sort(res.Survivors.begin(), res.Survivors.end(), SurvivorBefore);
+    res.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return res;
+}
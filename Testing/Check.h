@@ -0,0 +1,35 @@
+/**
+ * EnigmaCPP tests
+ * Wojciech Kieloch 2023
+*/
+
+#pragma once
+
+#include <cstdio>
+
+/* Number of failed checks of the test program. */
+inline int& Failures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+/* Reports a failed check, the test program exits with 1 if there was any. */
+inline void Check(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        std::printf("FAILED: %s\n", what);
+        Failures()++;
+    }
+}
+
+/* Prints the result and returns the exit code of the test program. */
+inline int Finish(const char* name)
+{
+    if (Failures() == 0)
+        std::printf("%s: OK\n", name);
+    else
+        std::printf("%s: %d check(s) failed\n", name, Failures());
+    return Failures() == 0 ? 0 : 1;
+}
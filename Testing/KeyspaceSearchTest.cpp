@@ -0,0 +1,152 @@
+/**
+ * EnigmaCPP tests
+ * Wojciech Kieloch 2023
+*/
+
+/**
+ * Checkpoints of KeyspaceSearch: a run stopped partway (by MaxKeys or Stop) and resumed from its checkpoint
+ * until complete must give the same top-K as an uninterrupted run, in exhaustive and in sampling mode.
+ * A checkpoint of another search (other fingerprint or number of shards) must be rejected.
+*/
+
+#include "Check.h"
+
+#include "EnigmaCPP.h"
+#include "KeyspaceSearch.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <stdexcept>
+
+#include <unistd.h>
+
+using namespace Enigma;
+
+namespace
+{
+    const std::string plainText =
+        "DASOBERKOMMANDODERWEHRMACHTGIBTBEKANNTDASSDIEBEFESTIGUNGENAMWESTWALLPLANMAESSIGVERSTAERKTWURDEN";
+
+    /* True if both lists hold the same keys with the same scores in the same order. */
+    bool Same(const std::vector<KeyspaceCandidate>& a, const std::vector<KeyspaceCandidate>& b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); i++)
+            if (a[i].Index != b[i].Index || a[i].Score != b[i].Score)
+                return false;
+        return true;
+    }
+
+    /* True if the run throws. */
+    bool Throws(const Keyspace& space, const std::string& cipherText, const KeyspaceSearchOptions& options, ThreadPool& pool)
+    {
+        try
+        {
+            KeyspaceSearch::Run(space, cipherText, options, pool);
+        }
+        catch (const std::runtime_error&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Runs the search stopped every @step keys (the first time by Stop) and resumed until complete.
+     * Returns the final result, @runs is set to the number of runs.
+     */
+    KeyspaceSearchResult Interrupted(const Keyspace& space, const std::string& cipherText, KeyspaceSearchOptions options, uint64_t step,
+                                     ThreadPool& pool, int& runs)
+    {
+        std::remove(options.CheckpointPath.c_str());
+        std::atomic<bool> stop(true);
+        options.Stop = &stop;
+        KeyspaceSearchResult res = KeyspaceSearch::Run(space, cipherText, options, pool);
+        Check(!res.Complete && !res.Resumed && res.Checkpoints > 0, "run stopped by Stop writes a checkpoint");
+        options.Stop = nullptr;
+        options.MaxKeys = step;
+        for (runs = 1; !res.Complete && runs < 1000; runs++)
+        {
+            res = KeyspaceSearch::Run(space, cipherText, options, pool);
+            Check(res.Resumed, "run resumes from the checkpoint");
+        }
+        return res;
+    }
+
+    /* Checks resuming against an uninterrupted run with given options. */
+    void CheckResume(const char* mode, const Keyspace& space, const std::string& cipherText, KeyspaceSearchOptions options, uint64_t step,
+                     ThreadPool& pool)
+    {
+        KeyspaceSearchResult whole = KeyspaceSearch::Run(space, cipherText, options, pool);
+        Check(whole.Complete && whole.KeysDone == whole.KeysTotal, "uninterrupted run completes");
+
+        options.CheckpointPath = "KeyspaceSearchTest." + std::to_string(getpid()) + ".ckpt";
+        int runs = 0;
+        KeyspaceSearchResult resumed = Interrupted(space, cipherText, options, step, pool, runs);
+        Check(runs > 2, "search is stopped more than once");
+        Check(resumed.Complete && resumed.KeysDone == whole.KeysDone, "resumed search completes with every key done");
+        Check(Same(resumed.Candidates, whole.Candidates), "resumed search gives the top-K of the uninterrupted run");
+        std::printf("%s: %d runs, %llu keys, best score %.4f.\n", mode, runs, (unsigned long long)resumed.KeysDone,
+                    resumed.Candidates.empty() ? 0 : resumed.Candidates[0].Score);
+        std::remove(options.CheckpointPath.c_str());
+    }
+}
+
+int main()
+{
+    const UserSettings trueKey(B, {UserRotor(II, 'K', 'A'), UserRotor(I, 'D', 'A'), UserRotor(III, 'X', 'A')}, {});
+    Encoder encoder(trueKey);
+    const std::string cipherText = encoder.EncryptString(plainText);
+
+    KeyspaceOptions dims;
+    dims.Reflectors = {B};
+    dims.WheelOrders = {{{I, II, III}}, {{II, I, III}}, {{III, II, I}}};
+    const Keyspace space(dims);
+    ThreadPool pool;
+
+    KeyspaceSearchOptions options;
+    options.TopK = 10;
+    options.Shards = 16;
+    options.CheckpointSeconds = 0;
+    CheckResume("exhaustive", space, cipherText, options, 5000, pool);
+
+    KeyspaceSearchOptions sampling = options;
+    sampling.Samples = 30000;
+    sampling.Seed = 5;
+    CheckResume("sampling", space, cipherText, sampling, 3000, pool);
+
+    // A checkpoint of another search is rejected.
+    KeyspaceSearchOptions stopped = options;
+    stopped.CheckpointPath = "KeyspaceSearchTest." + std::to_string(getpid()) + ".other.ckpt";
+    stopped.MaxKeys = 5000;
+    std::remove(stopped.CheckpointPath.c_str());
+    KeyspaceSearch::Run(space, cipherText, stopped, pool);
+
+    KeyspaceSearchOptions otherSeed = sampling;
+    otherSeed.CheckpointPath = stopped.CheckpointPath;
+    Check(Throws(space, cipherText, otherSeed, pool), "checkpoint of other options is rejected");
+    Check(Throws(space, cipherText + "X", stopped, pool), "checkpoint of other ciphertext is rejected");
+
+    KeyspaceCheckpoint checkpoint = KeyspaceCheckpoint::Load(stopped.CheckpointPath);
+    Check(checkpoint.Fingerprint == KeyspaceSearch::Fingerprint(space, cipherText, stopped), "checkpoint holds the fingerprint of its search");
+    KeyspaceCheckpoint otherFingerprint = checkpoint;
+    otherFingerprint.Fingerprint ^= 1;
+    otherFingerprint.Save(stopped.CheckpointPath);
+    Check(Throws(space, cipherText, stopped, pool), "checkpoint with other fingerprint is rejected");
+
+    KeyspaceCheckpoint otherShards = checkpoint;
+    otherShards.Cursors.pop_back();
+    otherShards.RandomStates.pop_back();
+    otherShards.Save(stopped.CheckpointPath);
+    Check(Throws(space, cipherText, stopped, pool), "checkpoint with other number of shards is rejected");
+
+    checkpoint.Save(stopped.CheckpointPath);
+    Check(!Throws(space, cipherText, stopped, pool), "the unchanged checkpoint is accepted");
+    std::remove(stopped.CheckpointPath.c_str());
+
+    return Finish("KeyspaceSearchTest");
+}
@@ -0,0 +1,229 @@
+/**
+ * EnigmaCPP tests
+ * Wojciech Kieloch 2023
+*/
+
+/**
+ * Ring-class reduction of IocSearch (SearchRings) against a brute force of all 26^6 rotor positions
+ * and ring settings of one reflector and wheel order, on a short message encrypted by Encoder.
+ *
+ * Every brute-force key must decrypt the message exactly like its RingClasses representative,
+ * every representative the search enumerates must stand for some brute-force key, so both find the same
+ * set of keys: the keys decrypting to the known plaintext, and the best index of coincidence.
+*/
+
+#include "Check.h"
+
+#include "EnigmaCPP.h"
+#include "CompiledKey.h"
+#include "KeystreamTable.h"
+#include "RingClasses.h"
+#include "IocSearch.h"
+#include "ThreadPool.h"
+
+#include <set>
+#include <atomic>
+#include <memory>
+#include <array>
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdint>
+
+using namespace Enigma;
+
+namespace
+{
+    const int alphabetLength = CompiledKey::alphabetLength;
+
+    const ReflectorID reflector = B;
+    const std::array<RotorID, 3> order = {{II, IV, V}};
+    const std::string plainText = "WETTERVORHERSAGEBISKAYA";
+
+    /* True key, the right rotor turns the middle one over within the message. */
+    const UserSettings trueKey(reflector, {UserRotor(II, 'Q', 'F'), UserRotor(IV, 'H', 'T'), UserRotor(V, 'U', 'C')}, {});
+
+    /* Decryption of the text under one key: hash of the letters and their index of coincidence. */
+    struct Decryption
+    {
+        uint64_t Hash;
+        double Ioc;
+    };
+
+    /* Windows minus middle and right ring settings, for every state index of the windows. */
+    std::vector<uint16_t> CoreStates(int ringMiddle, int ringRight)
+    {
+        std::vector<uint16_t> core(KeystreamTable::numberOfStates);
+        for (int state = 0; state < KeystreamTable::numberOfStates; state++)
+            core[state] = (uint16_t)KeystreamTable::StateIndex({{state / 676, (state / 26 % 26 + alphabetLength - ringMiddle) % alphabetLength,
+                                                                  (state % 26 + alphabetLength - ringRight) % alphabetLength}});
+        return core;
+    }
+
+    /**
+     * Decrypts independently of the ring-class code: windows are stepped by the successor table of the key
+     * (rules of Encoder), the permutation is looked up by core offsets (window - ring) in a table built with rings AAA.
+     */
+    Decryption Decrypt(const KeystreamTable& table, const uint16_t* next, const uint16_t* core, int ringLeft, int windows,
+                       const std::vector<uint8_t>& text) noexcept
+    {
+        const int leftShift = ringLeft * 676;
+        uint64_t hash = 14695981039346656037ULL;
+        uint32_t counts[alphabetLength] = {0};
+        for (uint8_t letter : text)
+        {
+            windows = next[windows];
+            int state = core[windows] - leftShift;
+            if (state < 0)
+                state += KeystreamTable::numberOfStates;
+            uint8_t out = table.getPermutation(state)[letter];
+            counts[out]++;
+            hash = (hash ^ out) * 1099511628211ULL;
+        }
+        double sum = 0;
+        for (uint32_t count : counts)
+            sum += (double)count * ((double)count - 1);
+        return {hash, sum / ((double)text.size() * (text.size() - 1))};
+    }
+}
+
+int main()
+{
+    Encoder encoder(trueKey);
+    const std::string cipherText = encoder.EncryptString(plainText);
+    const std::vector<uint8_t> text = CompiledKey::ToIndices(cipherText);
+    const std::vector<uint8_t> plain = CompiledKey::ToIndices(plainText);
+
+    uint8_t plugboard[alphabetLength];
+    for (int i = 0; i < alphabetLength; i++)
+        plugboard[i] = (uint8_t)i;
+    const CompiledKey key(reflector, order, {{0, 0, 0}}, plugboard);
+    const KeystreamTable table{key};
+    const std::vector<uint16_t> next = table.NextStates();
+    const int* notches = key.getNotches();
+    const RingClasses classes(text.size());
+    const size_t numberOfClasses = classes.size();
+
+    // The brute-force decryption agrees with CompiledKey of real ring settings on random keys.
+    std::mt19937 random(7);
+    bool agrees = true;
+    for (int i = 0; i < 2000; i++)
+    {
+        std::array<int, 3> rings = {{(int)(random() % 26), (int)(random() % 26), (int)(random() % 26)}};
+        RotorPositions windows = {{(int)(random() % 26), (int)(random() % 26), (int)(random() % 26)}};
+        CompiledKey ringed(reflector, order, rings, plugboard);
+        std::vector<uint8_t> out(text.size());
+        RotorPositions stepped = windows;
+        ringed.EncryptIndices(text.data(), out.data(), text.size(), stepped);
+        uint64_t hash = 14695981039346656037ULL;
+        for (uint8_t letter : out)
+            hash = (hash ^ letter) * 1099511628211ULL;
+        agrees = agrees && hash == Decrypt(table, next.data(), CoreStates(rings[1], rings[2]).data(), rings[0], KeystreamTable::StateIndex(windows), text).Hash;
+    }
+    Check(agrees, "brute-force decryption agrees with CompiledKey");
+
+    uint64_t plainHash = 14695981039346656037ULL;
+    for (uint8_t letter : plain)
+        plainHash = (plainHash ^ letter) * 1099511628211ULL;
+
+    // Keys of the ring-class enumeration, in the order of IocSearch: rings (A, middle, right), class, left window.
+    auto indexOf = [&](int ringMiddle, int ringRight, int cls, int left) {
+        return (((size_t)ringMiddle * alphabetLength + ringRight) * numberOfClasses + cls) * alphabetLength + left;
+    };
+    std::vector<Decryption> representatives(alphabetLength * alphabetLength * numberOfClasses * alphabetLength);
+    std::set<size_t> classMatches;
+    double classBest = 0;
+    for (int ringMiddle = 0; ringMiddle < alphabetLength; ringMiddle++)
+        for (int ringRight = 0; ringRight < alphabetLength; ringRight++)
+        {
+            std::vector<uint16_t> core = CoreStates(ringMiddle, ringRight);
+            for (size_t cls = 0; cls < numberOfClasses; cls++)
+            {
+                const std::array<int, 2>& rep = classes.getRepresentatives()[cls];
+                int middle = (notches[1] - rep[1] + alphabetLength) % alphabetLength, right = (notches[2] - rep[0] + alphabetLength) % alphabetLength;
+                for (int left = 0; left < alphabetLength; left++)
+                {
+                    size_t index = indexOf(ringMiddle, ringRight, (int)cls, left);
+                    representatives[index] = Decrypt(table, next.data(), core.data(), 0, KeystreamTable::StateIndex({{left, middle, right}}), text);
+                    if (representatives[index].Hash == plainHash)
+                        classMatches.insert(index);
+                    classBest = std::max(classBest, representatives[index].Ioc);
+                }
+            }
+        }
+
+    // Every one of the 26^6 keys against its representative, on all threads.
+    ThreadPool pool;
+    std::unique_ptr<std::atomic<bool>[]> reached(new std::atomic<bool>[representatives.size()]());
+    const size_t tasks = alphabetLength * alphabetLength;
+    std::vector<std::set<size_t>> bruteMatches(tasks);
+    std::vector<double> bruteBest(tasks, 0);
+    std::vector<uint64_t> mismatches(tasks, 0), notRepresentative(tasks, 0);
+    pool.ParallelFor(tasks, [&](size_t t) {
+        const int ringMiddle = (int)t / alphabetLength, ringRight = (int)t % alphabetLength;
+        std::vector<uint16_t> core = CoreStates(ringMiddle, ringRight);
+        for (int ringLeft = 0; ringLeft < alphabetLength; ringLeft++)
+            for (int state = 0; state < KeystreamTable::numberOfStates; state++)
+            {
+                Decryption decryption = Decrypt(table, next.data(), core.data(), ringLeft, state, text);
+
+                std::array<int, 3> rings = {{ringLeft, ringMiddle, ringRight}};
+                RotorPositions windows = {{state / 676, state / 26 % 26, state % 26}};
+                classes.Canonicalize(notches, windows, rings);
+                int rightDistance = RingClasses::Distance(notches[2], windows[2]), middleDistance = RingClasses::Distance(notches[1], windows[1]);
+                if (rings[0] != 0 || !classes.isRepresentative(rightDistance, middleDistance))
+                {
+                    notRepresentative[t]++;
+                    continue;
+                }
+                size_t index = indexOf(rings[1], rings[2], classes.ClassOf(rightDistance, middleDistance), windows[0]);
+                reached[index].store(true, std::memory_order_relaxed);
+                if (representatives[index].Hash != decryption.Hash)
+                    mismatches[t]++;
+                if (decryption.Hash == plainHash)
+                    bruteMatches[t].insert(index);
+                bruteBest[t] = std::max(bruteBest[t], decryption.Ioc);
+            }
+    });
+
+    uint64_t totalMismatches = 0, totalNotRepresentative = 0, unreached = 0;
+    std::set<size_t> matches;
+    double best = 0;
+    for (size_t t = 0; t < tasks; t++)
+    {
+        totalMismatches += mismatches[t];
+        totalNotRepresentative += notRepresentative[t];
+        matches.insert(bruteMatches[t].begin(), bruteMatches[t].end());
+        best = std::max(best, bruteBest[t]);
+    }
+    for (size_t index = 0; index < representatives.size(); index++)
+        unreached += !reached[index].load();
+    Check(totalNotRepresentative == 0, "every key canonicalizes to an enumerated representative");
+    Check(totalMismatches == 0, "every key decrypts like its representative");
+    Check(unreached == 0, "every enumerated representative stands for a brute-force key");
+    Check(!matches.empty() && matches == classMatches, "brute force and ring classes find the same keys decrypting to the plaintext");
+    Check(best == classBest, "brute force and ring classes find the same best index of coincidence");
+
+    // The true key is among them.
+    RotorPositions trueWindows = CompiledKey::PositionsOf(trueKey);
+    std::array<int, 3> trueRings = {{'F' - 'A', 'T' - 'A', 'C' - 'A'}};
+    classes.Canonicalize(notches, trueWindows, trueRings);
+    int trueClass = classes.ClassOf(RingClasses::Distance(notches[2], trueWindows[2]), RingClasses::Distance(notches[1], trueWindows[1]));
+    Check(classMatches.count(indexOf(trueRings[1], trueRings[2], trueClass, trueWindows[0])) == 1, "true key is found");
+
+    // IocSearch itself, restricted to the wheel order, without early abort.
+    IocSearchOptions options;
+    options.TopK = 1;
+    options.Reflectors = {reflector};
+    options.WheelOrders = {order};
+    options.SearchRings = true;
+    options.AbortDeviations = 0;
+    IocSearchResult res = IocSearch::Run(cipherText, options, pool);
+    Check(res.KeysTested == representatives.size(), "IocSearch tests every representative once");
+    Check(res.KeysCovered == (uint64_t)KeystreamTable::numberOfStates * RingClasses::settingsPerOffset, "IocSearch covers all 26^6 keys");
+    Check(!res.Candidates.empty() && res.Candidates[0].Score == best, "IocSearch finds the brute-force best index of coincidence");
+
+    std::printf("%zu letters, %zu ring classes, %zu representatives, %zu keys decrypting to the plaintext.\n", text.size(), numberOfClasses,
+                representatives.size(), matches.size());
+    return Finish("RingClassesTest");
+}